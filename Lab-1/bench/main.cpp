@@ -0,0 +1,1187 @@
+#include <iostream>
+#include <iomanip>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <set>
+#include <utility>
+#include <thread>
+#include <cstdio>
+#include <cmath>
+#include <fstream>
+#include <memory_resource>
+
+#include "utils.h"
+#include "rasterization.h"
+#include "chunk_allocator.h"
+#include "primitive.h"
+#include "occupancy.h"
+#include "primitive_grid.h"
+#include "heap_stats.h"
+#include "arena.h"
+
+// Pixel throughput of the line rasterizers, no window or GL context is needed.
+// Every length is drawn in all eight octants from a fixed seed, so runs are comparable.
+//   rasterization-bench                  all the tables and the exhaustive checks
+//   rasterization-bench --check          only compares the rasterizers with the golden images
+//   rasterization-bench --write-golden   writes the golden images again after an intended change
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr size_t LINES_PER_LENGTH = 256;
+static constexpr size_t PIXELS_PER_RUN = 1 << 24;
+
+struct Line {
+    Pixel start, end;
+};
+
+// the minor axis delta is below length / minor_divisor, and only x is the major axis when that is above 1
+static std::vector<Line> make_lines(int length, uint32_t seed, int minor_divisor = 1) {
+    std::vector<Line> lines;
+    for (size_t i = 0; i < LINES_PER_LENGTH; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        auto minor_range = static_cast<uint32_t>(std::max(length / minor_divisor, 1));
+        int minor = static_cast<int>((seed >> 8) % minor_range);
+        int octant = static_cast<int>(i % 8) & (minor_divisor > 1 ? ~1 : ~0);
+        int dx = (octant & 1) ? minor : length - 1;
+        int dy = (octant & 1) ? length - 1 : minor;
+        dx = (octant & 2) ? -dx : dx;
+        dy = (octant & 4) ? -dy : dy;
+        Pixel start(4096, 4096);
+        lines.push_back({start, Pixel(start.x + dx, start.y + dy)});
+    }
+    return lines;
+}
+
+// returns pixels per second, out keeps the pixels of the last line so the work isn't optimized away
+template<typename DRAW>
+static double measure(const std::vector<Line>& lines, size_t pixels_per_pass, DRAW&& draw) {
+    size_t passes = PIXELS_PER_RUN / pixels_per_pass + 1;
+    auto start = Clock::now();
+    for (size_t p = 0; p < passes; ++p) {
+        for (const auto& line : lines) {
+            draw(line);
+        }
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return static_cast<double>(passes * pixels_per_pass) / seconds;
+}
+
+// Reference ellipse, every midpoint decision evaluated from scratch instead of incrementally.
+// Returns the pixels of all four quadrants.
+static std::set<std::pair<int, int>> reference_ellipse(int a, int b) {
+    std::set<std::pair<int, int>> quadrant;
+    int64_t a2 = static_cast<int64_t>(a) * a;
+    int64_t b2 = static_cast<int64_t>(b) * b;
+    // 4 f(X / 2, Y / 2), f(x, y) = b^2 x^2 + a^2 y^2 - a^2 b^2
+    auto f = [&](int64_t X, int64_t Y) { return b2 * X * X + a2 * Y * Y - 4 * a2 * b2; };
+    if (b == 0) {
+        for (int x = 0; x <= a; ++x) {
+            quadrant.insert({x, 0});
+        }
+    } else {
+        int64_t x = 0, y = b;
+        while (2 * b2 * (x + 1) < a2 * (2 * y - 1)) {
+            quadrant.insert({static_cast<int>(x), static_cast<int>(y)});
+            if (f(2 * x + 2, 2 * y - 1) >= 0) {
+                y--;
+            }
+            x++;
+        }
+        while (y >= 0) {
+            quadrant.insert({static_cast<int>(x), static_cast<int>(y)});
+            if (f(2 * x + 1, 2 * y - 2) <= 0) {
+                x++;
+            }
+            y--;
+        }
+        for (int tip = 0; tip <= a; ++tip) {
+            if (quadrant.count({tip, 0}) == 0 && tip > 0 && quadrant.count({tip - 1, 0})) {
+                quadrant.insert({tip, 0});
+            }
+        }
+    }
+    std::set<std::pair<int, int>> all;
+    for (const auto& p : quadrant) {
+        all.insert({p.first, p.second});
+        all.insert({-p.first, p.second});
+        all.insert({p.first, -p.second});
+        all.insert({-p.first, -p.second});
+    }
+    return all;
+}
+
+// outline pixels and spans against the reference, and the filled rows against the outline extents
+static bool check_ellipse(int a, int b) {
+    Pixel center(0, 0), corner(a, b);
+    auto expected = reference_ellipse(a, b);
+
+    std::vector<Pixel> pixels;
+    draw_ellipse(center, corner, pixels);
+    std::set<std::pair<int, int>> outline;
+    for (const auto& p : pixels) {
+        outline.insert({p.x, p.y});
+    }
+    std::vector<Span> spans;
+    draw_ellipse_spans(center, corner, spans);
+    std::set<std::pair<int, int>> outline_spans;
+    size_t span_pixels = 0;
+    for (const auto& span : spans) {
+        for (int x = span.x_begin; x < span.x_end; ++x) {
+            outline_spans.insert({x, span.y});
+        }
+        span_pixels += span.length();
+    }
+
+    spans.clear();
+    fill_ellipse_spans(center, corner, spans);
+    bool filled_ok = spans.size() == static_cast<size_t>(2 * b + 1);
+    for (const auto& span : spans) {
+        int extent = 0;
+        for (const auto& p : outline) {
+            if (p.second == span.y) {
+                extent = std::max(extent, p.first);
+            }
+        }
+        filled_ok = filled_ok && span.x_begin == -extent && span.x_end == extent + 1;
+    }
+
+    bool ok = outline == expected && pixels.size() == expected.size()
+              && outline_spans == expected && span_pixels == expected.size() && filled_ok;
+    if (!ok) {
+        std::cerr << "[E] ellipse " << a << "x" << b << " differs from the reference" << std::endl;
+    }
+    return ok;
+}
+
+template<typename T>
+static std::set<std::pair<int, int>> covered(const std::vector<T>& items);
+
+template<>
+std::set<std::pair<int, int>> covered(const std::vector<Pixel>& pixels) {
+    std::set<std::pair<int, int>> set;
+    for (const auto& p : pixels) {
+        set.insert({p.x, p.y});
+    }
+    return set;
+}
+
+template<>
+std::set<std::pair<int, int>> covered(const std::vector<Span>& spans) {
+    std::set<std::pair<int, int>> set;
+    for (const auto& span : spans) {
+        for (int x = span.x_begin; x < span.x_end; ++x) {
+            set.insert({x, span.y});
+        }
+    }
+    return set;
+}
+
+// the clipped rasterizers against the unclipped ones with the pixels outside the rectangle dropped
+static bool check_clipping(Pixel start, Pixel end, const ClipRect& clip) {
+    auto inside = [&](std::vector<Pixel> pixels) {
+        pixels.erase(std::remove_if(pixels.begin(), pixels.end(), [&](const Pixel& p) { return !clip.contains(p); }),
+                     pixels.end());
+        return pixels;
+    };
+    auto inside_spans = [&](const std::vector<Span>& spans) {
+        auto set = covered(spans);
+        for (auto it = set.begin(); it != set.end(); ) {
+            it = clip.contains(Pixel(it->first, it->second)) ? std::next(it) : set.erase(it);
+        }
+        return set;
+    };
+
+    std::vector<Pixel> full, clipped;
+    std::vector<Span> full_spans, clipped_spans;
+    bool ok = true;
+
+    draw_line_bresenham(start, end, full);
+    draw_line_bresenham(start, end, clipped, clip);
+    ok = ok && clipped == inside(full) && line_pixel_count(start, end, clip) == clipped.size();
+    draw_line_spans(start, end, full_spans);
+    draw_line_spans(start, end, clipped_spans, clip);
+    ok = ok && covered(clipped_spans) == inside_spans(full_spans);
+
+    full.clear();
+    clipped.clear();
+    draw_line_dda(start, end, full);
+    draw_line_dda(start, end, clipped, clip);
+    ok = ok && clipped == inside(full);
+
+    full.clear();
+    clipped.clear();
+    draw_ellipse(start, end, full);
+    draw_ellipse(start, end, clipped, clip);
+    ok = ok && covered(clipped) == covered(inside(full)) && clipped.size() == inside(full).size();
+    full_spans.clear();
+    clipped_spans.clear();
+    draw_ellipse_spans(start, end, full_spans);
+    draw_ellipse_spans(start, end, clipped_spans, clip);
+    ok = ok && covered(clipped_spans) == inside_spans(full_spans);
+    // one span per row, cut to clip span by span so a huge filled ellipse stays cheap to check
+    full_spans.clear();
+    clipped_spans.clear();
+    fill_ellipse_spans(start, end, full_spans);
+    fill_ellipse_spans(start, end, clipped_spans, clip);
+    std::vector<Span> cut;
+    for (const auto& span : full_spans) {
+        int x0 = std::max(span.x_begin, 0), x1 = std::min(span.x_end, clip.width);
+        if (span.y >= 0 && span.y < clip.height && x0 < x1) {
+            cut.emplace_back(span.y, x0, x1);
+        }
+    }
+    ok = ok && clipped_spans == cut;
+
+    if (!ok) {
+        std::cerr << "[E] clipping (" << start.x << ", " << start.y << ") - (" << end.x << ", " << end.y
+                  << ") to " << clip.width << "x" << clip.height << " differs from the unclipped pixels" << std::endl;
+    }
+    return ok;
+}
+
+// microseconds per call
+template<typename DRAW>
+static double time_us(size_t calls, DRAW&& draw) {
+    auto start = Clock::now();
+    for (size_t i = 0; i < calls; ++i) {
+        draw();
+    }
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count() / static_cast<double>(calls);
+}
+
+// The chunked vertex store at 10M points with a CPU copy of the chunks standing in for the buffers:
+// the append rate, the per frame cost of the draw ranges, and compaction after erasing 60% of the
+// strokes, checking every stroke still reads back its own vertices.
+static bool bench_vertex_store() {
+    const uint32_t CHUNK = 1 << 16;
+    const uint32_t STROKE = 1000;
+    const uint32_t STROKES = 10000;
+    ChunkAllocator allocator(CHUNK);
+    std::vector<std::vector<uint32_t>> gpu; // per chunk slot, a vertex is the id of its stroke
+    std::vector<ChunkAllocator::Piece> pieces;
+    std::vector<uint32_t> handles;
+
+    auto start = Clock::now();
+    for (uint32_t i = 0; i < STROKES; ++i) {
+        pieces.clear();
+        handles.push_back(allocator.allocate(STROKE, pieces));
+        gpu.resize(allocator.chunk_slots());
+        for (const auto& piece : pieces) {
+            gpu[piece.chunk].resize(CHUNK);
+            std::fill_n(gpu[piece.chunk].begin() + piece.first, piece.count, i);
+        }
+    }
+    double append_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    // one frame walks the draw ranges of every chunk, rebuilt only after a change
+    auto frame = [&] {
+        size_t ranges = 0;
+        for (uint32_t c = 0; c < allocator.chunk_slots(); ++c) {
+            if (allocator.chunk_active(c)) {
+                ranges += allocator.firsts(c).size() + allocator.counts(c).size();
+            }
+        }
+        return ranges;
+    };
+    size_t sink = frame();
+    double frame_us = time_us(1000, [&] { sink += frame(); });
+
+    uint32_t seed = 36;
+    std::vector<bool> live(STROKES, true);
+    for (uint32_t i = 0; i < STROKES; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        if ((seed >> 8) % 10 < 6) {
+            allocator.free(handles[i]);
+            live[i] = false;
+        }
+    }
+    size_t chunks_before = allocator.active_chunks();
+    double rebuild_us = time_us(1, [&] { sink += frame(); });
+
+    std::vector<ChunkAllocator::Move> moves;
+    size_t calls = 0;
+    uint64_t moved = 0;
+    start = Clock::now();
+    for (;;) {
+        moves.clear();
+        auto n = allocator.compact(1 << 16, moves);
+        if (n == 0 && moves.empty()) {
+            break;
+        }
+        gpu.resize(allocator.chunk_slots());
+        for (const auto& move : moves) {
+            gpu[move.dst_chunk].resize(CHUNK);
+            std::copy_n(gpu[move.src_chunk].begin() + move.src_first, move.count, gpu[move.dst_chunk].begin() + move.dst_first);
+        }
+        moved += n;
+        calls++;
+    }
+    double compact_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    // every live stroke reads back its id, and the draw ranges cover exactly the live vertices
+    bool ok = allocator.live_vertices() == static_cast<uint64_t>(std::count(live.begin(), live.end(), true)) * STROKE;
+    for (uint32_t i = 0; i < STROKES && ok; ++i) {
+        if (!live[i]) {
+            continue;
+        }
+        uint32_t total = 0;
+        for (const auto& piece : allocator.pieces(handles[i])) {
+            ok = ok && allocator.chunk_active(piece.chunk);
+            for (uint32_t v = 0; v < piece.count && ok; ++v) {
+                ok = gpu[piece.chunk][piece.first + v] == i;
+            }
+            total += piece.count;
+        }
+        ok = ok && total == STROKE;
+    }
+    uint64_t drawn = 0;
+    for (uint32_t c = 0; c < allocator.chunk_slots(); ++c) {
+        if (allocator.chunk_active(c)) {
+            for (auto count : allocator.counts(c)) {
+                drawn += count;
+            }
+        }
+    }
+    ok = ok && drawn == allocator.live_vertices();
+    if (!ok) {
+        std::cerr << "[E] the vertex store lost vertices during compaction" << std::endl;
+        return false;
+    }
+
+    std::cout << std::endl << "vertex store, " << STROKES * STROKE / 1000000 << "M points in strokes of " << STROKE
+              << ", chunks of " << CHUNK << " vertices" << std::endl;
+    std::cout << "  append " << std::fixed << std::setprecision(2) << append_ms << " ms, "
+              << chunks_before << " chunks" << std::endl;
+    std::cout << "  draw ranges per frame " << frame_us << " us, " << rebuild_us << " us after erasing 60%" << std::endl;
+    std::cout << "  compaction moved " << moved << " vertices in " << calls << " frames of 65536, "
+              << compact_ms << " ms in total, " << allocator.active_chunks() << " chunks left" << std::endl;
+
+    // A rebuild clears the store and appends the drawing again: the kept chunks are filled before
+    // any new one starts, and the ones left unused go at the next compaction.
+    size_t chunks_kept = allocator.active_chunks();
+    for (size_t fill : {chunks_kept / 2, chunks_kept + 3}) {
+        allocator.clear();
+        uint64_t vertices = 0;
+        while (vertices < fill * CHUNK) {
+            pieces.clear();
+            allocator.allocate(STROKE, pieces);
+            vertices += STROKE;
+        }
+        size_t needed = static_cast<size_t>((vertices + CHUNK - 1) / CHUNK);
+        ok = allocator.active_chunks() == std::max(needed, chunks_kept);
+        moves.clear();
+        allocator.compact(1 << 16, moves);
+        ok = ok && moves.empty() && allocator.active_chunks() == needed;
+        if (!ok) {
+            std::cerr << "[E] the vertex store has " << allocator.active_chunks() << " chunks for " << needed
+                      << " chunks of vertices after a clear" << std::endl;
+            return false;
+        }
+        chunks_kept = needed;
+    }
+    return sink != 0;
+}
+
+// Re-rasterizing a saved drawing of 1M primitives for a 1920x1080 window, as on a resize,
+// by thread count; and the binary save/load round trip of it.
+// lines of up to 100 pixels and ellipses up to 20 over 1920x1080, half of them as spans
+static std::vector<Primitive> random_primitives(size_t count, uint32_t seed) {
+    std::vector<Primitive> primitives;
+    auto next = [&](uint32_t range) {
+        seed = seed * 1664525u + 1013904223u;
+        return static_cast<int>((seed >> 8) % range);
+    };
+    for (size_t i = 0; i < count; ++i) {
+        Primitive primitive;
+        int kind = next(8);
+        primitive.type = kind < 3 ? PrimitiveType::line_bresenham : kind < 5 ? PrimitiveType::line_dda
+                       : kind < 7 ? PrimitiveType::ellipse : PrimitiveType::filled_ellipse;
+        primitive.flags = next(2) ? Primitive::SPANS : 0;
+        primitive.start = Pixel(next(1920), next(1080));
+        int reach = primitive.type == PrimitiveType::line_bresenham || primitive.type == PrimitiveType::line_dda ? 100 : 20;
+        primitive.end = Pixel(primitive.start.x + next(2 * reach + 1) - reach, primitive.start.y + next(2 * reach + 1) - reach);
+        primitives.push_back(primitive);
+    }
+    return primitives;
+}
+
+static bool bench_primitives() {
+    auto primitives = random_primitives(1000000, 38);
+
+    std::cout << std::endl << "re-rasterizing 1M primitives for 1920x1080" << std::endl;
+    std::cout << std::setw(8) << "threads" << std::setw(10) << "ms" << std::setw(12) << "points" << std::setw(12) << "lines" << std::endl;
+    unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    std::pmr::vector<Vector2f> reference_points, reference_lines;
+    std::vector<uint32_t> reference_ends;
+    for (unsigned threads = 1; ; threads = std::min(threads * 2, hardware)) {
+        std::pmr::vector<Vector2f> points, lines;
+        std::vector<uint32_t> point_ends, line_ends;
+        auto start = Clock::now();
+        rasterize_parallel(primitives, 1920, 1080, 1.0f, points, lines, threads, nullptr, &point_ends, &line_ends);
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        std::cout << std::setw(8) << threads << std::setw(10) << std::fixed << std::setprecision(1) << ms
+                  << std::setw(12) << points.size() << std::setw(12) << lines.size() << std::endl;
+        // the order of the primitives is kept whatever the thread count
+        point_ends.insert(point_ends.end(), line_ends.begin(), line_ends.end());
+        if (threads == 1) {
+            reference_points = std::move(points);
+            reference_lines = std::move(lines);
+            reference_ends = std::move(point_ends);
+        } else if (points.size() != reference_points.size() || lines.size() != reference_lines.size() || point_ends != reference_ends ||
+                   !std::equal(points.begin(), points.end(), reference_points.begin(), [](const Vector2f& a, const Vector2f& b) { return a.x == b.x && a.y == b.y; })) {
+            std::cerr << "[E] the parallel rasterization differs from the serial one" << std::endl;
+            return false;
+        }
+        if (threads == hardware) {
+            break;
+        }
+    }
+
+    // span output covers the same pixels as point output with at most as many vertices
+    std::vector<Pixel> pixels, span_pixels;
+    std::vector<Span> spans;
+    uint64_t point_vertices = 0, span_vertices = 0;
+    for (size_t i = 0; i < 100000; ++i) {
+        auto primitive = primitives[i];
+        primitive.flags = 0;
+        rasterize_pixels(primitive, 1920, 1080, 1.0f, pixels, spans);
+        point_vertices += pixels.size();
+        span_pixels = pixels;
+        primitive.flags = Primitive::SPANS;
+        rasterize_pixels(primitive, 1920, 1080, 1.0f, pixels, spans);
+        size_t vertices = pixels.size() + 2 * spans.size();
+        span_vertices += vertices;
+        for (const auto& span : spans) {
+            for (int x = span.x_begin; x < span.x_end; ++x) {
+                pixels.emplace_back(x, span.y);
+            }
+        }
+        auto order = [](const Pixel& a, const Pixel& b) { return a.y != b.y ? a.y < b.y : a.x < b.x; };
+        std::sort(pixels.begin(), pixels.end(), order);
+        std::sort(span_pixels.begin(), span_pixels.end(), order);
+        if (pixels != span_pixels || vertices > span_pixels.size()) {
+            std::cerr << "[E] span output of primitive " << i << " doesn't match its points" << std::endl;
+            return false;
+        }
+    }
+    std::cout << "  span output of 100k of them: " << std::setprecision(2)
+              << static_cast<double>(span_vertices) / static_cast<double>(point_vertices) << " of the point vertices" << std::endl;
+
+    std::string path = "bench_primitives.mdpr";
+    std::vector<Primitive> loaded;
+    auto start = Clock::now();
+    bool ok = save_primitives(path, primitives);
+    double save_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    start = Clock::now();
+    ok = ok && load_primitives(path, loaded);
+    double load_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    std::remove(path.c_str());
+    ok = ok && loaded.size() == primitives.size();
+    for (size_t i = 0; ok && i < loaded.size(); ++i) {
+        ok = loaded[i].type == primitives[i].type && loaded[i].flags == primitives[i].flags &&
+             loaded[i].start == primitives[i].start && loaded[i].end == primitives[i].end;
+    }
+    if (!ok) {
+        std::cerr << "[E] the saved primitives don't load back" << std::endl;
+        return false;
+    }
+    std::cout << "  save " << std::fixed << std::setprecision(1) << save_ms << " ms, load " << load_ms << " ms, "
+              << 16 + primitives.size() * 18 << " bytes" << std::endl;
+    return true;
+}
+
+// Upload volume of a scribbling session, strokes committed one by one over a small area like the
+// viewer does, with and without the occupancy filter. The window is 512x512 so the NDC vertices map
+// back to pixels exactly; the filtered strokes must cover the same pixels, each exactly once.
+static void count_coverage(const std::pmr::vector<Vector2f>& points, const std::pmr::vector<Vector2f>& lines,
+                           int size, std::vector<uint8_t>& counts) {
+    counts.assign(static_cast<size_t>(size) * size, 0);
+    // points and span ends are both at pixel centers
+    auto to_pixel = [size](float v) { return static_cast<int>(std::lround((v + 1.0f) / 2 * size - 0.5f)); };
+    for (const auto& v : points) {
+        int x = to_pixel(v.x), y = to_pixel(-v.y);
+        counts[y * size + x] = static_cast<uint8_t>(std::min(counts[y * size + x] + 1, 255));
+    }
+    for (size_t i = 0; i + 1 < lines.size(); i += 2) {
+        int y = to_pixel(-lines[i].y);
+        for (int x = to_pixel(lines[i].x); x < to_pixel(lines[i + 1].x); ++x) {
+            counts[y * size + x] = static_cast<uint8_t>(std::min(counts[y * size + x] + 1, 255));
+        }
+    }
+}
+
+// mostly lines going back and forth over a 200x150 patch, some ellipses, a few fills
+static std::vector<Primitive> scribble(size_t count, uint32_t seed) {
+    std::vector<Primitive> strokes;
+    auto next = [&](uint32_t range) {
+        seed = seed * 1664525u + 1013904223u;
+        return static_cast<int>((seed >> 8) % range);
+    };
+    for (size_t i = 0; i < count; ++i) {
+        Primitive primitive;
+        int kind = next(16);
+        primitive.type = kind < 7 ? PrimitiveType::line_bresenham : kind < 12 ? PrimitiveType::line_dda
+                       : kind < 15 ? PrimitiveType::ellipse : PrimitiveType::filled_ellipse;
+        primitive.flags = next(2) ? Primitive::SPANS : 0;
+        primitive.start = Pixel(150 + next(200), 180 + next(150));
+        int reach = primitive.type == PrimitiveType::line_bresenham || primitive.type == PrimitiveType::line_dda ? 120 : 30;
+        primitive.end = Pixel(primitive.start.x + next(2 * reach + 1) - reach, primitive.start.y + next(2 * reach + 1) - reach);
+        strokes.push_back(primitive);
+    }
+    return strokes;
+}
+
+static bool bench_occupancy() {
+    const int size = 512;
+    auto strokes = scribble(20000, 41);
+
+    std::cout << std::endl << "uploads of 20000 overlapping strokes, " << size << "x" << size << std::endl;
+    std::cout << std::setw(10) << "filter" << std::setw(10) << "ms" << std::setw(12) << "points"
+              << std::setw(12) << "lines" << std::setw(10) << "MB" << std::setw(12) << "max/pixel" << std::endl;
+    std::vector<uint8_t> reference, counts;
+    OccupancyBitmap occupancy(size, size);
+    for (int filtered = 0; filtered < 2; ++filtered) {
+        std::pmr::vector<Vector2f> points, lines;
+        auto start = Clock::now();
+        for (const auto& stroke : strokes) {
+            rasterize(stroke, size, size, 1.0f, points, lines, filtered ? &occupancy : nullptr);
+        }
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        count_coverage(points, lines, size, counts);
+        uint8_t most = *std::max_element(counts.begin(), counts.end());
+        std::cout << std::setw(10) << (filtered ? "on" : "off") << std::setw(10) << std::fixed << std::setprecision(1) << ms
+                  << std::setw(12) << points.size() << std::setw(12) << lines.size()
+                  << std::setw(10) << std::setprecision(2) << static_cast<double>((points.size() + lines.size()) * sizeof(Vector2f)) / (1 << 20)
+                  << std::setw(12) << static_cast<int>(most) << std::endl;
+        if (!filtered) {
+            reference = counts;
+            continue;
+        }
+        for (size_t i = 0; i < counts.size(); ++i) {
+            if (counts[i] > 1 || (counts[i] != 0) != (reference[i] != 0)) {
+                std::cerr << "[E] the filtered strokes cover other pixels than the unfiltered ones at ("
+                          << i % size << ", " << i / size << ")" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    // the filter on its own: a whole row of spans, set and tested a word at a time
+    std::vector<Span> spans;
+    size_t calls = 20000;
+    double us = time_us(calls, [&] {
+        occupancy.clear();
+        spans.clear();
+        for (int y = 0; y < size; y += 4) {
+            spans.emplace_back(y, 3, size - 3);
+        }
+        occupancy.filter(spans);
+    });
+    std::cout << "  filtering " << size / 4 << " spans of " << size - 6 << " pixels with a clear: "
+              << std::setprecision(2) << us << " us" << std::endl;
+    return true;
+}
+
+// The grid behind the select and erase tools over 1M primitives: point picks and rectangle
+// selections against a linear scan, and erasing. Then erasing with covered pixels skipped, the way
+// the viewer patches the primitives under an erased one, must leave the coverage of the rest.
+static bool bench_grid() {
+    auto primitives = random_primitives(1000000, 42);
+    PrimitiveGrid grid;
+    auto start = Clock::now();
+    for (size_t i = 0; i < primitives.size(); ++i) {
+        grid.insert(static_cast<uint32_t>(i), bounds(primitives[i]));
+    }
+    double insert_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    std::vector<bool> live(primitives.size(), true);
+
+    uint32_t seed = 42;
+    auto next = [&](uint32_t range) {
+        seed = seed * 1664525u + 1013904223u;
+        return static_cast<int>((seed >> 8) % range);
+    };
+    const float radius = 4.0f;
+    auto pick_area = [&](float x, float y) {
+        return Bounds{static_cast<int>(std::floor(x - radius)) - 1, static_cast<int>(std::floor(y - radius)) - 1,
+                      static_cast<int>(std::ceil(x + radius)) + 1, static_cast<int>(std::ceil(y + radius)) + 1};
+    };
+    auto pick = [&](float x, float y, std::pmr::vector<uint32_t>& ids) {
+        ids.clear();
+        grid.query(pick_area(x, y), ids);
+        ids.erase(std::remove_if(ids.begin(), ids.end(), [&](uint32_t id) {
+            return !hit_test(primitives[id], x, y, radius);
+        }), ids.end());
+        std::sort(ids.begin(), ids.end());
+    };
+    auto select = [&](const Bounds& area, std::pmr::vector<uint32_t>& ids) {
+        ids.clear();
+        grid.query(area, ids);
+        ids.erase(std::remove_if(ids.begin(), ids.end(), [&](uint32_t id) {
+            return !intersects(primitives[id], area);
+        }), ids.end());
+        std::sort(ids.begin(), ids.end());
+    };
+    auto random_area = [&](int extent) {
+        int x = next(1920 - extent), y = next(1080 - extent);
+        return Bounds{x, y, x + next(extent) + 1, y + next(extent) + 1};
+    };
+    // a few of each against every primitive
+    auto check = [&](const char *when) {
+        std::pmr::vector<uint32_t> ids, expected;
+        for (int i = 0; i < 10; ++i) {
+            float x = static_cast<float>(next(19200)) / 10, y = static_cast<float>(next(10800)) / 10;
+            auto area = random_area(200);
+            pick(x, y, ids);
+            expected.clear();
+            for (uint32_t id = 0; id < primitives.size(); ++id) {
+                if (live[id] && hit_test(primitives[id], x, y, radius)) {
+                    expected.push_back(id);
+                }
+            }
+            bool same = ids == expected;
+            select(area, ids);
+            expected.clear();
+            for (uint32_t id = 0; id < primitives.size(); ++id) {
+                if (live[id] && intersects(primitives[id], area)) {
+                    expected.push_back(id);
+                }
+            }
+            if (!same || ids != expected) {
+                std::cerr << "[E] the grid misses or repeats primitives " << when << std::endl;
+                return false;
+            }
+        }
+        return true;
+    };
+    if (!check("after inserting")) {
+        return false;
+    }
+
+    std::cout << std::endl << "grid over 1M primitives, " << grid.cell_count() << " cells of "
+              << PrimitiveGrid::CELL_SIZE << " pixels, built in " << std::fixed << std::setprecision(1) << insert_ms << " ms" << std::endl;
+    std::pmr::vector<uint32_t> ids;
+    size_t found = 0;
+    double pick_us = time_us(10000, [&] {
+        pick(static_cast<float>(next(19200)) / 10, static_cast<float>(next(10800)) / 10, ids);
+        found += ids.size();
+    });
+    std::cout << "  pick within " << radius << " pixels: " << std::setprecision(2) << pick_us << " us, "
+              << static_cast<double>(found) / 10000 << " hits" << std::endl;
+    for (int extent : {64, 256, 1024}) {
+        found = 0;
+        size_t calls = 256 * 1024 / extent;
+        double select_us = time_us(calls, [&] {
+            select(random_area(extent), ids);
+            found += ids.size();
+        });
+        std::cout << "  select up to " << extent << "x" << extent << ": " << select_us << " us, "
+                  << found / calls << " selected" << std::endl;
+    }
+    auto full_start = Clock::now();
+    select({0, 0, 1919, 1079}, ids);
+    std::cout << "  select the whole window: " << std::chrono::duration<double, std::milli>(Clock::now() - full_start).count()
+              << " ms, " << ids.size() << " selected" << std::endl;
+
+    // erase a tenth, like an eraser dragged around
+    std::vector<uint32_t> erased;
+    for (uint32_t id = 0; id < primitives.size(); id += 10) {
+        erased.push_back(id);
+    }
+    double erase_us = time_us(erased.size(), [&, i = size_t(0)]() mutable {
+        grid.remove(erased[i]);
+        live[erased[i++]] = false;
+    });
+    std::cout << "  erase: " << erase_us << " us per primitive" << std::endl;
+    if (grid.size() != primitives.size() - erased.size() || !check("after erasing")) {
+        return false;
+    }
+
+    // erasing with covered pixels skipped, as in the viewer
+    const int size = 512;
+    auto strokes = scribble(4000, 43);
+    OccupancyBitmap occupancy(size, size);
+    PrimitiveGrid stroke_grid;
+    std::vector<std::pmr::vector<Vector2f>> stroke_points(strokes.size()), stroke_lines(strokes.size());
+    for (size_t i = 0; i < strokes.size(); ++i) {
+        stroke_grid.insert(static_cast<uint32_t>(i), bounds(strokes[i]));
+        rasterize(strokes[i], size, size, 1.0f, stroke_points[i], stroke_lines[i], &occupancy);
+    }
+    std::vector<bool> stroke_live(strokes.size(), true);
+    std::vector<Pixel> pixels;
+    std::vector<Span> spans;
+    std::pmr::vector<uint32_t> neighbours;
+    for (size_t i = 0; i < strokes.size(); i += 3) {
+        stroke_live[i] = false;
+        stroke_grid.remove(static_cast<uint32_t>(i));
+        stroke_points[i].clear();
+        stroke_lines[i].clear();
+        rasterize_pixels(strokes[i], size, size, 1.0f, pixels, spans);
+        occupancy.clear(pixels);
+        occupancy.clear(spans);
+        auto area = bounds(strokes[i]);
+        neighbours.clear();
+        stroke_grid.query({area.min_x - 2, area.min_y - 2, area.max_x + 2, area.max_y + 2}, neighbours);
+        for (auto id : neighbours) {
+            rasterize(strokes[id], size, size, 1.0f, stroke_points[id], stroke_lines[id], &occupancy);
+        }
+    }
+    std::pmr::vector<Vector2f> points, lines, expected_points, expected_lines;
+    for (size_t i = 0; i < strokes.size(); ++i) {
+        points.insert(points.end(), stroke_points[i].begin(), stroke_points[i].end());
+        lines.insert(lines.end(), stroke_lines[i].begin(), stroke_lines[i].end());
+        if (stroke_live[i]) {
+            rasterize(strokes[i], size, size, 1.0f, expected_points, expected_lines);
+        }
+    }
+    std::vector<uint8_t> counts, expected;
+    count_coverage(points, lines, size, counts);
+    count_coverage(expected_points, expected_lines, size, expected);
+    for (size_t i = 0; i < counts.size(); ++i) {
+        if ((counts[i] != 0) != (expected[i] != 0)) {
+            std::cerr << "[E] erasing with skipped pixels leaves the wrong pixel at ("
+                      << i % size << ", " << i / size << ")" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Heap allocations of committing strokes the way the viewer's release callback does, the vertices
+// in vectors on the heap or in the frame arena, reset every 16 commits like a frame would be.
+static bool bench_arena() {
+    const int size = 512;
+    auto strokes = scribble(20000, 43);
+    std::cout << std::endl << "committing 20000 strokes, heap allocations per commit" << std::endl;
+    std::cout << std::setw(10) << "scratch" << std::setw(10) << "us" << std::setw(10) << "allocs" << std::endl;
+    size_t sink = 0;
+    for (int use_arena = 0; use_arena < 2; ++use_arena) {
+        Arena arena;
+        // a first frame grows the arena and the rasterizer's scratch, the rest are steady
+        uint64_t allocations = 0;
+        auto start = Clock::now();
+        for (size_t i = 0; i < strokes.size(); ++i) {
+            if (i % 16 == 0) {
+                arena.reset();
+            }
+            if (i == 16) {
+                allocations = heap_allocation_count();
+                start = Clock::now();
+            }
+            auto *resource = use_arena ? static_cast<std::pmr::memory_resource *>(&arena) : std::pmr::new_delete_resource();
+            std::pmr::vector<Vector2f> points(resource), lines(resource);
+            rasterize(strokes[i], size, size, 1.0f, points, lines);
+            sink += points.size() + lines.size();
+        }
+        auto commits = static_cast<double>(strokes.size() - 16);
+        double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / commits;
+        double per_commit = static_cast<double>(heap_allocation_count() - allocations) / commits;
+        std::cout << std::setw(10) << (use_arena ? "arena" : "heap") << std::setw(10) << std::fixed << std::setprecision(2) << us
+                  << std::setw(10) << per_commit << std::endl;
+        if (use_arena && per_commit > 0.0) {
+            // only the first frames may grow the arena: the blocks of a 16 stroke frame are all retained
+            std::cerr << "[E] commits with the frame arena still allocate" << std::endl;
+            return false;
+        }
+    }
+    if (sink == 1) {
+        std::cout << std::endl;
+    }
+    return true;
+}
+
+// ns per pixel and allocations per call over sets of primitives, each call with a new vector
+// like the viewer's callbacks
+struct PrimitiveSet {
+    const char *name;
+    std::vector<Line> shapes;
+};
+
+static std::vector<PrimitiveSet> adversarial_sets() {
+    std::vector<PrimitiveSet> sets;
+    uint32_t seed = 40;
+    auto next = [&](uint32_t range) {
+        seed = seed * 1664525u + 1013904223u;
+        return static_cast<int>((seed >> 8) % range);
+    };
+
+    PrimitiveSet octants{"octants", {}};
+    for (int i = 0; i < 4096; ++i) {
+        int length = 1 + next(512);
+        int minor = next(static_cast<uint32_t>(length));
+        int dx = (i & 1) ? minor : length;
+        int dy = (i & 1) ? length : minor;
+        octants.shapes.push_back({Pixel(0, 0), Pixel((i & 2) ? -dx : dx, (i & 4) ? -dy : dy)});
+    }
+    sets.push_back(octants);
+
+    // zero length, one pixel, axis aligned and exact diagonals
+    PrimitiveSet degenerate{"degenerate", {}};
+    for (int length : {0, 1, 2, 3, 511}) {
+        for (auto d : {Pixel(1, 0), Pixel(-1, 0), Pixel(0, 1), Pixel(0, -1), Pixel(1, 1), Pixel(-1, 1), Pixel(1, -1), Pixel(-1, -1)}) {
+            degenerate.shapes.push_back({Pixel(0, 0), Pixel(d.x * length, d.y * length)});
+        }
+    }
+    sets.push_back(degenerate);
+
+    PrimitiveSet small{"small ellipses", {}};
+    for (int i = 0; i < 4096; ++i) {
+        small.shapes.push_back({Pixel(0, 0), Pixel(next(17), next(17))});
+    }
+    sets.push_back(small);
+
+    // up to the 32768 the midpoint decisions are exact for, and the flattest shapes
+    PrimitiveSet huge{"huge ellipses", {}};
+    for (int i = 0; i < 8; ++i) {
+        huge.shapes.push_back({Pixel(0, 0), Pixel(8192 + next(24577), 8192 + next(24577))});
+    }
+    huge.shapes.push_back({Pixel(0, 0), Pixel(32768, 1)});
+    huge.shapes.push_back({Pixel(0, 0), Pixel(1, 32768)});
+    sets.push_back(huge);
+    return sets;
+}
+
+static void bench_ns_per_pixel() {
+    std::cout << std::endl << "ns per pixel and allocations per call" << std::endl;
+    std::cout << std::setw(16) << "set" << std::setw(22) << "function" << std::setw(12) << "pixels"
+              << std::setw(10) << "ns/pixel" << std::setw(10) << "allocs" << std::endl;
+    size_t sink = 0;
+    for (const auto& set : adversarial_sets()) {
+        bool ellipses = std::string(set.name).find("ellipse") != std::string::npos;
+        std::vector<std::pair<const char *, void (*)(Pixel, Pixel, std::vector<Pixel>&)>> functions;
+        if (ellipses) {
+            functions.emplace_back("draw_ellipse", static_cast<void (*)(Pixel, Pixel, std::vector<Pixel>&)>(draw_ellipse));
+        } else {
+            functions.emplace_back("draw_line_dda", static_cast<void (*)(Pixel, Pixel, std::vector<Pixel>&)>(draw_line_dda));
+            functions.emplace_back("draw_line_bresenham", static_cast<void (*)(Pixel, Pixel, std::vector<Pixel>&)>(draw_line_bresenham));
+        }
+        for (const auto& function : functions) {
+            size_t pixels = 0;
+            size_t passes = 0;
+            uint64_t allocations = heap_allocation_count();
+            auto start = Clock::now();
+            do {
+                for (const auto& shape : set.shapes) {
+                    std::vector<Pixel> out;
+                    function.second(shape.start, shape.end, out);
+                    pixels += out.size();
+                    sink += out.empty() ? 0 : static_cast<size_t>(out.back().x);
+                }
+                passes++;
+            } while (pixels < PIXELS_PER_RUN);
+            double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            auto calls = static_cast<double>(passes * set.shapes.size());
+            std::cout << std::setw(16) << set.name << std::setw(22) << function.first
+                      << std::setw(12) << pixels / passes << std::fixed << std::setprecision(2)
+                      << std::setw(10) << ns / static_cast<double>(pixels)
+                      << std::setw(10) << static_cast<double>(heap_allocation_count() - allocations) / calls << std::endl;
+        }
+    }
+    if (sink == 1) {
+        std::cout << std::endl;
+    }
+}
+
+// Golden images: fixed 256x256 scenes drawn through each rasterizer, black on white, clipped to the
+// image. A change of a single pixel fails --check; --write-golden records the current output.
+static const int GOLDEN_SIZE = 256;
+
+static std::vector<uint8_t> golden_scene(const std::string& name) {
+    ClipRect clip(GOLDEN_SIZE, GOLDEN_SIZE);
+    std::vector<Pixel> pixels;
+    std::vector<Span> spans;
+    Pixel center(GOLDEN_SIZE / 2, GOLDEN_SIZE / 2);
+    if (name == "dda" || name == "bresenham") {
+        // a fan over every octant, lines leaving the image, and the degenerate ones
+        for (int i = 0; i < 72; ++i) {
+            double angle = i * 3.14159265358979 / 36.0;
+            int radius = i % 2 ? 120 : 400;
+            Pixel end(center.x + static_cast<int>(std::lround(radius * std::cos(angle))),
+                      center.y + static_cast<int>(std::lround(radius * std::sin(angle))));
+            name == "dda" ? draw_line_dda(center, end, pixels, clip) : draw_line_bresenham(center, end, pixels, clip);
+        }
+        for (auto p : {Pixel(10, 10), Pixel(245, 10), Pixel(-5, 250)}) {
+            name == "dda" ? draw_line_dda(p, p, pixels, clip) : draw_line_bresenham(p, p, pixels, clip);
+        }
+    } else if (name == "ellipse" || name == "filled_ellipse") {
+        for (int i = 0; i < 12; ++i) {
+            Pixel corner(center.x + 8 + i * 10, center.y + 100 - i * 8);
+            name == "ellipse" ? draw_ellipse(center, corner, pixels, clip) : fill_ellipse_spans(Pixel(i * 20, i * 20), Pixel(i * 20 + 3 + i, i * 20 + 12 - i), spans, clip);
+        }
+        // larger than the image, only the arcs through it are left
+        name == "ellipse" ? draw_ellipse(Pixel(0, 0), Pixel(300, 200), pixels, clip) : fill_ellipse_spans(Pixel(300, 300), Pixel(600, 120), spans, clip);
+        name == "ellipse" ? draw_ellipse(Pixel(128, 300), Pixel(20128, 180), pixels, clip) : fill_ellipse_spans(Pixel(-40, 200), Pixel(60, 240), spans, clip);
+    }
+
+    std::vector<uint8_t> image(GOLDEN_SIZE * GOLDEN_SIZE, 255);
+    for (const auto& p : pixels) {
+        image[p.y * GOLDEN_SIZE + p.x] = 0;
+    }
+    for (const auto& span : spans) {
+        for (int x = span.x_begin; x < span.x_end; ++x) {
+            image[span.y * GOLDEN_SIZE + x] = 0;
+        }
+    }
+    return image;
+}
+
+static bool write_pgm(const std::string& path, const std::vector<uint8_t>& image) {
+    std::ofstream file(path, std::ios::binary);
+    file << "P5\n" << GOLDEN_SIZE << " " << GOLDEN_SIZE << "\n255\n";
+    file.write(reinterpret_cast<const char *>(image.data()), static_cast<std::streamsize>(image.size()));
+    if (!file) {
+        std::cerr << "[E] Failed to write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static bool read_pgm(const std::string& path, std::vector<uint8_t>& image) {
+    std::ifstream file(path, std::ios::binary);
+    std::string magic;
+    int width = 0, height = 0, max_value = 0;
+    file >> magic >> width >> height >> max_value;
+    file.get();
+    if (!file || magic != "P5" || width != GOLDEN_SIZE || height != GOLDEN_SIZE || max_value != 255) {
+        std::cerr << "[E] Failed to read " << path << std::endl;
+        return false;
+    }
+    image.resize(static_cast<size_t>(width) * height);
+    file.read(reinterpret_cast<char *>(image.data()), static_cast<std::streamsize>(image.size()));
+    return static_cast<bool>(file);
+}
+
+static bool golden_images(bool write) {
+    bool ok = true;
+    for (const char *name : {"dda", "bresenham", "ellipse", "filled_ellipse"}) {
+        auto image = golden_scene(name);
+        std::string path = std::string(GOLDEN_DIR) + "/" + name + ".pgm";
+        if (write) {
+            ok = write_pgm(path, image) && ok;
+            std::cout << "[I] wrote " << path << std::endl;
+            continue;
+        }
+        std::vector<uint8_t> golden;
+        if (!read_pgm(path, golden)) {
+            ok = false;
+            continue;
+        }
+        size_t differ = 0;
+        for (size_t i = 0; i < image.size(); ++i) {
+            differ += image[i] != golden[i];
+        }
+        std::cout << std::setw(16) << name << (differ == 0 ? "  matches" : "  differs") << " the golden image";
+        if (differ != 0) {
+            // written next to the golden one to compare them
+            write_pgm(path + ".actual.pgm", image);
+            std::cout << " in " << differ << " pixels, see " << path << ".actual.pgm";
+        }
+        std::cout << std::endl;
+        ok = ok && differ == 0;
+    }
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && (std::string(argv[1]) == "--check" || std::string(argv[1]) == "--write-golden")) {
+        return golden_images(std::string(argv[1]) == "--write-golden") ? 0 : -1;
+    }
+
+    std::vector<Pixel> pixels;
+    std::vector<Pixel> span(8192);
+    std::vector<Pixel> check(8192);
+    uint64_t sink = 0;
+
+    std::cout << "line throughput in Mpixels/s" << std::endl;
+    std::cout << std::setw(8) << "length" << std::setw(10) << "dda" << std::setw(12) << "bresenham"
+              << std::setw(10) << "scalar" << std::setw(10) << "avx2" << std::endl;
+    for (int length = 1; length <= 4096; length *= 2) {
+        auto lines = make_lines(length, static_cast<uint32_t>(length));
+        size_t pixels_per_pass = 0;
+        for (const auto& line : lines) {
+            pixels_per_pass += line_pixel_count(line.start, line.end);
+        }
+
+        // the current dda, one emplace_back per pixel into a reused vector
+        double dda = measure(lines, pixels_per_pass, [&](const Line& line) {
+            pixels.clear();
+            draw_line_dda(line.start, line.end, pixels);
+            sink += pixels.back().x;
+        });
+        double vec = measure(lines, pixels_per_pass, [&](const Line& line) {
+            pixels.clear();
+            draw_line_bresenham(line.start, line.end, pixels);
+            sink += pixels.back().x;
+        });
+        double scalar = measure(lines, pixels_per_pass, [&](const Line& line) {
+            auto n = draw_line_bresenham_scalar(line.start, line.end, span.data());
+            sink += span[n - 1].x;
+        });
+        std::cout << std::setw(8) << length << std::fixed << std::setprecision(1)
+                  << std::setw(10) << dda / 1e6 << std::setw(12) << vec / 1e6 << std::setw(10) << scalar / 1e6;
+
+#ifdef __AVX2__
+        double avx2 = measure(lines, pixels_per_pass, [&](const Line& line) {
+            auto n = draw_line_bresenham_avx2(line.start, line.end, span.data());
+            sink += span[n - 1].x;
+        });
+        std::cout << std::setw(10) << avx2 / 1e6 << std::endl;
+
+        for (const auto& line : lines) {
+            auto n = draw_line_bresenham_scalar(line.start, line.end, check.data());
+            draw_line_bresenham_avx2(line.start, line.end, span.data());
+            for (size_t i = 0; i < n; ++i) {
+                if (span[i] != check[i]) {
+                    std::cerr << "[E] avx2 differs from scalar at pixel " << i << " of (" << line.start.x << ", "
+                              << line.start.y << ") - (" << line.end.x << ", " << line.end.y << ")" << std::endl;
+                    return -1;
+                }
+            }
+        }
+#else
+        std::cout << std::setw(10) << "-" << std::endl;
+#endif
+    }
+
+    // run-length output: pixels covered per second and vertices uploaded as GL_POINTS vs spans, the
+    // runs of a single pixel going out as points like rasterize_pixels does. Steep lines have one
+    // pixel per row, so near horizontal lines are measured on their own too.
+    std::vector<Span> spans;
+    for (int minor_divisor : {1, 8}) {
+        std::cout << std::endl << "span output, " << (minor_divisor == 1 ? "all octants" : "near horizontal, |dy| < |dx| / 8") << std::endl;
+        std::cout << std::setw(8) << "length" << std::setw(10) << "Mpix/s" << std::setw(10) << "points"
+                  << std::setw(10) << "vertices" << std::setw(10) << "ratio" << std::endl;
+        for (int length = 1; length <= 4096; length *= 2) {
+            auto lines = make_lines(length, static_cast<uint32_t>(length), minor_divisor);
+            size_t pixels_per_pass = 0;
+            size_t span_vertices = 0;
+            for (const auto& line : lines) {
+                pixels_per_pass += line_pixel_count(line.start, line.end);
+                spans.clear();
+                draw_line_spans(line.start, line.end, spans);
+                for (const auto& span : spans) {
+                    span_vertices += span.length() == 1 ? 1 : 2;
+                }
+            }
+            double rate = measure(lines, pixels_per_pass, [&](const Line& line) {
+                spans.clear();
+                draw_line_spans(line.start, line.end, spans);
+                sink += spans.back().x_end;
+            });
+            std::cout << std::setw(8) << length << std::setw(10) << rate / 1e6
+                      << std::setw(10) << pixels_per_pass / LINES_PER_LENGTH
+                      << std::setw(10) << span_vertices / LINES_PER_LENGTH
+                      << std::setw(10) << static_cast<double>(pixels_per_pass) / static_cast<double>(span_vertices) << std::endl;
+        }
+    }
+
+    // ellipses: exact against the reference, then the time of one ellipse
+    for (int a = 0; a <= 64; ++a) {
+        for (int b = 0; b <= 64; ++b) {
+            if (!check_ellipse(a, b)) {
+                return -1;
+            }
+        }
+    }
+    for (int a = 128; a <= 4096; a *= 2) {
+        if (!check_ellipse(a, a) || !check_ellipse(a, a / 3) || !check_ellipse(a / 5, a)) {
+            return -1;
+        }
+    }
+
+    std::cout << std::endl << "ellipse, microseconds per ellipse" << std::endl;
+    std::cout << std::setw(12) << "semi-axes" << std::setw(10) << "pixels" << std::setw(10) << "outline"
+              << std::setw(10) << "spans" << std::setw(10) << "filled" << std::endl;
+    for (int a = 1; a <= 4096; a *= 2) {
+        for (int b : {a, std::max(a / 4, 1)}) {
+            Pixel center(8192, 8192), corner(8192 + a, 8192 + b);
+            size_t calls = std::max<size_t>(PIXELS_PER_RUN / 64 / static_cast<size_t>(a + b), 16);
+            double outline = time_us(calls, [&] {
+                pixels.clear();
+                draw_ellipse(center, corner, pixels);
+                sink += pixels.size();
+            });
+            size_t outline_pixels = pixels.size();
+            double outline_spans = time_us(calls, [&] {
+                spans.clear();
+                draw_ellipse_spans(center, corner, spans);
+                sink += spans.size();
+            });
+            double filled = time_us(calls, [&] {
+                spans.clear();
+                fill_ellipse_spans(center, corner, spans);
+                sink += spans.size();
+            });
+            std::cout << std::setw(12) << std::to_string(a) + "x" + std::to_string(b)
+                      << std::setw(10) << outline_pixels << std::setprecision(2)
+                      << std::setw(10) << outline << std::setw(10) << outline_spans << std::setw(10) << filled << std::endl;
+        }
+    }
+
+    if (!golden_images(false)) {
+        return -1;
+    }
+    bench_ns_per_pixel();
+
+    if (!bench_vertex_store() || !bench_primitives() || !bench_occupancy() || !bench_grid() || !bench_arena()) {
+        return -1;
+    }
+
+    // clipping: exact against the unclipped pixels, then a drag far outside a 1280x720 window
+    ClipRect small(97, 61);
+    uint32_t seed = 35;
+    for (int i = 0; i < 4000; ++i) {
+        int v[4];
+        for (auto& c : v) {
+            seed = seed * 1664525u + 1013904223u;
+            c = static_cast<int>((seed >> 8) % 400) - 150;
+        }
+        if (!check_clipping(Pixel(v[0], v[1]), Pixel(v[2], v[3]), small)) {
+            return -1;
+        }
+    }
+
+    ClipRect window(1280, 720);
+    std::cout << std::endl << "clipping to 1280x720, microseconds per primitive" << std::endl;
+    std::cout << std::setw(12) << "cursor" << std::setw(10) << "visible" << std::setw(12) << "unclipped"
+              << std::setw(10) << "clipped" << std::setw(14) << "fill clipped" << std::setw(17) << "outline clipped" << std::endl;
+    for (int far = 2000; far <= 32000; far *= 2) {
+        Pixel start(640, 360), end(640 + far, 360 + far / 3);
+        // both ellipses cross the window, clipped they should cost the same at any distance
+        if (!check_clipping(start, end, window) || !check_clipping(Pixel(640, -far / 4), end, window)) {
+            return -1;
+        }
+        size_t calls = std::max<size_t>(PIXELS_PER_RUN / 16 / static_cast<size_t>(far), 16);
+        double unclipped = time_us(calls, [&] {
+            pixels.clear();
+            draw_line_bresenham(start, end, pixels);
+            sink += pixels.size();
+        });
+        double clipped = time_us(calls, [&] {
+            pixels.clear();
+            draw_line_bresenham(start, end, pixels, window);
+            sink += pixels.size();
+        });
+        size_t visible = pixels.size();
+        double fill = time_us(calls, [&] {
+            spans.clear();
+            fill_ellipse_spans(start, end, spans, window);
+            sink += spans.size();
+        });
+        // centered above the window, the top rows of the outline cross it
+        Pixel above(640, -far / 4);
+        double outline = time_us(calls, [&] {
+            spans.clear();
+            draw_ellipse_spans(above, end, spans, window);
+            sink += spans.size();
+        });
+        std::cout << std::setw(12) << far << std::setw(10) << visible << std::setprecision(2)
+                  << std::setw(12) << unclipped << std::setw(10) << clipped << std::setw(14) << fill
+                  << std::setw(17) << outline << std::endl;
+    }
+
+    return sink == 0 ? 1 : 0;
+}
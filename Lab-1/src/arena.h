@@ -0,0 +1,75 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+// Monotonic allocator for the short lived vectors of a frame or of one operation, to be used with the
+// std::pmr containers. An allocation bumps a pointer in the current block and deallocating does
+// nothing; rewinding keeps the blocks, so once they are as large as a frame needs, frames don't touch
+// the heap. A reset also gives back the blocks past retain_bytes, a large one-off operation doesn't
+// pin its memory. An arena isn't thread safe, every thread has its own from local().
+class Arena : public std::pmr::memory_resource {
+public:
+    static const size_t BLOCK_BYTES = 1 << 20;
+    static const size_t RETAIN_BYTES = 64 << 20;
+
+    struct Mark {
+        size_t block, offset;
+    };
+
+    explicit Arena(size_t block_bytes = BLOCK_BYTES, size_t retain_bytes = RETAIN_BYTES);
+    ~Arena() override;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    Mark mark() const { return {current, offset}; }
+    // Everything allocated since the mark is dead afterwards. Rewinding to the start is a reset.
+    void rewind(Mark mark);
+    void reset();
+
+    // bytes handed out since the last reset, with the alignment padding and the skipped block ends
+    size_t used() const;
+    size_t capacity() const;
+    size_t block_count() const { return blocks.size(); }
+
+    // the arena of the calling thread
+    static Arena& local();
+
+private:
+    struct Block {
+        char *data;
+        size_t size;
+    };
+
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    size_t block_bytes;
+    size_t retain_bytes;
+    std::vector<Block> blocks;
+    size_t current = 0; // the block being filled
+    size_t offset = 0;
+};
+
+// Rewinds an arena to where it was when the scope started, around one operation inside a frame.
+// The containers allocated from it in the scope must be gone when it ends.
+class ArenaScope {
+public:
+    explicit ArenaScope(Arena& arena = Arena::local()) : arena(arena), start(arena.mark()) {}
+    ~ArenaScope() { arena.rewind(start); }
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+    Arena *resource() { return &arena; }
+
+private:
+    Arena& arena;
+    Arena::Mark start;
+};
+
+#endif // ARENA_H
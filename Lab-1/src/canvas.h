@@ -0,0 +1,40 @@
+#ifndef CANVAS_H
+#define CANVAS_H
+
+#pragma once
+#include <cstdint>
+#include "glad/glad.h"
+
+// A color texture behind a framebuffer object that keeps what was drawn into it between frames.
+// Committed primitives are drawn into it once; a frame only copies it to the window and draws
+// what changes on top, so the frame cost doesn't grow with the drawing.
+class Canvas {
+public:
+    Canvas(int width, int height);
+    ~Canvas();
+    Canvas(const Canvas&) = delete;
+    Canvas& operator=(const Canvas&) = delete;
+
+    // the contents are lost, everything has to be drawn again
+    void resize(int width, int height);
+    // draws go to the canvas between begin and end, end restores the window and its viewport
+    void begin();
+    void end();
+    void clear(float r, float g, float b, float a);
+    // copies the canvas over the whole window framebuffer, no clear is needed before
+    void present();
+
+    int width() const { return tex_width; }
+    int height() const { return tex_height; }
+    GLuint texture() const { return tex; }
+
+private:
+    void allocate();
+
+    GLuint fbo = 0;
+    GLuint tex = 0;
+    int tex_width;
+    int tex_height;
+};
+
+#endif // CANVAS_H
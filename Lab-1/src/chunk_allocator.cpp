@@ -0,0 +1,242 @@
+#include "chunk_allocator.h"
+
+#include <algorithm>
+#include <utility>
+#include "arena.h"
+
+ChunkAllocator::ChunkAllocator(uint32_t chunk_vertices) : chunk_size(chunk_vertices) {}
+
+uint32_t ChunkAllocator::new_chunk() {
+    uint32_t idx = 0;
+    if (!spare.empty()) {
+        // already active, it only has to be emptied
+        idx = spare.back();
+        spare.pop_back();
+    } else {
+        while (idx < chunks.size() && chunks[idx].active) {
+            idx++;
+        }
+        if (idx == chunks.size()) {
+            chunks.emplace_back();
+        }
+        chunks[idx].active = true;
+        active_num++;
+    }
+    auto& chunk = chunks[idx];
+    chunk.used = 0;
+    chunk.live = 0;
+    chunk.dirty = true;
+    chunk.handles.clear();
+    return idx;
+}
+
+void ChunkAllocator::release(uint32_t chunk) {
+    auto& c = chunks[chunk];
+    c.active = false;
+    c.handles.clear();
+    c.firsts.clear();
+    c.counts.clear();
+    active_num--;
+    if (tail == chunk) {
+        tail = NONE;
+    }
+    if (evacuating == chunk) {
+        evacuating = NONE;
+    }
+}
+
+ChunkAllocator::Piece ChunkAllocator::place(uint32_t count, bool split) {
+    if (tail == NONE || chunks[tail].used == chunk_size || (!split && chunks[tail].used + count > chunk_size)) {
+        tail = new_chunk();
+    }
+    auto& c = chunks[tail];
+    Piece piece{tail, c.used, std::min(count, chunk_size - c.used)};
+    c.used += piece.count;
+    c.live += piece.count;
+    c.dirty = true;
+    return piece;
+}
+
+uint32_t ChunkAllocator::allocate(uint32_t count, std::vector<Piece>& pieces) {
+    uint32_t handle;
+    if (!free_handles.empty()) {
+        handle = free_handles.back();
+        free_handles.pop_back();
+    } else {
+        handle = static_cast<uint32_t>(allocations.size());
+        allocations.emplace_back();
+    }
+    auto& allocation = allocations[handle];
+    allocation.pieces.clear();
+    allocation.live = true;
+
+    while (count > 0) {
+        auto piece = place(count, true);
+        if (chunks[piece.chunk].handles.empty() || chunks[piece.chunk].handles.back() != handle) {
+            chunks[piece.chunk].handles.push_back(handle);
+        }
+        allocation.pieces.push_back(piece);
+        pieces.push_back(piece);
+        count -= piece.count;
+        live_num += piece.count;
+    }
+    return handle;
+}
+
+void ChunkAllocator::free(uint32_t handle) {
+    auto& allocation = allocations[handle];
+    if (!allocation.live) {
+        return;
+    }
+    allocation.live = false;
+    for (const auto& piece : allocation.pieces) {
+        auto& c = chunks[piece.chunk];
+        c.live -= piece.count;
+        c.dirty = true;
+        live_num -= piece.count;
+        // an empty chunk goes right away, the tail stays to take the next allocations
+        if (c.live == 0 && piece.chunk != tail) {
+            release(piece.chunk);
+        }
+    }
+    allocation.pieces.clear();
+    free_handles.push_back(handle);
+}
+
+void ChunkAllocator::clear() {
+    for (uint32_t i = 0; i < allocations.size(); ++i) {
+        if (allocations[i].live) {
+            allocations[i].live = false;
+            allocations[i].pieces.clear();
+            free_handles.push_back(i);
+        }
+    }
+    for (auto& c : chunks) {
+        c.used = 0;
+        c.live = 0;
+        c.dirty = true;
+        c.handles.clear();
+    }
+    // the active chunks are kept and handed out again lowest slot first
+    spare.clear();
+    for (uint32_t i = static_cast<uint32_t>(chunks.size()); i-- > 0;) {
+        if (chunks[i].active) {
+            spare.push_back(i);
+        }
+    }
+    tail = NONE;
+    evacuating = NONE;
+    live_num = 0;
+}
+
+uint32_t ChunkAllocator::compact(uint32_t budget, std::vector<Move>& moves) {
+    // what clear() kept and the allocations since didn't need
+    for (auto chunk : spare) {
+        release(chunk);
+    }
+    spare.clear();
+
+    uint32_t moved = 0;
+    while (moved < budget) {
+        if (evacuating == NONE) {
+            // the emptiest chunk below half live, never the one being filled
+            uint32_t best_live = chunk_size / 2;
+            for (uint32_t i = 0; i < chunks.size(); ++i) {
+                if (chunks[i].active && i != tail && chunks[i].live < best_live) {
+                    evacuating = i;
+                    best_live = chunks[i].live;
+                }
+            }
+            if (evacuating == NONE) {
+                break;
+            }
+        }
+
+        uint32_t src = evacuating;
+        // handles may be appended to the destination while iterating, which is never src
+        ArenaScope scope;
+        std::pmr::vector<uint32_t> handles(chunks[src].handles.begin(), chunks[src].handles.end(), scope.resource());
+        for (auto handle : handles) {
+            auto& allocation = allocations[handle];
+            if (!allocation.live) {
+                continue;
+            }
+            for (auto& piece : allocation.pieces) {
+                if (piece.chunk != src) {
+                    continue;
+                }
+                if (moved > 0 && moved + piece.count > budget) {
+                    return moved;
+                }
+                // pieces are never split on a move, a piece always fits an empty chunk
+                auto dst = place(piece.count, false);
+                moves.push_back({src, piece.first, dst.chunk, dst.first, piece.count});
+                auto& dst_chunk = chunks[dst.chunk];
+                if (dst_chunk.handles.empty() || dst_chunk.handles.back() != handle) {
+                    dst_chunk.handles.push_back(handle);
+                }
+                chunks[src].live -= piece.count;
+                chunks[src].dirty = true;
+                moved += piece.count;
+                piece = dst;
+            }
+        }
+        release(src);
+    }
+    return moved;
+}
+
+void ChunkAllocator::rebuild(uint32_t chunk) {
+    auto& c = chunks[chunk];
+    // a handle is listed again when one of its pieces is moved back in
+    std::sort(c.handles.begin(), c.handles.end());
+    c.handles.erase(std::unique(c.handles.begin(), c.handles.end()), c.handles.end());
+    // rebuilt after every commit to the tail chunk, the ranges are scratch
+    ArenaScope scope;
+    std::pmr::vector<std::pair<uint32_t, uint32_t>> ranges(scope.resource());
+    size_t kept = 0;
+    for (auto handle : c.handles) {
+        const auto& allocation = allocations[handle];
+        if (!allocation.live) {
+            continue;
+        }
+        bool here = false;
+        for (const auto& piece : allocation.pieces) {
+            if (piece.chunk == chunk) {
+                ranges.emplace_back(piece.first, piece.count);
+                here = true;
+            }
+        }
+        if (here) {
+            c.handles[kept++] = handle;
+        }
+    }
+    c.handles.resize(kept);
+
+    std::sort(ranges.begin(), ranges.end());
+    c.firsts.clear();
+    c.counts.clear();
+    for (const auto& range : ranges) {
+        if (!c.firsts.empty() && static_cast<uint32_t>(c.firsts.back() + c.counts.back()) == range.first) {
+            c.counts.back() += static_cast<int32_t>(range.second);
+        } else {
+            c.firsts.push_back(static_cast<int32_t>(range.first));
+            c.counts.push_back(static_cast<int32_t>(range.second));
+        }
+    }
+    c.dirty = false;
+}
+
+const std::vector<int32_t>& ChunkAllocator::firsts(uint32_t chunk) {
+    if (chunks[chunk].dirty) {
+        rebuild(chunk);
+    }
+    return chunks[chunk].firsts;
+}
+
+const std::vector<int32_t>& ChunkAllocator::counts(uint32_t chunk) {
+    if (chunks[chunk].dirty) {
+        rebuild(chunk);
+    }
+    return chunks[chunk].counts;
+}
@@ -0,0 +1,83 @@
+#ifndef CHUNK_ALLOCATOR_H
+#define CHUNK_ALLOCATOR_H
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bookkeeping of a vertex store made of fixed size chunks, without any GL call so it can be
+// benchmarked on its own. Allocations are bump allocated at the end of the last chunk and split
+// over new chunks when they don't fit. Freed allocations leave holes, compact() plans moving the
+// live vertices out of the emptiest chunk a few at a time so that chunk can be given back.
+// Chunk slots are reused, a slot is active while it holds GPU memory.
+class ChunkAllocator {
+public:
+    static const uint32_t NONE = UINT32_MAX;
+
+    struct Piece {
+        uint32_t chunk, first, count;
+    };
+    // count vertices from src_first of src_chunk to dst_first of dst_chunk, always two different chunks
+    struct Move {
+        uint32_t src_chunk, src_first, dst_chunk, dst_first, count;
+    };
+
+    explicit ChunkAllocator(uint32_t chunk_vertices);
+
+    // returns the handle of the allocation, its pieces are appended to pieces for the upload
+    uint32_t allocate(uint32_t count, std::vector<Piece>& pieces);
+    void free(uint32_t handle);
+    // frees everything but keeps the chunks, the next allocations fill them in order before new
+    // chunks are started
+    void clear();
+
+    // Moves at most budget vertices, returns how many were planned. A chunk is emptied when less than
+    // half of it is live; it is released once the last live vertex left it, and the next one is taken
+    // on while budget is left. The chunks clear() kept that are still unused are released first.
+    uint32_t compact(uint32_t budget, std::vector<Move>& moves);
+
+    // Draw ranges of a chunk, adjacent live pieces merged; int32 to be passed to glMultiDrawArrays as is.
+    // Rebuilt lazily after a change to the chunk.
+    const std::vector<int32_t>& firsts(uint32_t chunk);
+    const std::vector<int32_t>& counts(uint32_t chunk);
+
+    uint32_t chunk_vertices() const { return chunk_size; }
+    size_t chunk_slots() const { return chunks.size(); }
+    bool chunk_active(uint32_t chunk) const { return chunks[chunk].active; }
+    size_t active_chunks() const { return active_num; }
+    uint64_t live_vertices() const { return live_num; }
+    const std::vector<Piece>& pieces(uint32_t handle) const { return allocations[handle].pieces; }
+
+private:
+    struct Allocation {
+        std::vector<Piece> pieces;
+        bool live;
+    };
+    struct Chunk {
+        uint32_t used = 0; // bump pointer
+        uint32_t live = 0;
+        bool active = false;
+        bool dirty = false;
+        std::vector<uint32_t> handles; // allocations with pieces here, may hold freed or moved ones
+        std::vector<int32_t> firsts, counts;
+    };
+
+    uint32_t new_chunk();
+    void release(uint32_t chunk);
+    // a place for count contiguous vertices, starting a new chunk when the tail is too full
+    Piece place(uint32_t count, bool split);
+    void rebuild(uint32_t chunk);
+
+    uint32_t chunk_size;
+    std::vector<Chunk> chunks;
+    std::vector<Allocation> allocations;
+    std::vector<uint32_t> free_handles;
+    std::vector<uint32_t> spare; // active and empty after clear(), the next one to fill at the back
+    uint32_t tail = NONE;
+    uint32_t evacuating = NONE;
+    size_t active_num = 0;
+    uint64_t live_num = 0;
+};
+
+#endif // CHUNK_ALLOCATOR_H
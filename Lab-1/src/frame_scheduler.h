@@ -0,0 +1,37 @@
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#pragma once
+#include <cstdint>
+
+// Chooses between drawing at full rate and sleeping in glfwWaitEventsTimeout when nothing changes.
+// Any event wakes the loop and keeps it drawing for a few frames, so ImGui can settle its hover and
+// active states; animations and unfinished background work keep it at full rate with set_animating()
+// and request_redraw(). An idle loop still draws every idle_timeout seconds, for the readouts.
+class FrameScheduler {
+public:
+    static const uint32_t SETTLE_FRAMES = 3;
+
+    explicit FrameScheduler(double idle_timeout = 0.5);
+
+    // in place of glfwPollEvents, after the frame is swapped
+    void wait_events();
+    void request_redraw(uint32_t frames = SETTLE_FRAMES);
+    void set_animating(bool animating) { this->animating = animating; }
+    // off draws every frame, as the plain polling loop
+    void set_on_demand(bool on_demand) { this->on_demand = on_demand; }
+
+    // whether the last wait slept, and the seconds spent asleep so far
+    bool idle() const { return slept; }
+    double sleep_seconds() const { return asleep; }
+
+private:
+    double idle_timeout;
+    uint32_t pending_frames = SETTLE_FRAMES;
+    bool animating = false;
+    bool on_demand = true;
+    bool slept = false;
+    double asleep = 0.0;
+};
+
+#endif // FRAME_SCHEDULER_H
@@ -0,0 +1,11 @@
+#ifndef HEAP_STATS_H
+#define HEAP_STATS_H
+
+#pragma once
+#include <cstdint>
+
+// Every operator new of the process is counted, from any thread, to show that the steady frames
+// don't touch the heap. Memory taken with malloc directly, like ImGui's, isn't seen.
+uint64_t heap_allocation_count();
+
+#endif // HEAP_STATS_H
@@ -1,6 +1,16 @@
 #include <iostream>
 #include <cstdint>
+#include <cstdlib>
+#include <string>
 #include <vector>
+#include <memory>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <climits>
+#include <algorithm>
+#include <unordered_map>
+#include <memory_resource>
 
 #include "glad/glad.h"
 #include "GLFW/glfw3.h"
@@ -11,31 +21,100 @@
 #include "shader.h"
 #include "utils.h"
 #include "rasterization.h"
+#include "vertex_store.h"
+#include "canvas.h"
+#include "primitive.h"
+#include "occupancy.h"
+#include "primitive_grid.h"
+#include "arena.h"
+#include "heap_stats.h"
+#include "frame_scheduler.h"
 
 #define STRINGIFY2(X) #X
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_button_callback(GLFWwindow *window, int button, int action, int mods);
 void cursor_pos_callback(GLFWwindow *window, double xpos, double ypos);
+void scroll_callback(GLFWwindow *window, double xoffset, double yoffset);
 void error_callback(int code, const char *description);
 inline void process_input(GLFWwindow* window);
 
 const uint32_t SCR_WIDTH = 800;
 const uint32_t SCR_HEIGHT = 600;
 
-const uint32_t SUP_DRAW_NUM = 10000; // superior boundary of drawn pixels
+// vertices moved out of mostly erased chunks per frame
+const uint32_t COMPACT_BUDGET = 1 << 16;
+
+const char *DRAWING_FILE = "drawing.mdpr";
+
+// window pixels around the cursor that the select and erase tools reach
+const float PICK_RADIUS = 4.0f;
 
 uint32_t pressing = 0;
-uint32_t drawn_size = 0;
-uint32_t drawing_size = 0;
-Pixel start, end;
+Pixel start, end; // canvas coordinates
+// The drawing as primitive records, the stores below only hold its pixels for the current window
+// size and zoom and are rebuilt from it when either changes.
+static std::vector<Primitive> primitives;
+static float zoom = 1.0f;
+static double rebuild_ms = 0.0;
+// committed primitives, as points and as span lines (two vertices per span)
+static std::unique_ptr<VertexStore> drawn_points, drawn_lines;
+// The committed primitives are drawn once into the canvas: the new ones as they are committed,
+// everything again only when the canvas is resized.
+static std::unique_ptr<Canvas> canvas;
+static bool canvas_dirty = true;
+static std::vector<uint32_t> new_points, new_lines; // handles not yet in the canvas
+// Window pixels already in the stores. Strokes drawn over each other only upload the pixels they
+// add; rebuilt with the stores.
+static std::unique_ptr<OccupancyBitmap> occupancy;
+static bool dedupe_pixels = true;
+// sleep between events while the drawing doesn't change
+static bool on_demand = true;
+
+// The store handles of every primitive. Erasing frees its ranges, without touching the rest of the
+// stores; the record itself is dropped on the next rebuild.
+struct StoredPrimitive {
+    uint32_t points, lines;
+    bool live;
+};
+static std::vector<StoredPrimitive> stored;
+// Vertices added to a primitive after it was committed: with covered pixels skipped, the pixels of
+// an erased primitive are drawn again by the primitives still under them.
+static std::unordered_multimap<uint32_t, StoredPrimitive> patches;
+// bounds of the live primitives, for hit testing
+static PrimitiveGrid grid;
+static std::pmr::vector<uint32_t> selection;
+// the selected primitives drawn over the canvas, rasterized without skipping covered pixels
+static std::unique_ptr<VertexStore> selected_points, selected_lines;
+static double query_us = 0.0;
 
 enum class DrawMode : int {
     line_dda = 1,
     line_bresenham = 2,
     ellipse = 3,
+    select = 4,
+    erase = 5,
 };
 static DrawMode mode = DrawMode::line_dda;
+// new primitives are stored as one GL_LINES segment per horizontal run instead of one point per pixel
+static bool use_spans = true;
+static bool fill_ellipse = false;
+
+// Dragging only moves end: the preview is generated by preview.vert from the endpoints, the CPU
+// rasterizes on release. Cursor events are timed to the swap of the first frame showing them.
+static double preview_input_time = -1.0;
+static uint32_t cursor_events = 0;
+
+static Primitive current_primitive();
+static Pixel to_window(Pixel p);
+static void draw_preview(Shader& preview_shader, const Primitive& primitive, int width, int height);
+static void rebuild_drawing(GLFWwindow *window);
+static void pick(double xpos, double ypos, std::pmr::vector<uint32_t>& ids);
+static void erase_at(GLFWwindow *window, double xpos, double ypos);
+static void erase_primitives(GLFWwindow *window, const std::pmr::vector<uint32_t>& ids);
+static void update_selection(GLFWwindow *window);
+static std::vector<Primitive> live_primitives();
+static void fill_stress_primitives(uint64_t count);
 
 int main(int argc, char **argv) {
     glfwInit();
@@ -59,6 +138,7 @@ int main(int argc, char **argv) {
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetMouseButtonCallback(window, mouse_button_callback);
     glfwSetCursorPosCallback(window, cursor_pos_callback);
+    glfwSetScrollCallback(window, scroll_callback);
     glfwSetErrorCallback(error_callback);
 
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
@@ -75,22 +155,42 @@ int main(int argc, char **argv) {
     ImGui_ImplOpenGL3_Init("#version 330");
 
     Shader shader(SHADER_DIR"/point.vert", SHADER_DIR"/point.frag");
-
-    uint32_t VBO, VAO;
-    glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
-
-    glGenBuffers(1, &VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, SUP_DRAW_NUM * sizeof(Vector2f), nullptr, GL_DYNAMIC_DRAW);
-
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vector2f), 0);
-    glEnableVertexAttribArray(0);
-
-    // glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    Shader preview_shader(SHADER_DIR"/preview.vert", SHADER_DIR"/point.frag");
+    // the preview has no vertex attributes, but core profile draws need a vertex array bound
+    uint32_t preview_VAO;
+    glGenVertexArrays(1, &preview_VAO);
+
+    drawn_points = std::make_unique<VertexStore>(GL_POINTS);
+    drawn_lines = std::make_unique<VertexStore>(GL_LINES);
+    selected_points = std::make_unique<VertexStore>(GL_POINTS);
+    selected_lines = std::make_unique<VertexStore>(GL_LINES);
+    occupancy = std::make_unique<OccupancyBitmap>(SCR_WIDTH, SCR_HEIGHT);
+    int fb_width, fb_height;
+    glfwGetFramebufferSize(window, &fb_width, &fb_height);
+    canvas = std::make_unique<Canvas>(fb_width, fb_height);
+
+    // --stress <n> starts with random lines of about n points in total, to time frames with a large
+    // drawing; --load <file> opens a saved drawing
+    if (argc > 2 && std::string(argv[1]) == "--stress") {
+        fill_stress_primitives(std::strtoull(argv[2], nullptr, 10));
+    } else if (argc > 2 && std::string(argv[1]) == "--load") {
+        load_primitives(argv[2], primitives);
+    }
+    rebuild_drawing(window);
+    double report_time = glfwGetTime();
+    uint32_t report_frames = 0;
+    std::clock_t report_cpu = std::clock();
+    double latency_sum = 0.0, latency_max = 0.0;
+    uint32_t latency_num = 0;
+    double cpu_percent = 0.0, asleep_percent = 0.0, latency_ms = 0.0;
+    FrameScheduler scheduler;
+    double report_asleep = 0.0;
+    // operator new calls per frame, the scratch of the callbacks comes from the frame arena
+    uint64_t frame_allocations = 0, report_allocations = 0;
+    uint64_t allocations_before = heap_allocation_count();
 
     while (!glfwWindowShouldClose(window)) {
+        Arena::local().reset();
         process_input(window);
 
         ImGui_ImplOpenGL3_NewFrame();
@@ -102,26 +202,149 @@ int main(int argc, char **argv) {
         ImGui::RadioButton("line (dda)", reinterpret_cast<int *>(&mode), (int)DrawMode::line_dda);
         ImGui::RadioButton("line (bresenham)", reinterpret_cast<int *>(&mode), (int)DrawMode::line_bresenham);
         ImGui::RadioButton("ellipse", reinterpret_cast<int *>(&mode), (int)DrawMode::ellipse);
+        ImGui::RadioButton("select", reinterpret_cast<int *>(&mode), (int)DrawMode::select);
+        ImGui::SameLine();
+        ImGui::RadioButton("erase", reinterpret_cast<int *>(&mode), (int)DrawMode::erase);
+        ImGui::Checkbox("span output", &use_spans);
+        ImGui::Checkbox("filled ellipse", &fill_ellipse);
+        if (ImGui::Checkbox("skip covered pixels", &dedupe_pixels)) {
+            rebuild_drawing(window);
+        }
+        if (ImGui::Checkbox("render on demand", &on_demand)) {
+            scheduler.set_on_demand(on_demand);
+        }
+        ImGui::Text("%.0f%% cpu, %.0f%% asleep, %.1f ms input to swap", cpu_percent, asleep_percent, latency_ms);
+        ImGui::Text("%llu heap allocations last frame, %.0f KB frame arena",
+                    static_cast<unsigned long long>(frame_allocations), Arena::local().capacity() / 1024.0);
+        ImGui::Text("%llu point vertices, %llu span vertices",
+                    static_cast<unsigned long long>(drawn_points->size()),
+                    static_cast<unsigned long long>(drawn_lines->size()));
+        ImGui::Text("%zu chunks, %.1f MB", drawn_points->chunk_count() + drawn_lines->chunk_count(),
+                    static_cast<double>(drawn_points->gpu_bytes() + drawn_lines->gpu_bytes()) / (1 << 20));
+        ImGui::Text("%zu primitives, zoom %.2f, rebuilt in %.1f ms", grid.size(), zoom, rebuild_ms);
+        ImGui::Text("%zu selected, %zu grid cells, query %.1f us", selection.size(), grid.cell_count(), query_us);
+        if (ImGui::Button("save")) {
+            save_primitives(DRAWING_FILE, live_primitives());
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("load") && load_primitives(DRAWING_FILE, primitives)) {
+            stored.clear();
+            selection.clear();
+            grid.clear();
+            rebuild_drawing(window);
+        }
         ImGui::End();
 
-        glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+        // moving vertices between chunks doesn't change the canvas, but the next frames go on with it
+        uint32_t moved = drawn_points->compact(COMPACT_BUDGET);
+        moved += drawn_lines->compact(COMPACT_BUDGET);
+        if (moved > 0) {
+            scheduler.request_redraw(1);
+        }
 
         shader.use_program();
-        glBindVertexArray(VAO);
-        // std::cout << drawn_size << ", " << drawing_size << std::endl;
-        glDrawArrays(GL_POINTS, 0, drawn_size + drawing_size);
+        if (canvas_dirty || !new_points.empty() || !new_lines.empty()) {
+            canvas->begin();
+            if (canvas_dirty) {
+                canvas->clear(1.0f, 1.0f, 1.0f, 1.0f);
+                drawn_points->draw();
+                drawn_lines->draw();
+            } else {
+                for (auto handle : new_points) {
+                    drawn_points->draw(handle);
+                }
+                for (auto handle : new_lines) {
+                    drawn_lines->draw(handle);
+                }
+            }
+            canvas->end();
+            canvas_dirty = false;
+            new_points.clear();
+            new_lines.clear();
+        }
+        canvas->present();
+        if (!selection.empty()) {
+            shader.set_vec3("color", 0.9f, 0.3f, 0.1f);
+            selected_points->draw();
+            selected_lines->draw();
+            shader.set_vec3("color", 0.0f, 0.0f, 0.0f);
+        }
+        if (pressing && mode != DrawMode::erase) {
+            int width, height;
+            glfwGetWindowSize(window, &width, &height);
+            glBindVertexArray(preview_VAO);
+            preview_shader.use_program();
+            if (mode == DrawMode::select) {
+                // the selection rectangle, one line per side
+                preview_shader.set_vec3("color", 0.2f, 0.4f, 0.9f);
+                Pixel corners[4] = {start, Pixel(end.x, start.y), end, Pixel(start.x, end.y)};
+                for (int i = 0; i < 4; ++i) {
+                    draw_preview(preview_shader, {PrimitiveType::line_bresenham, 0, corners[i], corners[(i + 1) % 4]}, width, height);
+                }
+            } else {
+                preview_shader.set_vec3("color", 0.0f, 0.0f, 0.0f);
+                draw_preview(preview_shader, current_primitive(), width, height);
+            }
+            glBindVertexArray(0);
+        }
 
         ImGui::Render();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
         glfwSwapBuffers(window);
-        glfwPollEvents();
+        double now = glfwGetTime();
+        if (preview_input_time >= 0.0) {
+            double latency = now - preview_input_time;
+            latency_sum += latency;
+            latency_max = std::max(latency_max, latency);
+            latency_num++;
+            preview_input_time = -1.0;
+        }
+        scheduler.wait_events();
+        // the sleep belongs to this frame
+        now = glfwGetTime();
+
+        uint64_t allocations = heap_allocation_count();
+        frame_allocations = allocations - allocations_before;
+        report_allocations += frame_allocations;
+        allocations_before = allocations;
+        report_frames++;
+        if (now - report_time >= 1.0) {
+            std::clock_t cpu = std::clock();
+            cpu_percent = 100.0 * static_cast<double>(cpu - report_cpu) / CLOCKS_PER_SEC / (now - report_time);
+            asleep_percent = 100.0 * (scheduler.sleep_seconds() - report_asleep) / (now - report_time);
+            latency_ms = latency_num > 0 ? latency_sum * 1000.0 / latency_num : 0.0;
+            std::cout << "[I] " << (now - report_time) * 1000.0 / report_frames << " ms/frame, "
+                      << cpu_percent << "% cpu, " << asleep_percent << "% asleep"
+                      << (scheduler.idle() ? " (idle), " : ", ")
+                      << drawn_points->size() + drawn_lines->size() << " stored vertices in "
+                      << drawn_points->chunk_count() + drawn_lines->chunk_count() << " chunks, "
+                      << static_cast<double>(report_allocations) / report_frames << " heap allocations/frame";
+            if (latency_num > 0) {
+                std::cout << ", " << cursor_events << " cursor events, input to swap "
+                          << latency_ms << " ms avg " << latency_max * 1000.0 << " ms max";
+            }
+            std::cout << std::endl;
+            report_time = now;
+            report_frames = 0;
+            report_cpu = cpu;
+            report_asleep = scheduler.sleep_seconds();
+            latency_sum = latency_max = 0.0;
+            latency_num = 0;
+            cursor_events = 0;
+            report_allocations = 0;
+        }
     }
 
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
+    // the stores and the canvas delete their GL objects, while the context is still alive
+    canvas.reset();
+    drawn_points.reset();
+    drawn_lines.reset();
+    selected_points.reset();
+    selected_lines.reset();
+    glDeleteVertexArrays(1, &preview_VAO);
     shader.delete_program();
+    preview_shader.delete_program();
 
     glfwTerminate();
     return 0;
@@ -131,10 +354,27 @@ void process_input(GLFWwindow *window) {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
         glfwSetWindowShouldClose(window, true);
     }
+    if (glfwGetKey(window, GLFW_KEY_DELETE) == GLFW_PRESS && !selection.empty()) {
+        erase_primitives(window, std::pmr::vector<uint32_t>(selection));
+    }
 }
 
 void framebuffer_size_callback(GLFWwindow *window, int width, int height) {
     glViewport(0, 0, width, height);
+    // minimized windows report 0x0
+    if (canvas && width > 0 && height > 0) {
+        canvas->resize(width, height);
+        rebuild_drawing(window);
+    }
+}
+
+void scroll_callback(GLFWwindow *window, double xoffset, double yoffset) {
+    ImGuiIO& io = ImGui::GetIO();
+    if (io.WantCaptureMouse || pressing || yoffset == 0.0) {
+        return;
+    }
+    zoom = std::min(16.0f, std::max(1.0f / 16.0f, zoom * std::pow(1.25f, static_cast<float>(yoffset))));
+    rebuild_drawing(window);
 }
 
 void mouse_button_callback(GLFWwindow *window, int button, int action, int mods) {
@@ -148,33 +388,54 @@ void mouse_button_callback(GLFWwindow *window, int button, int action, int mods)
 
         double xpos, ypos;
         glfwGetCursorPos(window, &xpos, &ypos);
-        start.x = end.x = static_cast<int>(xpos);
-        start.y = end.y = static_cast<int>(ypos);
+        start.x = end.x = static_cast<int>(std::floor(xpos / zoom));
+        start.y = end.y = static_cast<int>(std::floor(ypos / zoom));
+        if (mode == DrawMode::erase) {
+            erase_at(window, xpos, ypos);
+        }
     } else if (action == GLFW_RELEASE) {
         pressing = 0;
-        
-        int width, height;
-        glfwGetWindowSize(window, &width, &height);
-        std::vector<Pixel> pixels;
-        std::vector<Vector2f> vertices;
-        if (mode == DrawMode::line_dda) {
-            draw_line_dda(start, end, pixels);
-        } else if (mode == DrawMode::line_bresenham) {
-            draw_line_bresenham(start, end, pixels);
-        } else if (mode == DrawMode::ellipse) {
-            draw_ellipse(start, end, pixels);
+        if (mode == DrawMode::erase) {
+            return;
         }
-        for (auto& pixel : pixels) {
-            vertices.emplace_back(pixel.to_vertex(width, height));
+        if (mode == DrawMode::select) {
+            auto begin = std::chrono::steady_clock::now();
+            if (start == end) {
+                // a click takes the topmost primitive under the cursor
+                double xpos, ypos;
+                glfwGetCursorPos(window, &xpos, &ypos);
+                std::pmr::vector<uint32_t> hits(&Arena::local());
+                pick(xpos, ypos, hits);
+                selection.clear();
+                if (!hits.empty()) {
+                    selection.push_back(*std::max_element(hits.begin(), hits.end()));
+                }
+            } else {
+                Bounds area{std::min(start.x, end.x), std::min(start.y, end.y), std::max(start.x, end.x), std::max(start.y, end.y)};
+                selection.clear();
+                grid.query(area, selection);
+                selection.erase(std::remove_if(selection.begin(), selection.end(), [&](uint32_t id) {
+                    return !intersects(primitives[id], area);
+                }), selection.end());
+                std::sort(selection.begin(), selection.end());
+            }
+            query_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+            update_selection(window);
+            return;
         }
 
-        if (drawn_size + drawing_size < SUP_DRAW_NUM) {
-            glBufferSubData(GL_ARRAY_BUFFER, drawn_size * sizeof(Vector2f), vertices.size() * sizeof(Vector2f), vertices.data());
-            drawn_size += vertices.size();
-        } else {
-            std::cerr << "[E] Too many points to display!" << std::endl;
-        }
-        drawing_size = 0;
+        int width, height;
+        glfwGetWindowSize(window, &width, &height);
+        auto id = static_cast<uint32_t>(primitives.size());
+        primitives.push_back(current_primitive());
+        grid.insert(id, bounds(primitives.back()));
+        ArenaScope scope;
+        std::pmr::vector<Vector2f> points(scope.resource()), lines(scope.resource());
+        rasterize(primitives.back(), width, height, zoom, points, lines, dedupe_pixels ? occupancy.get() : nullptr);
+
+        stored.push_back({drawn_points->append(points), drawn_lines->append(lines), true});
+        new_points.push_back(stored.back().points);
+        new_lines.push_back(stored.back().lines);
     }
 }
 
@@ -185,32 +446,267 @@ void cursor_pos_callback(GLFWwindow *window, double xpos, double ypos) {
     }
 
     if (pressing) {
-        end.x = static_cast<int>(xpos);
-        end.y = static_cast<int>(ypos);
+        end.x = static_cast<int>(std::floor(xpos / zoom));
+        end.y = static_cast<int>(std::floor(ypos / zoom));
+        if (mode == DrawMode::erase) {
+            erase_at(window, xpos, ypos);
+        }
+        cursor_events++;
+        // the oldest event not on screen yet
+        if (preview_input_time < 0.0) {
+            preview_input_time = glfwGetTime();
+        }
+    }
+}
 
-        int width, height;
-        glfwGetWindowSize(window, &width, &height);
-        std::vector<Pixel> pixels;
-        std::vector<Vector2f> vertices;
-        if (mode == DrawMode::line_dda) {
-            draw_line_dda(start, end, pixels);
-        } else if (mode == DrawMode::line_bresenham) {
-            draw_line_bresenham(start, end, pixels);
-        } else if (mode == DrawMode::ellipse) {
-            draw_ellipse(start, end, pixels);
+Primitive current_primitive() {
+    Primitive primitive;
+    switch (mode) {
+    case DrawMode::line_dda:
+        primitive.type = PrimitiveType::line_dda;
+        break;
+    case DrawMode::line_bresenham:
+        primitive.type = PrimitiveType::line_bresenham;
+        break;
+    case DrawMode::ellipse:
+        primitive.type = fill_ellipse ? PrimitiveType::filled_ellipse : PrimitiveType::ellipse;
+        break;
+    default:
+        // the select and erase tools don't commit anything
+        primitive.type = PrimitiveType::line_bresenham;
+        break;
+    }
+    primitive.flags = use_spans ? Primitive::SPANS : 0;
+    primitive.start = start;
+    primitive.end = end;
+    return primitive;
+}
+
+Pixel to_window(Pixel p) {
+    return Pixel(static_cast<int>(std::lround(p.x * zoom)), static_cast<int>(std::lround(p.y * zoom)));
+}
+
+void draw_preview(Shader& preview_shader, const Primitive& primitive, int width, int height) {
+    Pixel a = to_window(primitive.start);
+    Pixel b = to_window(primitive.end);
+    int semi_x = abs(b.x - a.x);
+    int semi_y = abs(b.y - a.y);
+    GLenum draw_mode = GL_POINTS;
+    int count;
+    switch (primitive.type) {
+    case PrimitiveType::line_dda:
+    case PrimitiveType::line_bresenham:
+        count = static_cast<int>(line_pixel_count(a, b));
+        break;
+    case PrimitiveType::ellipse:
+        // more samples than pixels on the outline, the perimeter is below 4 (a + b)
+        count = 4 * (semi_x + semi_y) + 4;
+        break;
+    case PrimitiveType::filled_ellipse:
+        draw_mode = GL_LINES;
+        count = 2 * (2 * semi_y + 1);
+        break;
+    }
+
+    preview_shader.use_program();
+    preview_shader.set_int("mode", static_cast<int>(primitive.type));
+    preview_shader.set_ivec2("start", a.x, a.y);
+    preview_shader.set_ivec2("end", b.x, b.y);
+    preview_shader.set_ivec2("viewport", width, height);
+    preview_shader.set_int("vertex_count", count);
+    glDrawArrays(draw_mode, 0, count);
+}
+
+void rebuild_drawing(GLFWwindow *window) {
+    auto begin = std::chrono::steady_clock::now();
+    int width, height;
+    glfwGetWindowSize(window, &width, &height);
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+    // the erased primitives are dropped here, the selection follows the new indices; loaded and
+    // generated primitives have no record yet
+    std::vector<uint32_t> remap(primitives.size(), ChunkAllocator::NONE);
+    size_t kept = 0;
+    for (size_t i = 0; i < primitives.size(); ++i) {
+        if (i >= stored.size() || stored[i].live) {
+            remap[i] = static_cast<uint32_t>(kept);
+            primitives[kept++] = primitives[i];
         }
-        for (auto& pixel : pixels) {
-            vertices.emplace_back(pixel.to_vertex(width, height));
+    }
+    bool reindex = kept != primitives.size() || grid.size() != kept;
+    primitives.resize(kept);
+    for (auto& id : selection) {
+        id = remap[id];
+    }
+
+    if (occupancy->width() != width || occupancy->height() != height) {
+        occupancy->resize(width, height);
+    } else {
+        occupancy->clear();
+    }
+    // the whole drawing at once, on the heap rather than in the frame arena
+    std::pmr::vector<Vector2f> points, lines;
+    std::vector<uint32_t> point_ends, line_ends;
+    rasterize_parallel(primitives, width, height, zoom, points, lines, 0, dedupe_pixels ? occupancy.get() : nullptr,
+                       &point_ends, &line_ends);
+
+    drawn_points->clear();
+    drawn_lines->clear();
+    std::vector<uint32_t> point_handles, line_handles;
+    drawn_points->append(points, point_ends, point_handles);
+    drawn_lines->append(lines, line_ends, line_handles);
+    stored.resize(primitives.size());
+    for (size_t i = 0; i < primitives.size(); ++i) {
+        stored[i] = {point_handles[i], line_handles[i], true};
+    }
+    patches.clear();
+    // the grid is in canvas pixels, zooming and resizing keep it
+    if (reindex) {
+        grid.clear();
+        for (size_t i = 0; i < primitives.size(); ++i) {
+            grid.insert(static_cast<uint32_t>(i), bounds(primitives[i]));
         }
-        drawing_size = vertices.size();
+    }
+    new_points.clear();
+    new_lines.clear();
+    canvas_dirty = true;
+    update_selection(window);
+    rebuild_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
 
-        if (drawn_size + drawing_size < SUP_DRAW_NUM) {
-            glBufferSubData(GL_ARRAY_BUFFER, drawn_size * sizeof(Vector2f), (SUP_DRAW_NUM - drawn_size) * sizeof(Vector2f), nullptr);
-            glBufferSubData(GL_ARRAY_BUFFER, drawn_size * sizeof(Vector2f), vertices.size() * sizeof(Vector2f), vertices.data());
-        } else {
-            std::cerr << "[E] Too many points to display!" << std::endl;
+void pick(double xpos, double ypos, std::pmr::vector<uint32_t>& ids) {
+    auto begin = std::chrono::steady_clock::now();
+    // the canvas point under the cursor, pixel p is drawn around p + 0.5 in window pixels at zoom 1
+    float x = static_cast<float>((xpos - 0.5) / zoom);
+    float y = static_cast<float>((ypos - 0.5) / zoom);
+    float radius = PICK_RADIUS / zoom;
+    // hit_test reaches half a pixel further
+    Bounds area{static_cast<int>(std::floor(x - radius)) - 1, static_cast<int>(std::floor(y - radius)) - 1,
+                static_cast<int>(std::ceil(x + radius)) + 1, static_cast<int>(std::ceil(y + radius)) + 1};
+    ids.clear();
+    grid.query(area, ids);
+    ids.erase(std::remove_if(ids.begin(), ids.end(), [&](uint32_t id) {
+        return !hit_test(primitives[id], x, y, radius);
+    }), ids.end());
+    query_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+}
+
+void erase_at(GLFWwindow *window, double xpos, double ypos) {
+    ArenaScope scope;
+    std::pmr::vector<uint32_t> ids(scope.resource());
+    pick(xpos, ypos, ids);
+    erase_primitives(window, ids);
+}
+
+void erase_primitives(GLFWwindow *window, const std::pmr::vector<uint32_t>& ids) {
+    if (ids.empty()) {
+        return;
+    }
+    int width, height;
+    glfwGetWindowSize(window, &width, &height);
+    // the rasterizers fill std::vectors, these keep their capacity from one erase to the next
+    static std::vector<Pixel> pixels;
+    static std::vector<Span> spans;
+    ArenaScope scope;
+    std::pmr::vector<uint32_t> neighbours(scope.resource());
+    // rounding to window pixels can bring shapes of neighbouring canvas pixels together
+    int margin = static_cast<int>(std::ceil(1.0f / zoom)) + 1;
+    for (auto id : ids) {
+        auto& record = stored[id];
+        if (!record.live) {
+            continue;
+        }
+        drawn_points->erase(record.points);
+        drawn_lines->erase(record.lines);
+        record.live = false;
+        auto range = patches.equal_range(id);
+        for (auto it = range.first; it != range.second; ++it) {
+            drawn_points->erase(it->second.points);
+            drawn_lines->erase(it->second.lines);
+        }
+        patches.erase(id);
+        grid.remove(id);
+        if (dedupe_pixels) {
+            // its pixels are free again, whatever else covers them draws them
+            rasterize_pixels(primitives[id], width, height, zoom, pixels, spans);
+            occupancy->clear(pixels);
+            occupancy->clear(spans);
+            auto area = bounds(primitives[id]);
+            grid.query({area.min_x - margin, area.min_y - margin, area.max_x + margin, area.max_y + margin}, neighbours);
+        }
+    }
+    std::sort(neighbours.begin(), neighbours.end());
+    neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+    std::pmr::vector<Vector2f> points(scope.resource()), lines(scope.resource());
+    for (auto id : neighbours) {
+        points.clear();
+        lines.clear();
+        rasterize(primitives[id], width, height, zoom, points, lines, occupancy.get());
+        if (!points.empty() || !lines.empty()) {
+            patches.emplace(id, StoredPrimitive{drawn_points->append(points), drawn_lines->append(lines), true});
         }
     }
+
+    size_t selected = selection.size();
+    selection.erase(std::remove_if(selection.begin(), selection.end(), [](uint32_t id) {
+        return !stored[id].live;
+    }), selection.end());
+    if (selection.size() != selected) {
+        update_selection(window);
+    }
+    // the canvas is drawn again from the stores, nothing else is rasterized
+    canvas_dirty = true;
+}
+
+void update_selection(GLFWwindow *window) {
+    selected_points->clear();
+    selected_lines->clear();
+    if (selection.empty()) {
+        return;
+    }
+    int width, height;
+    glfwGetWindowSize(window, &width, &height);
+    std::vector<Primitive> selected;
+    selected.reserve(selection.size());
+    for (auto id : selection) {
+        selected.push_back(primitives[id]);
+    }
+    std::pmr::vector<Vector2f> points, lines;
+    rasterize_parallel(selected, width, height, zoom, points, lines);
+    selected_points->append(points);
+    selected_lines->append(lines);
+}
+
+std::vector<Primitive> live_primitives() {
+    std::vector<Primitive> live;
+    live.reserve(grid.size());
+    for (size_t i = 0; i < primitives.size(); ++i) {
+        if (i >= stored.size() || stored[i].live) {
+            live.push_back(primitives[i]);
+        }
+    }
+    return live;
+}
+
+void fill_stress_primitives(uint64_t count) {
+    // lines of up to 200 pixels over the window, like a long drawing session
+    uint32_t seed = 1;
+    auto next = [&](uint32_t range) {
+        seed = seed * 1664525u + 1013904223u;
+        return static_cast<int>((seed >> 8) % range);
+    };
+    uint64_t points = 0;
+    while (points < count) {
+        Primitive primitive;
+        primitive.type = PrimitiveType::line_bresenham;
+        primitive.flags = 0;
+        primitive.start = Pixel(next(SCR_WIDTH), next(SCR_HEIGHT));
+        primitive.end = Pixel(primitive.start.x + next(401) - 200, primitive.start.y + next(401) - 200);
+        primitives.push_back(primitive);
+        points += line_pixel_count(primitive.start, primitive.end);
+    }
+    std::cout << "[I] " << primitives.size() << " stress lines, about " << points << " points" << std::endl;
 }
 
 void error_callback(int code, const char *description) {
@@ -0,0 +1,100 @@
+#include "occupancy.h"
+
+#include <algorithm>
+#include <cstddef>
+
+OccupancyBitmap::OccupancyBitmap(int width, int height) {
+    resize(width, height);
+}
+
+void OccupancyBitmap::resize(int width, int height) {
+    bitmap_width = width;
+    bitmap_height = height;
+    row_words = (static_cast<size_t>(width) + 63) / 64;
+    words = std::make_unique<std::atomic<uint64_t>[]>(row_words * height);
+    clear();
+}
+
+void OccupancyBitmap::clear() {
+    for (size_t i = 0; i < row_words * bitmap_height; ++i) {
+        words[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void OccupancyBitmap::clear(const std::vector<Pixel>& pixels) {
+    for (const auto& pixel : pixels) {
+        words[pixel.y * row_words + pixel.x / 64].fetch_and(~(uint64_t(1) << (pixel.x % 64)), std::memory_order_relaxed);
+    }
+}
+
+void OccupancyBitmap::clear(const std::vector<Span>& spans) {
+    for (const auto& span : spans) {
+        auto *row = &words[span.y * row_words];
+        for (int x = span.x_begin; x < span.x_end; ) {
+            int bit = x % 64;
+            int n = std::min(64 - bit, span.x_end - x);
+            uint64_t mask = (n == 64 ? ~uint64_t(0) : ((uint64_t(1) << n) - 1)) << bit;
+            row[x / 64].fetch_and(~mask, std::memory_order_relaxed);
+            x += n;
+        }
+    }
+}
+
+bool OccupancyBitmap::test(int x, int y) const {
+    auto word = words[y * row_words + x / 64].load(std::memory_order_relaxed);
+    return (word >> (x % 64)) & 1;
+}
+
+bool OccupancyBitmap::test_and_set(int x, int y) {
+    uint64_t bit = uint64_t(1) << (x % 64);
+    return !(words[y * row_words + x / 64].fetch_or(bit, std::memory_order_relaxed) & bit);
+}
+
+void OccupancyBitmap::filter(std::vector<Pixel>& pixels) {
+    size_t kept = 0;
+    for (const auto& pixel : pixels) {
+        if (test_and_set(pixel.x, pixel.y)) {
+            pixels[kept++] = pixel;
+        }
+    }
+    pixels.resize(kept);
+}
+
+void OccupancyBitmap::filter(std::vector<Span>& spans) {
+    // the runs of new pixels go to the end and are moved down once the input is read
+    size_t count = spans.size();
+    for (size_t i = 0; i < count; ++i) {
+        Span span = spans[i];
+        auto *row = &words[span.y * row_words];
+        int run_begin = -1;
+        for (int x = span.x_begin; x < span.x_end; ) {
+            int bit = x % 64;
+            int n = std::min(64 - bit, span.x_end - x);
+            uint64_t mask = (n == 64 ? ~uint64_t(0) : ((uint64_t(1) << n) - 1)) << bit;
+            uint64_t fresh = ~row[x / 64].fetch_or(mask, std::memory_order_relaxed) & mask;
+            if (fresh == mask) {
+                // the common case of a span over empty pixels, the run just continues
+                if (run_begin < 0) {
+                    run_begin = x;
+                }
+            } else {
+                // walk the word bit by bit: runs start at set bits of fresh and stop at clear ones
+                for (int b = bit; b < bit + n; ++b) {
+                    bool is_fresh = (fresh >> b) & 1;
+                    int px = x - bit + b;
+                    if (is_fresh && run_begin < 0) {
+                        run_begin = px;
+                    } else if (!is_fresh && run_begin >= 0) {
+                        spans.emplace_back(span.y, run_begin, px);
+                        run_begin = -1;
+                    }
+                }
+            }
+            x += n;
+        }
+        if (run_begin >= 0) {
+            spans.emplace_back(span.y, run_begin, span.x_end);
+        }
+    }
+    spans.erase(spans.begin(), spans.begin() + static_cast<std::ptrdiff_t>(count));
+}
@@ -0,0 +1,45 @@
+#ifndef OCCUPANCY_H
+#define OCCUPANCY_H
+
+#pragma once
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "utils.h"
+
+// One bit per window pixel, set once the pixel has been uploaded. The filters drop what is already
+// covered, so overlapping strokes only append the pixels they add. Rows are padded to whole 64 bit
+// words and a span tests and sets a word at a time. The words are atomic: threads can filter
+// concurrently, each pixel is then kept by exactly one of them.
+class OccupancyBitmap {
+public:
+    OccupancyBitmap(int width, int height);
+
+    // also clears it
+    void resize(int width, int height);
+    void clear();
+    // only these pixels, when an erased primitive gives them back
+    void clear(const std::vector<Pixel>& pixels);
+    void clear(const std::vector<Span>& spans);
+
+    bool test(int x, int y) const;
+    // true when the pixel wasn't set before
+    bool test_and_set(int x, int y);
+
+    // Keep the pixels and the parts of spans that were not set, and set them. Everything must be
+    // inside the bitmap, as the clipped rasterizers produce it. Spans are split around covered pixels.
+    void filter(std::vector<Pixel>& pixels);
+    void filter(std::vector<Span>& spans);
+
+    int width() const { return bitmap_width; }
+    int height() const { return bitmap_height; }
+
+private:
+    int bitmap_width = 0;
+    int bitmap_height = 0;
+    size_t row_words = 0;
+    std::unique_ptr<std::atomic<uint64_t>[]> words;
+};
+
+#endif // OCCUPANCY_H
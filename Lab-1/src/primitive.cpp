@@ -0,0 +1,364 @@
+#include "primitive.h"
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include "rasterization.h"
+
+static Pixel to_window(Pixel p, float zoom) {
+    return Pixel(static_cast<int>(std::lround(p.x * zoom)), static_cast<int>(std::lround(p.y * zoom)));
+}
+
+bool Bounds::intersects(const Bounds& other) const {
+    return min_x <= other.max_x && other.min_x <= max_x && min_y <= other.max_y && other.min_y <= max_y;
+}
+
+Bounds bounds(const Primitive& primitive) {
+    if (primitive.type == PrimitiveType::ellipse || primitive.type == PrimitiveType::filled_ellipse) {
+        int a = abs(primitive.end.x - primitive.start.x);
+        int b = abs(primitive.end.y - primitive.start.y);
+        return {primitive.start.x - a, primitive.start.y - b, primitive.start.x + a, primitive.start.y + b};
+    }
+    return {std::min(primitive.start.x, primitive.end.x), std::min(primitive.start.y, primitive.end.y),
+            std::max(primitive.start.x, primitive.end.x), std::max(primitive.start.y, primitive.end.y)};
+}
+
+static float segment_distance2(float x, float y, Pixel a, Pixel b) {
+    float dx = static_cast<float>(b.x - a.x), dy = static_cast<float>(b.y - a.y);
+    float px = x - static_cast<float>(a.x), py = y - static_cast<float>(a.y);
+    float length2 = dx * dx + dy * dy;
+    float t = length2 > 0.0f ? std::min(1.0f, std::max(0.0f, (px * dx + py * dy) / length2)) : 0.0f;
+    float ex = px - t * dx, ey = py - t * dy;
+    return ex * ex + ey * ey;
+}
+
+bool hit_test(const Primitive& primitive, float x, float y, float radius) {
+    // pixels are drawn around their integer coordinates
+    radius += 0.5f;
+    // nothing outside the bounds, which the approximate ellipse distance below could claim
+    auto box = bounds(primitive);
+    if (x < static_cast<float>(box.min_x) - radius || x > static_cast<float>(box.max_x) + radius ||
+        y < static_cast<float>(box.min_y) - radius || y > static_cast<float>(box.max_y) + radius) {
+        return false;
+    }
+    if (primitive.type == PrimitiveType::line_dda || primitive.type == PrimitiveType::line_bresenham) {
+        return segment_distance2(x, y, primitive.start, primitive.end) <= radius * radius;
+    }
+    float a = static_cast<float>(abs(primitive.end.x - primitive.start.x));
+    float b = static_cast<float>(abs(primitive.end.y - primitive.start.y));
+    Pixel c = primitive.start;
+    if (a == 0.0f || b == 0.0f) {
+        // a flat ellipse is a segment through the center
+        return segment_distance2(x, y, Pixel(c.x - static_cast<int>(a), c.y - static_cast<int>(b)),
+                                Pixel(c.x + static_cast<int>(a), c.y + static_cast<int>(b))) <= radius * radius;
+    }
+    float u = (x - static_cast<float>(c.x)) / a, v = (y - static_cast<float>(c.y)) / b;
+    float r = std::sqrt(u * u + v * v);
+    if (primitive.type == PrimitiveType::filled_ellipse && r <= 1.0f) {
+        return true;
+    }
+    if (r == 0.0f) {
+        return std::min(a, b) <= radius;
+    }
+    // first order distance to the outline, |r - 1| over the gradient of r
+    float gradient = std::sqrt(u * u / (a * a) + v * v / (b * b)) / r;
+    return std::abs(r - 1.0f) <= radius * gradient;
+}
+
+bool intersects(const Primitive& primitive, const Bounds& area) {
+    float min_x = static_cast<float>(area.min_x) - 0.5f, max_x = static_cast<float>(area.max_x) + 0.5f;
+    float min_y = static_cast<float>(area.min_y) - 0.5f, max_y = static_cast<float>(area.max_y) + 0.5f;
+    if (!bounds(primitive).intersects(area)) {
+        return false;
+    }
+    if (primitive.type == PrimitiveType::line_dda || primitive.type == PrimitiveType::line_bresenham) {
+        // Liang-Barsky, the segment is kept if some part of it is left inside
+        float x0 = static_cast<float>(primitive.start.x), y0 = static_cast<float>(primitive.start.y);
+        float dx = static_cast<float>(primitive.end.x) - x0, dy = static_cast<float>(primitive.end.y) - y0;
+        float t0 = 0.0f, t1 = 1.0f;
+        float p[4] = {-dx, dx, -dy, dy};
+        float q[4] = {x0 - min_x, max_x - x0, y0 - min_y, max_y - y0};
+        for (int i = 0; i < 4; ++i) {
+            if (p[i] == 0.0f) {
+                if (q[i] < 0.0f) {
+                    return false;
+                }
+            } else if (p[i] < 0.0f) {
+                t0 = std::max(t0, q[i] / p[i]);
+            } else {
+                t1 = std::min(t1, q[i] / p[i]);
+            }
+        }
+        return t0 <= t1;
+    }
+    float a = static_cast<float>(abs(primitive.end.x - primitive.start.x));
+    float b = static_cast<float>(abs(primitive.end.y - primitive.start.y));
+    float cx = static_cast<float>(primitive.start.x), cy = static_cast<float>(primitive.start.y);
+    if (a == 0.0f || b == 0.0f) {
+        // flat, the bounds are the shape
+        return true;
+    }
+    auto inside = [&](float x, float y) {
+        float u = (x - cx) / a, v = (y - cy) / b;
+        return u * u + v * v <= 1.0f;
+    };
+    // the point of the area nearest to the center must be inside the ellipse
+    if (!inside(std::min(max_x, std::max(min_x, cx)), std::min(max_y, std::max(min_y, cy)))) {
+        return false;
+    }
+    // and an outline only crosses an area that doesn't lie wholly inside it
+    return primitive.type == PrimitiveType::filled_ellipse ||
+           !(inside(min_x, min_y) && inside(max_x, min_y) && inside(min_x, max_y) && inside(max_x, max_y));
+}
+
+// A span is two vertices, so a run of one pixel is cheaper as a point: steep lines and the sides of
+// ellipses stay points and span output never uploads more vertices than points do.
+static void split_single_pixels(std::vector<Span>& spans, std::vector<Pixel>& pixels) {
+    size_t kept = 0;
+    for (const auto& span : spans) {
+        if (span.length() == 1) {
+            pixels.emplace_back(span.x_begin, span.y);
+        } else {
+            spans[kept++] = span;
+        }
+    }
+    spans.resize(kept);
+}
+
+void rasterize_pixels(const Primitive& primitive, int width, int height, float zoom,
+                      std::vector<Pixel>& pixels, std::vector<Span>& spans) {
+    pixels.clear();
+    spans.clear();
+
+    Pixel start = to_window(primitive.start, zoom);
+    Pixel end = to_window(primitive.end, zoom);
+    bool use_spans = primitive.flags & Primitive::SPANS;
+    // the cursor keeps reporting positions outside the window while dragging
+    ClipRect clip(width, height);
+    switch (primitive.type) {
+    case PrimitiveType::filled_ellipse:
+        fill_ellipse_spans(start, end, spans, clip);
+        if (!use_spans) {
+            for (const auto& span : spans) {
+                for (int x = span.x_begin; x < span.x_end; ++x) {
+                    pixels.emplace_back(x, span.y);
+                }
+            }
+            spans.clear();
+        }
+        break;
+    case PrimitiveType::line_bresenham:
+        if (use_spans) {
+            draw_line_spans(start, end, spans, clip);
+        } else {
+            draw_line_bresenham(start, end, pixels, clip);
+        }
+        break;
+    case PrimitiveType::ellipse:
+        if (use_spans) {
+            draw_ellipse_spans(start, end, spans, clip);
+        } else {
+            draw_ellipse(start, end, pixels, clip);
+        }
+        break;
+    case PrimitiveType::line_dda:
+        draw_line_dda(start, end, pixels, clip);
+        if (use_spans) {
+            append_spans(pixels.data(), pixels.size(), spans);
+            pixels.clear();
+        }
+        break;
+    }
+    split_single_pixels(spans, pixels);
+}
+
+void rasterize(const Primitive& primitive, int width, int height, float zoom,
+               std::pmr::vector<Vector2f>& points, std::pmr::vector<Vector2f>& lines, OccupancyBitmap *occupancy) {
+    // thread local scratch, the parallel rasterization calls this once per primitive
+    thread_local std::vector<Pixel> pixels;
+    thread_local std::vector<Span> spans;
+    rasterize_pixels(primitive, width, height, zoom, pixels, spans);
+    if (occupancy) {
+        occupancy->filter(pixels);
+        // the covered pixels cut spans into shorter runs, single ones among them
+        occupancy->filter(spans);
+        split_single_pixels(spans, pixels);
+    }
+    for (auto& pixel : pixels) {
+        points.emplace_back(pixel.to_vertex(width, height));
+    }
+    for (const auto& span : spans) {
+        lines.emplace_back(span.begin_vertex(width, height));
+        lines.emplace_back(span.end_vertex(width, height));
+    }
+}
+
+void rasterize_parallel(const std::vector<Primitive>& primitives, int width, int height, float zoom,
+                        std::pmr::vector<Vector2f>& points, std::pmr::vector<Vector2f>& lines, unsigned threads,
+                        OccupancyBitmap *occupancy, std::vector<uint32_t> *point_ends, std::vector<uint32_t> *line_ends) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // contiguous ranges keep the order, a few per thread even out the big and the small shapes
+    size_t task_num = std::min<size_t>(primitives.size(), static_cast<size_t>(threads) * 8);
+    if (task_num <= 1 || threads == 1) {
+        for (const auto& primitive : primitives) {
+            rasterize(primitive, width, height, zoom, points, lines, occupancy);
+            if (point_ends) {
+                point_ends->push_back(static_cast<uint32_t>(points.size()));
+            }
+            if (line_ends) {
+                line_ends->push_back(static_cast<uint32_t>(lines.size()));
+            }
+        }
+        return;
+    }
+
+    // on the heap, the workers' own arenas are gone with them
+    std::vector<std::pmr::vector<Vector2f>> task_points(task_num), task_lines(task_num);
+    // ends within the vertices of the task, every primitive is written by one thread
+    std::vector<uint32_t> local_point_ends(point_ends ? primitives.size() : 0);
+    std::vector<uint32_t> local_line_ends(line_ends ? primitives.size() : 0);
+    std::vector<std::thread> workers;
+    std::atomic<size_t> next(0);
+    auto work = [&] {
+        for (size_t task = next++; task < task_num; task = next++) {
+            size_t first = primitives.size() * task / task_num;
+            size_t last = primitives.size() * (task + 1) / task_num;
+            for (size_t i = first; i < last; ++i) {
+                rasterize(primitives[i], width, height, zoom, task_points[task], task_lines[task], occupancy);
+                if (point_ends) {
+                    local_point_ends[i] = static_cast<uint32_t>(task_points[task].size());
+                }
+                if (line_ends) {
+                    local_line_ends[i] = static_cast<uint32_t>(task_lines[task].size());
+                }
+            }
+        }
+    };
+    for (unsigned i = 1; i < threads; ++i) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    size_t point_num = points.size();
+    size_t line_num = lines.size();
+    for (size_t task = 0; task < task_num; ++task) {
+        point_num += task_points[task].size();
+        line_num += task_lines[task].size();
+    }
+    points.reserve(point_num);
+    lines.reserve(line_num);
+    for (size_t task = 0; task < task_num; ++task) {
+        size_t first = primitives.size() * task / task_num;
+        size_t last = primitives.size() * (task + 1) / task_num;
+        for (size_t i = first; i < last; ++i) {
+            if (point_ends) {
+                point_ends->push_back(static_cast<uint32_t>(points.size()) + local_point_ends[i]);
+            }
+            if (line_ends) {
+                line_ends->push_back(static_cast<uint32_t>(lines.size()) + local_line_ends[i]);
+            }
+        }
+        points.insert(points.end(), task_points[task].begin(), task_points[task].end());
+        lines.insert(lines.end(), task_lines[task].begin(), task_lines[task].end());
+    }
+}
+
+static const char PRIMITIVE_MAGIC[4] = {'M', 'D', 'P', 'R'};
+static const uint32_t PRIMITIVE_VERSION = 1;
+static const size_t PRIMITIVE_BYTES = 18;
+
+static void put_u32(uint8_t *out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+}
+
+static uint32_t get_u32(const uint8_t *in) {
+    return static_cast<uint32_t>(in[0]) | static_cast<uint32_t>(in[1]) << 8 |
+           static_cast<uint32_t>(in[2]) << 16 | static_cast<uint32_t>(in[3]) << 24;
+}
+
+bool save_primitives(const std::string& path, const std::vector<Primitive>& primitives) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "[E] Failed to open " << path << " for writing." << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> bytes(16 + primitives.size() * PRIMITIVE_BYTES);
+    std::copy(PRIMITIVE_MAGIC, PRIMITIVE_MAGIC + 4, bytes.begin());
+    put_u32(&bytes[4], PRIMITIVE_VERSION);
+    put_u32(&bytes[8], static_cast<uint32_t>(primitives.size()));
+    put_u32(&bytes[12], static_cast<uint32_t>(static_cast<uint64_t>(primitives.size()) >> 32));
+    uint8_t *out = &bytes[16];
+    for (const auto& primitive : primitives) {
+        out[0] = static_cast<uint8_t>(primitive.type);
+        out[1] = primitive.flags;
+        put_u32(out + 2, static_cast<uint32_t>(primitive.start.x));
+        put_u32(out + 6, static_cast<uint32_t>(primitive.start.y));
+        put_u32(out + 10, static_cast<uint32_t>(primitive.end.x));
+        put_u32(out + 14, static_cast<uint32_t>(primitive.end.y));
+        out += PRIMITIVE_BYTES;
+    }
+    file.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!file) {
+        std::cerr << "[E] Failed to write " << path << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool load_primitives(const std::string& path, std::vector<Primitive>& primitives) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "[E] Failed to open " << path << "." << std::endl;
+        return false;
+    }
+    uint8_t header[16];
+    if (!file.read(reinterpret_cast<char *>(header), sizeof(header)) ||
+        !std::equal(PRIMITIVE_MAGIC, PRIMITIVE_MAGIC + 4, header) || get_u32(header + 4) != PRIMITIVE_VERSION) {
+        std::cerr << "[E] " << path << " is not a primitive list." << std::endl;
+        return false;
+    }
+    uint64_t count = get_u32(header + 8) | static_cast<uint64_t>(get_u32(header + 12)) << 32;
+
+    // the size is checked against the file before anything is allocated for it
+    auto data_begin = file.tellg();
+    file.seekg(0, std::ios::end);
+    auto data_bytes = static_cast<uint64_t>(file.tellg() - data_begin);
+    file.seekg(data_begin);
+    // divided rather than count multiplied, which can wrap around to the size of the file
+    if (data_bytes % PRIMITIVE_BYTES != 0 || data_bytes / PRIMITIVE_BYTES != count) {
+        std::cerr << "[E] " << path << " is truncated." << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> bytes(static_cast<size_t>(data_bytes));
+    if (!file.read(reinterpret_cast<char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()))) {
+        std::cerr << "[E] Failed to read " << path << "." << std::endl;
+        return false;
+    }
+
+    std::vector<Primitive> loaded;
+    loaded.reserve(static_cast<size_t>(count));
+    for (const uint8_t *in = bytes.data(); in < bytes.data() + bytes.size(); in += PRIMITIVE_BYTES) {
+        if (in[0] < static_cast<uint8_t>(PrimitiveType::line_dda) || in[0] > static_cast<uint8_t>(PrimitiveType::filled_ellipse)) {
+            std::cerr << "[E] " << path << " has an unknown primitive type " << static_cast<int>(in[0]) << "." << std::endl;
+            return false;
+        }
+        Primitive primitive;
+        primitive.type = static_cast<PrimitiveType>(in[0]);
+        primitive.flags = in[1];
+        primitive.start = Pixel(static_cast<int32_t>(get_u32(in + 2)), static_cast<int32_t>(get_u32(in + 6)));
+        primitive.end = Pixel(static_cast<int32_t>(get_u32(in + 10)), static_cast<int32_t>(get_u32(in + 14)));
+        loaded.push_back(primitive);
+    }
+    primitives = std::move(loaded);
+    return true;
+}
@@ -0,0 +1,66 @@
+#ifndef PRIMITIVE_H
+#define PRIMITIVE_H
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory_resource>
+#include "utils.h"
+#include "occupancy.h"
+
+enum class PrimitiveType : uint8_t {
+    line_dda = 1,
+    line_bresenham = 2,
+    ellipse = 3,
+    filled_ellipse = 4,
+};
+
+// A committed shape, independent of the window: the endpoints are in canvas pixels, which are
+// window pixels at zoom 1. The pixels are only produced when it is rasterized for a window.
+struct Primitive {
+    static const uint8_t SPANS = 1; // stored as span lines instead of points
+
+    PrimitiveType type;
+    uint8_t flags;
+    Pixel start, end;
+};
+
+// Inclusive pixel bounds, in canvas pixels like the primitives.
+struct Bounds {
+    int min_x, min_y, max_x, max_y;
+    bool intersects(const Bounds& other) const;
+};
+
+// the canvas pixels the primitive can cover at zoom 1
+Bounds bounds(const Primitive& primitive);
+// Whether a canvas point, fractional at other zooms, is within radius of the drawn shape: the
+// segment, the outline, or the inside of a filled ellipse.
+bool hit_test(const Primitive& primitive, float x, float y, float radius);
+// whether the drawn shape has a point inside the area, for rectangle selection
+bool intersects(const Primitive& primitive, const Bounds& area);
+
+// The pixels and spans of a primitive in a width x height window showing the canvas scaled by zoom,
+// clipped to it. Without the SPANS flag it is all pixels; with it the runs of two pixels or more
+// are spans and the single pixels stay pixels.
+void rasterize_pixels(const Primitive& primitive, int width, int height, float zoom,
+                      std::vector<Pixel>& pixels, std::vector<Span>& spans);
+// Rasterizes into a width x height window that shows the canvas scaled by zoom, clipped to it.
+// Appends GL_POINTS vertices to points and GL_LINES span vertices to lines, both in NDC.
+// With an occupancy bitmap of the window size, only the pixels it doesn't cover yet are appended.
+void rasterize(const Primitive& primitive, int width, int height, float zoom,
+               std::pmr::vector<Vector2f>& points, std::pmr::vector<Vector2f>& lines, OccupancyBitmap *occupancy = nullptr);
+// The same for a whole drawing, split over threads (0 for the hardware concurrency).
+// The vertices come out in the order of the primitives. With an occupancy bitmap, a pixel shared by
+// primitives of different threads is kept by whichever gets there first; all the ink is the same.
+// point_ends and line_ends get where the vertices of each primitive end, to store them separately.
+void rasterize_parallel(const std::vector<Primitive>& primitives, int width, int height, float zoom,
+                        std::pmr::vector<Vector2f>& points, std::pmr::vector<Vector2f>& lines, unsigned threads = 0,
+                        OccupancyBitmap *occupancy = nullptr,
+                        std::vector<uint32_t> *point_ends = nullptr, std::vector<uint32_t> *line_ends = nullptr);
+
+// Binary list of primitives: "MDPR", a version, the count, then 18 little endian bytes per primitive.
+bool save_primitives(const std::string& path, const std::vector<Primitive>& primitives);
+bool load_primitives(const std::string& path, std::vector<Primitive>& primitives);
+
+#endif // PRIMITIVE_H
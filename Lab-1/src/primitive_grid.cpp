@@ -0,0 +1,120 @@
+#include "primitive_grid.h"
+
+#include <algorithm>
+
+PrimitiveGrid::PrimitiveGrid(int cell_size) : cell_size(cell_size) {}
+
+int PrimitiveGrid::cell_of(int v) const {
+    // rounds down for the negative coordinates too
+    return v >= 0 ? v / cell_size : -((-v - 1) / cell_size) - 1;
+}
+
+uint64_t PrimitiveGrid::key(int cx, int cy) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32 | static_cast<uint32_t>(cy);
+}
+
+void PrimitiveGrid::insert(uint32_t id, const Bounds& bounds) {
+    if (id >= items.size()) {
+        items.resize(id + 1);
+    }
+    auto& item = items[id];
+    if (item.live) {
+        remove(id);
+    }
+    item.bounds = bounds;
+    item.live = true;
+    item_num++;
+
+    int cx0 = cell_of(bounds.min_x), cx1 = cell_of(bounds.max_x);
+    int cy0 = cell_of(bounds.min_y), cy1 = cell_of(bounds.max_y);
+    item.large = static_cast<int64_t>(cx1 - cx0 + 1) * (cy1 - cy0 + 1) > MAX_CELLS;
+    if (item.large) {
+        large.push_back({bounds, id});
+        return;
+    }
+    for (int cy = cy0; cy <= cy1; ++cy) {
+        for (int cx = cx0; cx <= cx1; ++cx) {
+            cells[key(cx, cy)].push_back({bounds, id});
+        }
+    }
+}
+
+void PrimitiveGrid::remove(uint32_t id) {
+    if (id >= items.size() || !items[id].live) {
+        return;
+    }
+    auto& item = items[id];
+    item.live = false;
+    item_num--;
+    auto erase_from = [id](std::vector<Entry>& list) {
+        auto it = std::find_if(list.begin(), list.end(), [id](const Entry& entry) { return entry.id == id; });
+        if (it != list.end()) {
+            *it = list.back();
+            list.pop_back();
+        }
+    };
+    if (item.large) {
+        erase_from(large);
+        return;
+    }
+    int cx0 = cell_of(item.bounds.min_x), cx1 = cell_of(item.bounds.max_x);
+    int cy0 = cell_of(item.bounds.min_y), cy1 = cell_of(item.bounds.max_y);
+    for (int cy = cy0; cy <= cy1; ++cy) {
+        for (int cx = cx0; cx <= cx1; ++cx) {
+            auto it = cells.find(key(cx, cy));
+            erase_from(it->second);
+            if (it->second.empty()) {
+                cells.erase(it);
+            }
+        }
+    }
+}
+
+void PrimitiveGrid::clear() {
+    cells.clear();
+    large.clear();
+    items.clear();
+    item_num = 0;
+}
+
+void PrimitiveGrid::query(const Bounds& area, std::pmr::vector<uint32_t>& ids) const {
+    for (const auto& entry : large) {
+        if (entry.bounds.intersects(area)) {
+            ids.push_back(entry.id);
+        }
+    }
+    auto scan = [&](int cx, int cy, const std::vector<Entry>& list) {
+        for (const auto& entry : list) {
+            const auto& b = entry.bounds;
+            if (!b.intersects(area)) {
+                continue;
+            }
+            // An item in several cells is only reported by the one holding the corner where
+            // its bounds and the area start to overlap, so there's nothing to deduplicate.
+            if (cell_of(std::max(b.min_x, area.min_x)) == cx && cell_of(std::max(b.min_y, area.min_y)) == cy) {
+                ids.push_back(entry.id);
+            }
+        }
+    };
+    int cx0 = cell_of(area.min_x), cx1 = cell_of(area.max_x);
+    int cy0 = cell_of(area.min_y), cy1 = cell_of(area.max_y);
+    // a zoomed out selection can span more cells than there are stored
+    if (static_cast<uint64_t>(cx1 - cx0 + 1) * static_cast<uint64_t>(cy1 - cy0 + 1) > cells.size()) {
+        for (const auto& cell : cells) {
+            int cx = static_cast<int>(static_cast<uint32_t>(cell.first >> 32));
+            int cy = static_cast<int>(static_cast<uint32_t>(cell.first));
+            if (cx >= cx0 && cx <= cx1 && cy >= cy0 && cy <= cy1) {
+                scan(cx, cy, cell.second);
+            }
+        }
+        return;
+    }
+    for (int cy = cy0; cy <= cy1; ++cy) {
+        for (int cx = cx0; cx <= cx1; ++cx) {
+            auto it = cells.find(key(cx, cy));
+            if (it != cells.end()) {
+                scan(cx, cy, it->second);
+            }
+        }
+    }
+}
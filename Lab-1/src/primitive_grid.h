@@ -0,0 +1,56 @@
+#ifndef PRIMITIVE_GRID_H
+#define PRIMITIVE_GRID_H
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+#include <memory_resource>
+#include "primitive.h"
+
+// Uniform grid over the bounds of the committed primitives, in canvas pixels, for the select and
+// erase tools. Only the cells that hold something are stored, so the canvas has no fixed extent.
+// A primitive is listed in every cell its bounds touch; the ones that would touch too many cells,
+// like a huge ellipse, are kept in a separate list that every query scans instead.
+// Ids are small integers chosen by the caller, the index of the primitive in the drawing.
+class PrimitiveGrid {
+public:
+    static const int CELL_SIZE = 64;
+    static const int64_t MAX_CELLS = 256;
+
+    explicit PrimitiveGrid(int cell_size = CELL_SIZE);
+
+    void insert(uint32_t id, const Bounds& bounds);
+    void remove(uint32_t id);
+    void clear();
+    // Appends the ids whose bounds intersect the area, each once and in no particular order.
+    // A point is an area of one pixel.
+    void query(const Bounds& area, std::pmr::vector<uint32_t>& ids) const;
+
+    size_t size() const { return item_num; }
+    size_t cell_count() const { return cells.size(); }
+
+private:
+    struct Item {
+        Bounds bounds;
+        bool live = false;
+        bool large = false;
+    };
+    // the bounds are repeated in the cells, a query reads its cells front to back
+    struct Entry {
+        Bounds bounds;
+        uint32_t id;
+    };
+
+    int cell_of(int v) const;
+    static uint64_t key(int cx, int cy);
+
+    int cell_size;
+    std::unordered_map<uint64_t, std::vector<Entry>> cells;
+    std::vector<Entry> large;
+    std::vector<Item> items; // by id
+    size_t item_num = 0;
+};
+
+#endif // PRIMITIVE_GRID_H
@@ -1,5 +1,14 @@
 #include "rasterization.h"
 
+#include <algorithm>
+#include <cmath>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+static_assert(sizeof(Pixel) == 2 * sizeof(int), "the span kernels store pixels as pairs of ints");
+
 void draw_line_dda(Pixel start, Pixel end, std::vector<Pixel>& pixels) {
     int dx = end.x - start.x;
     int dy = end.y - start.y;
@@ -16,12 +25,773 @@ void draw_line_dda(Pixel start, Pixel end, std::vector<Pixel>& pixels) {
     }
 }
 
+// Liang-Barsky on the step parameter: narrows [lo, hi] to the steps i where p0 + i inc is in (min, max)
+static bool clip_parameter(double p0, double inc, double min, double max, double& lo, double& hi) {
+    if (inc == 0.0) {
+        return p0 > min && p0 < max;
+    }
+    double t0 = (min - p0) / inc;
+    double t1 = (max - p0) / inc;
+    if (t0 > t1) {
+        std::swap(t0, t1);
+    }
+    lo = std::max(lo, t0);
+    hi = std::min(hi, t1);
+    return lo <= hi;
+}
+
+void draw_line_dda(Pixel start, Pixel end, std::vector<Pixel>& pixels, const ClipRect& clip) {
+    int dx = end.x - start.x;
+    int dy = end.y - start.y;
+    int steps = abs(dx) > abs(dy) ? abs(dx) : abs(dy);
+    if (steps == 0) {
+        if (clip.contains(start)) {
+            pixels.push_back(start);
+        }
+        return;
+    }
+    float x_inc = dx / static_cast<float>(steps);
+    float y_inc = dy / static_cast<float>(steps);
+
+    // The positions are truncated, anything in (-1, width) x (-1, height) may land inside, and the
+    // accumulation below drifts from start + i inc by at most an ulp of the coordinates per step.
+    // Only a line that misses even with that much room is dropped without stepping it.
+    int magnitude = std::max({abs(start.x), abs(start.y), abs(end.x), abs(end.y), 1});
+    double slack = 1.0 + steps * std::ldexp(1.0, std::ilogb(static_cast<double>(magnitude)) - 23);
+    double lo = 0.0;
+    double hi = steps;
+    if (!clip_parameter(start.x, x_inc, -1.0 - slack, clip.width + slack, lo, hi) ||
+        !clip_parameter(start.y, y_inc, -1.0 - slack, clip.height + slack, lo, hi)) {
+        return;
+    }
+
+    // Stepped from the start like the unclipped line, start + first inc rounds differently and
+    // moves pixels. The steps before the widened window can't land inside and are only added up.
+    // Both coordinates move monotonically, so the visible steps are one run and the line is left
+    // as soon as it leaves the rectangle.
+    int first = std::max(0, static_cast<int>(std::floor(lo)));
+    float x = start.x;
+    float y = start.y;
+    for (int i = 0; i < first; i++) {
+        x += x_inc;
+        y += y_inc;
+    }
+    bool entered = false;
+    for (int i = first; i <= steps; i++) {
+        Pixel pixel(x, y);
+        if (clip.contains(pixel)) {
+            pixels.push_back(pixel);
+            entered = true;
+        } else if (entered) {
+            break;
+        }
+        x += x_inc;
+        y += y_inc;
+    }
+}
+
+// The line stepped along its major axis: pixel i is major0 + major_step i on the major axis
+// and minor0 + minor_step m(i) on the minor one, with m(i) = (2 i d_minor + d_major - 1) / (2 d_major).
+struct LineSteps {
+    bool steep;
+    int major0, minor0;
+    int major_step, minor_step;
+    int d_major, d_minor;
+
+    LineSteps(Pixel start, Pixel end) {
+        int dx = end.x - start.x;
+        int dy = end.y - start.y;
+        steep = abs(dx) < abs(dy);
+        major0 = steep ? start.y : start.x;
+        minor0 = steep ? start.x : start.y;
+        major_step = (steep ? dy : dx) >= 0 ? 1 : -1;
+        minor_step = (steep ? dx : dy) >= 0 ? 1 : -1;
+        d_major = abs(steep ? dy : dx);
+        d_minor = abs(steep ? dx : dy);
+    }
+
+    int minor_offset(int64_t i) const {
+        if (i == 0) {
+            return 0; // d_major is 0 for a single pixel
+        }
+        return static_cast<int>((2 * i * d_minor + d_major - 1) / (2 * static_cast<int64_t>(d_major)));
+    }
+
+    // the first pixel whose minor offset reaches k, d_minor must not be 0
+    int64_t first_with_offset(int64_t k) const {
+        if (k <= 0) {
+            return 0;
+        }
+        auto n = (2 * k - 1) * d_major + 1;
+        return (n + 2 * static_cast<int64_t>(d_minor) - 1) / (2 * static_cast<int64_t>(d_minor));
+    }
+
+    // Clipping in the integer parameter space of the line, Liang-Barsky style: each side of the
+    // rectangle bounds i from one end, so [first, last] are exactly the pixels of the whole line
+    // that land inside and the clipped line has the same pixels as the unclipped one.
+    bool clip(const ClipRect& rect, int& first, int& last) const {
+        int64_t major_limit = steep ? rect.height : rect.width;
+        int64_t minor_limit = steep ? rect.width : rect.height;
+        int64_t lo = 0;
+        int64_t hi = d_major;
+
+        // major0 + major_step i in [0, major_limit)
+        if (major_step > 0) {
+            lo = std::max<int64_t>(lo, -static_cast<int64_t>(major0));
+            hi = std::min<int64_t>(hi, major_limit - 1 - major0);
+        } else {
+            lo = std::max<int64_t>(lo, major0 - (major_limit - 1));
+            hi = std::min<int64_t>(hi, major0);
+        }
+
+        // minor0 + minor_step m(i) in [0, minor_limit), m(i) doesn't decrease with i
+        int64_t m_lo = minor_step > 0 ? -static_cast<int64_t>(minor0) : minor0 - (minor_limit - 1);
+        int64_t m_hi = minor_step > 0 ? minor_limit - 1 - minor0 : minor0;
+        if (d_minor == 0) {
+            if (m_lo > 0 || m_hi < 0) {
+                return false;
+            }
+        } else {
+            if (m_hi < 0) {
+                return false;
+            }
+            lo = std::max(lo, first_with_offset(m_lo));
+            hi = std::min(hi, first_with_offset(m_hi + 1) - 1);
+        }
+
+        if (lo > hi) {
+            return false;
+        }
+        first = static_cast<int>(lo);
+        last = static_cast<int>(hi);
+        return true;
+    }
+};
+
 void draw_line_bresenham(Pixel start, Pixel end, std::vector<Pixel>& pixels) {
-    // TODO: 1.1 complete bresenham algorithm
+    size_t offset = pixels.size();
+    pixels.resize(offset + line_pixel_count(start, end));
+    draw_line_bresenham(start, end, pixels.data() + offset);
+}
+
+void draw_line_bresenham(Pixel start, Pixel end, std::vector<Pixel>& pixels, const ClipRect& clip) {
+    size_t offset = pixels.size();
+    pixels.resize(offset + line_pixel_count(start, end, clip));
+    draw_line_bresenham(start, end, clip, pixels.data() + offset);
+}
+
+size_t line_pixel_count(Pixel start, Pixel end) {
+    int dx = abs(end.x - start.x);
+    int dy = abs(end.y - start.y);
+    return static_cast<size_t>(dx > dy ? dx : dy) + 1;
+}
+
+size_t line_pixel_count(Pixel start, Pixel end, const ClipRect& clip) {
+    int first, last;
+    if (!LineSteps(start, end).clip(clip, first, last)) {
+        return 0;
+    }
+    return static_cast<size_t>(last - first) + 1;
+}
+
+// One octant: the major axis steps every pixel, the minor one when the error turns positive.
+// STEEP lines step along y, the steps are the signs of the two axes. Writes the pixels [first, last]
+// of the line to out[0 .. last - first], the error term of pixel first is set up in closed form.
+template<bool STEEP, int MAJOR_STEP, int MINOR_STEP>
+static void bresenham_octant(Pixel start, int d_major, int d_minor, int first, int last, Pixel *out) {
+    auto offset = first == 0 ? 0 : (2 * static_cast<int64_t>(first) * d_minor + d_major - 1) / (2 * static_cast<int64_t>(d_major));
+    int major = (STEEP ? start.y : start.x) + MAJOR_STEP * first;
+    int minor = (STEEP ? start.x : start.y) + MINOR_STEP * static_cast<int>(offset);
+    int err = static_cast<int>(2 * static_cast<int64_t>(d_minor) * (first + 1) - d_major - 2 * static_cast<int64_t>(d_major) * offset);
+    for (int i = 0; i <= last - first; ++i) {
+        // Pixel's constructor lives in utils.cpp, assigning the members keeps the loop inline
+        out[i].x = STEEP ? minor : major;
+        out[i].y = STEEP ? major : minor;
+        // branch free, the minor steps of a random slope are unpredictable
+        bool step = err > 0;
+        minor += step ? MINOR_STEP : 0;
+        err += 2 * d_minor - (step ? 2 * d_major : 0);
+        major += MAJOR_STEP;
+    }
+}
+
+// calls KERNEL<steep, major step, minor step>::run(start, d_major, d_minor, first, last, out) for the
+// octant of the line, the whole line or only the part of it inside clip
+template<template<bool, int, int> class KERNEL>
+static size_t dispatch_octant(Pixel start, Pixel end, const ClipRect *clip, Pixel *out) {
+    LineSteps line(start, end);
+    int first = 0;
+    int last = line.d_major;
+    if (clip != nullptr && !line.clip(*clip, first, last)) {
+        return 0;
+    }
+    int d_major = line.d_major;
+    int d_minor = line.d_minor;
+    if (!line.steep) {
+        if (line.major_step > 0) {
+            line.minor_step > 0 ? KERNEL<false, 1, 1>::run(start, d_major, d_minor, first, last, out)
+                                : KERNEL<false, 1, -1>::run(start, d_major, d_minor, first, last, out);
+        } else {
+            line.minor_step > 0 ? KERNEL<false, -1, 1>::run(start, d_major, d_minor, first, last, out)
+                                : KERNEL<false, -1, -1>::run(start, d_major, d_minor, first, last, out);
+        }
+    } else {
+        if (line.major_step > 0) {
+            line.minor_step > 0 ? KERNEL<true, 1, 1>::run(start, d_major, d_minor, first, last, out)
+                                : KERNEL<true, 1, -1>::run(start, d_major, d_minor, first, last, out);
+        } else {
+            line.minor_step > 0 ? KERNEL<true, -1, 1>::run(start, d_major, d_minor, first, last, out)
+                                : KERNEL<true, -1, -1>::run(start, d_major, d_minor, first, last, out);
+        }
+    }
+    return static_cast<size_t>(last - first) + 1;
+}
 
+template<bool STEEP, int MAJOR_STEP, int MINOR_STEP>
+struct ScalarKernel {
+    static void run(Pixel start, int d_major, int d_minor, int first, int last, Pixel *out) {
+        bresenham_octant<STEEP, MAJOR_STEP, MINOR_STEP>(start, d_major, d_minor, first, last, out);
+    }
+};
+
+size_t draw_line_bresenham_scalar(Pixel start, Pixel end, Pixel *out) {
+    return dispatch_octant<ScalarKernel>(start, end, nullptr, out);
+}
+
+#ifdef __AVX2__
+
+// Eight pixels per iteration. The minor offset of pixel i is (2 i d_minor + d_major - 1) / (2 d_major),
+// the same rounding as the scalar error term. Each lane keeps that quotient and its remainder,
+// stepping eight pixels adds a constant quotient and remainder with one carry.
+template<bool STEEP, int MAJOR_STEP, int MINOR_STEP>
+struct Avx2Kernel {
+    static void run(Pixel start, int d_major, int d_minor, int first, int last, Pixel *out) {
+        int count = last - first + 1;
+        if (count < 32) { // the lane setup costs more than it saves on short lines
+            bresenham_octant<STEEP, MAJOR_STEP, MINOR_STEP>(start, d_major, d_minor, first, last, out);
+            return;
+        }
+
+        int major0 = (STEEP ? start.y : start.x) + MAJOR_STEP * first;
+        int minor0 = STEEP ? start.x : start.y;
+        auto denom = 2 * static_cast<int64_t>(d_major);
+        auto minor_offset = [&](int64_t i) -> int {
+            return static_cast<int>((2 * (first + i) * d_minor + d_major - 1) / denom);
+        };
+
+        alignas(32) int q[8], r[8];
+        for (int lane = 0; lane < 8; ++lane) {
+            auto n = 2 * static_cast<int64_t>(first + lane) * d_minor + d_major - 1;
+            q[lane] = static_cast<int>(n / denom);
+            r[lane] = static_cast<int>(n % denom);
+        }
+        auto step = 16 * static_cast<int64_t>(d_minor);
+        __m256i quot = _mm256_load_si256(reinterpret_cast<const __m256i *>(q));
+        __m256i rem = _mm256_load_si256(reinterpret_cast<const __m256i *>(r));
+        const __m256i quot_step = _mm256_set1_epi32(static_cast<int>(step / denom));
+        const __m256i rem_step = _mm256_set1_epi32(static_cast<int>(step % denom));
+        const __m256i rem_max = _mm256_set1_epi32(static_cast<int>(denom - 1));
+        const __m256i rem_wrap = _mm256_set1_epi32(static_cast<int>(denom));
+        const __m256i minor_base = _mm256_set1_epi32(minor0);
+        const __m256i major_step = _mm256_set1_epi32(8 * MAJOR_STEP);
+        __m256i major = _mm256_add_epi32(_mm256_set1_epi32(major0),
+                                         _mm256_mullo_epi32(_mm256_set1_epi32(MAJOR_STEP), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i minor = MINOR_STEP > 0 ? _mm256_add_epi32(minor_base, quot) : _mm256_sub_epi32(minor_base, quot);
+            __m256i xs = STEEP ? minor : major;
+            __m256i ys = STEEP ? major : minor;
+            // (x0 y0 x1 y1 | x4 y4 x5 y5) and (x2 y2 x3 y3 | x6 y6 x7 y7), then swap the middle halves
+            __m256i lo = _mm256_unpacklo_epi32(xs, ys);
+            __m256i hi = _mm256_unpackhi_epi32(xs, ys);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), _mm256_permute2x128_si256(lo, hi, 0x20));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i + 4), _mm256_permute2x128_si256(lo, hi, 0x31));
+
+            major = _mm256_add_epi32(major, major_step);
+            quot = _mm256_add_epi32(quot, quot_step);
+            rem = _mm256_add_epi32(rem, rem_step);
+            __m256i carry = _mm256_cmpgt_epi32(rem, rem_max);
+            rem = _mm256_sub_epi32(rem, _mm256_and_si256(carry, rem_wrap));
+            quot = _mm256_sub_epi32(quot, carry);
+        }
+        for (; i < count; ++i) {
+            int major_i = major0 + MAJOR_STEP * i;
+            int minor_i = minor0 + MINOR_STEP * minor_offset(i);
+            out[i].x = STEEP ? minor_i : major_i;
+            out[i].y = STEEP ? major_i : minor_i;
+        }
+    }
+};
+
+size_t draw_line_bresenham_avx2(Pixel start, Pixel end, Pixel *out) {
+    return dispatch_octant<Avx2Kernel>(start, end, nullptr, out);
+}
+
+#endif
+
+size_t draw_line_bresenham(Pixel start, Pixel end, Pixel *out) {
+#ifdef __AVX2__
+    return draw_line_bresenham_avx2(start, end, out);
+#else
+    return draw_line_bresenham_scalar(start, end, out);
+#endif
+}
+
+size_t draw_line_bresenham(Pixel start, Pixel end, const ClipRect& clip, Pixel *out) {
+#ifdef __AVX2__
+    return dispatch_octant<Avx2Kernel>(start, end, &clip, out);
+#else
+    return dispatch_octant<ScalarKernel>(start, end, &clip, out);
+#endif
+}
+
+// the pixels [first, last] of the line as spans
+static void line_spans(Pixel start, const LineSteps& line, int first, int last, std::vector<Span>& spans) {
+    int major_begin = line.major0 + line.major_step * first;
+    if (line.steep) {
+        // every row has a single pixel
+        auto offset = line.minor_offset(first);
+        int x = line.minor0 + line.minor_step * offset;
+        auto err = 2 * static_cast<int64_t>(line.d_minor) * (first + 1) - line.d_major - 2 * static_cast<int64_t>(line.d_major) * offset;
+        for (int i = 0; i <= last - first; ++i) {
+            spans.emplace_back(major_begin + line.major_step * i, x, x + 1);
+            if (err > 0) {
+                x += line.minor_step;
+                err -= 2 * line.d_major;
+            }
+            err += 2 * line.d_minor;
+        }
+        return;
+    }
+
+    // Pixel i of the line is on row m(i), so row k starts at the first i with m(i) >= k
+    int row_first = line.minor_offset(first);
+    int row_last = line.minor_offset(last);
+    for (int k = row_first; k <= row_last; ++k) {
+        int begin = k == row_first ? first : static_cast<int>(line.first_with_offset(k));
+        int end_i = k == row_last ? last + 1 : static_cast<int>(line.first_with_offset(k + 1));
+        int y = start.y + line.minor_step * k;
+        if (line.major_step > 0) {
+            spans.emplace_back(y, start.x + begin, start.x + end_i);
+        } else {
+            spans.emplace_back(y, start.x - end_i + 1, start.x - begin + 1);
+        }
+    }
+}
+
+void draw_line_spans(Pixel start, Pixel end, std::vector<Span>& spans) {
+    LineSteps line(start, end);
+    line_spans(start, line, 0, line.d_major, spans);
+}
+
+void draw_line_spans(Pixel start, Pixel end, std::vector<Span>& spans, const ClipRect& clip) {
+    LineSteps line(start, end);
+    int first, last;
+    if (line.clip(clip, first, last)) {
+        line_spans(start, line, first, last, spans);
+    }
+}
+
+void append_spans(const Pixel *pixels, size_t count, std::vector<Span>& spans) {
+    for (size_t i = 0; i < count; ) {
+        int y = pixels[i].y;
+        int x_min = pixels[i].x;
+        int x_max = pixels[i].x;
+        size_t j = i + 1;
+        // a run continues while the next pixel is a horizontal neighbour, in either direction
+        for (; j < count && pixels[j].y == y; ++j) {
+            if (pixels[j].x == x_max + 1) {
+                x_max++;
+            } else if (pixels[j].x == x_min - 1) {
+                x_min--;
+            } else {
+                break;
+            }
+        }
+        spans.emplace_back(y, x_min, x_max + 1);
+        i = j;
+    }
+}
+
+// Midpoint ellipse over the first quadrant, from (0, b) to (a, 0), both regions in integers.
+// The decision values are scaled by 4 to stay integral, they fit in int64 for semi-axes up to 32768.
+// run(y, x_begin, x_end) gets the pixels [x_begin, x_end] of each row, once per row and with y decreasing,
+// the other quadrants are mirrors of it.
+template<typename RUN>
+static void ellipse_quadrant(int a, int b, RUN&& run) {
+    if (b == 0) {
+        run(0, 0, a);
+        return;
+    }
+    int64_t a2 = static_cast<int64_t>(a) * a;
+    int64_t b2 = static_cast<int64_t>(b) * b;
+    int64_t x = 0;
+    int64_t y = b;
+    int64_t run_begin = 0;
+
+    // region 1, |slope| < 1: x steps every pixel, p is the decision at (x + 1, y - 1/2)
+    int64_t p = 4 * b2 - 4 * a2 * b + a2;
+    while (2 * b2 * (x + 1) < a2 * (2 * y - 1)) {
+        if (p < 0) {
+            p += 4 * b2 * (2 * x + 3);
+        } else {
+            p += 4 * b2 * (2 * x + 3) - 8 * a2 * (y - 1);
+            run(static_cast<int>(y), static_cast<int>(run_begin), static_cast<int>(x));
+            run_begin = x + 1;
+            y--;
+        }
+        x++;
+    }
+
+    // region 2, y steps every pixel, q is the decision at (x + 1/2, y - 1)
+    int64_t q = b2 * (2 * x + 1) * (2 * x + 1) + 4 * a2 * (y - 1) * (y - 1) - 4 * a2 * b2;
+    while (y >= 0) {
+        // the midpoint can fall short of the tip on flat ellipses, the last row always reaches it
+        run(static_cast<int>(y), static_cast<int>(run_begin), y == 0 ? a : static_cast<int>(x));
+        if (q > 0) {
+            q += 4 * a2 * (3 - 2 * y);
+        } else {
+            q += 8 * b2 * (x + 1) + 4 * a2 * (3 - 2 * y);
+            x++;
+        }
+        run_begin = x;
+        y--;
+    }
 }
 
 void draw_ellipse(Pixel start, Pixel end, std::vector<Pixel>& pixels) {
-    // TODO: 1.2 complete rasterization for ellipse
+    int a = abs(end.x - start.x);
+    int b = abs(end.y - start.y);
+    // the four quadrants from one traversal, pixels on the axes are only emitted once
+    ellipse_quadrant(a, b, [&](int y, int x_begin, int x_end) {
+        for (int x = x_begin; x <= x_end; ++x) {
+            pixels.emplace_back(start.x + x, start.y + y);
+            if (x != 0) {
+                pixels.emplace_back(start.x - x, start.y + y);
+            }
+            if (y != 0) {
+                pixels.emplace_back(start.x + x, start.y - y);
+                if (x != 0) {
+                    pixels.emplace_back(start.x - x, start.y - y);
+                }
+            }
+        }
+    });
+}
+
+void draw_ellipse_spans(Pixel start, Pixel end, std::vector<Span>& spans) {
+    int a = abs(end.x - start.x);
+    int b = abs(end.y - start.y);
+    ellipse_quadrant(a, b, [&](int y, int x_begin, int x_end) {
+        for (int sy : {1, -1}) {
+            if (sy < 0 && y == 0) {
+                break;
+            }
+            int row = start.y + sy * y;
+            if (x_begin == 0) {
+                // the left and the right run touch at the axis
+                spans.emplace_back(row, start.x - x_end, start.x + x_end + 1);
+            } else {
+                spans.emplace_back(row, start.x - x_end, start.x - x_begin + 1);
+                spans.emplace_back(row, start.x + x_begin, start.x + x_end + 1);
+            }
+        }
+    });
+}
+
+void fill_ellipse_spans(Pixel start, Pixel end, std::vector<Span>& spans) {
+    int a = abs(end.x - start.x);
+    int b = abs(end.y - start.y);
+    ellipse_quadrant(a, b, [&](int y, int, int x_end) {
+        spans.emplace_back(start.y + y, start.x - x_end, start.x + x_end + 1);
+        if (y != 0) {
+            spans.emplace_back(start.y - y, start.x - x_end, start.x + x_end + 1);
+        }
+    });
+}
 
+// The decisions of ellipse_quadrant as functions of the point, scaled by 4 the same way:
+// region 1 keeps y at column x when (x, y - 1/2) is inside, region 2 steps x at row y when (x + 1/2, y) is.
+static bool inside_region_1(int64_t a2, int64_t b2, int64_t x, int64_t y) {
+    return 4 * b2 * (x * x - a2) + a2 * (2 * y - 1) * (2 * y - 1) < 0;
+}
+
+static bool inside_region_2(int64_t a2, int64_t b2, int64_t x, int64_t y) {
+    return b2 * ((2 * x + 1) * (2 * x + 1) - 4 * a2) + 4 * a2 * y * y <= 0;
+}
+
+static int64_t isqrt(int64_t v) {
+    if (v <= 0) {
+        return 0;
+    }
+    auto r = static_cast<int64_t>(std::sqrt(static_cast<double>(v)));
+    while (r * r > v) {
+        r--;
+    }
+    while ((r + 1) * (r + 1) <= v) {
+        r++;
+    }
+    return r;
+}
+
+// Rows [y_lo, y_hi] of ellipse_quadrant, the same runs in the same order, in time bounded by the rows
+// asked rather than by the quadrant. Where the curve is flatter than 45 degrees the traversal keeps to
+// it, so a row of region 1 ends at the last x whose midpoint is inside, and where it is steeper a row
+// of region 2 is at the count of x inside; both come from a square root fixed up with the decisions
+// above. Around the switch between the regions the traversal can fall a step behind the curve, those
+// few steps are taken one by one like ellipse_quadrant does.
+template<typename RUN>
+static void ellipse_quadrant(int a, int b, int y_lo, int y_hi, RUN&& run) {
+    y_lo = std::max(y_lo, 0);
+    y_hi = std::min(y_hi, b);
+    if (y_lo > y_hi) {
+        return;
+    }
+    if (b == 0) {
+        run(0, 0, a);
+        return;
+    }
+    int64_t a2 = static_cast<int64_t>(a) * a;
+    int64_t b2 = static_cast<int64_t>(b) * b;
+    auto region_1_end = [&](int64_t y) -> int64_t {
+        if (y > b) {
+            return -1;
+        }
+        double d = static_cast<double>(a2) * (4.0 * b2 - (2.0 * y - 1) * (2.0 * y - 1)) / (4.0 * b2);
+        auto x = static_cast<int64_t>(std::sqrt(std::max(d, 0.0)));
+        while (x >= 0 && !inside_region_1(a2, b2, x, y)) {
+            x--;
+        }
+        while (inside_region_1(a2, b2, x + 1, y)) {
+            x++;
+        }
+        return x;
+    };
+    auto region_1_row = [&](int64_t x) -> int64_t {
+        if (x == 0) {
+            return b;
+        }
+        double d = b2 * (1.0 - static_cast<double>(x) * x / static_cast<double>(a2));
+        auto y = static_cast<int64_t>(std::sqrt(std::max(d, 0.0)) + 0.5);
+        while (y > 0 && !inside_region_1(a2, b2, x, y)) {
+            y--;
+        }
+        while (inside_region_1(a2, b2, x, y + 1)) {
+            y++;
+        }
+        return y;
+    };
+    auto region_2_x = [&](int64_t y) -> int64_t {
+        double d = 4.0 * a2 * (b2 - static_cast<double>(y) * y) / static_cast<double>(b2);
+        auto x = std::max<int64_t>(0, static_cast<int64_t>((std::sqrt(std::max(d, 0.0)) - 1.0) / 2.0));
+        while (x > 0 && !inside_region_2(a2, b2, x - 1, y)) {
+            x--;
+        }
+        while (inside_region_2(a2, b2, x, y)) {
+            x++;
+        }
+        return x;
+    };
+    auto in_region_1 = [&](int64_t x, int64_t y) { return 2 * b2 * (x + 1) < a2 * (2 * y - 1); };
+
+    // the curve is at most 45 degrees steep for x <= x_flat and at least for y <= y_steep
+    int64_t x_flat = isqrt(a2 * a2 / (a2 + b2));
+    int64_t y_steep = isqrt(b2 * b2 / (a2 + b2));
+    // region 1 ends at the first x failing in_region_1, up to x_flat its row is region_1_row
+    int64_t lo = 0, hi = x_flat + 1;
+    while (lo < hi) {
+        int64_t mid = (lo + hi) / 2;
+        if (in_region_1(mid, region_1_row(mid))) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    int64_t x = std::min(lo, x_flat);
+    int64_t y = region_1_row(x);
+
+    // the rows of region 1 before x, each ending where the next one starts
+    int64_t row_end = region_1_end(std::min<int64_t>(y_hi, b) + 1);
+    for (int64_t row = std::min<int64_t>(y_hi, b); row > y && row >= y_lo; --row) {
+        int64_t row_begin = row_end + 1;
+        row_end = region_1_end(row);
+        run(static_cast<int>(row), static_cast<int>(row_begin), static_cast<int>(row_end));
+    }
+
+    // stepped from x as ellipse_quadrant does, until the curve is steep past the switch
+    int64_t run_begin = region_1_end(y + 1) + 1;
+    int64_t p = 4 * b2 * ((x + 1) * (x + 1) - a2) + a2 * (2 * y - 1) * (2 * y - 1);
+    while (in_region_1(x, y)) {
+        if (p < 0) {
+            p += 4 * b2 * (2 * x + 3);
+        } else {
+            p += 4 * b2 * (2 * x + 3) - 8 * a2 * (y - 1);
+            if (y >= y_lo && y <= y_hi) {
+                run(static_cast<int>(y), static_cast<int>(run_begin), static_cast<int>(x));
+            }
+            run_begin = x + 1;
+            y--;
+        }
+        x++;
+    }
+    int64_t q = b2 * (2 * x + 1) * (2 * x + 1) + 4 * a2 * (y - 1) * (y - 1) - 4 * a2 * b2;
+    int64_t stop = std::min(y_steep, y);
+    while (y >= 0 && y >= stop) {
+        if (y >= y_lo && y <= y_hi) {
+            run(static_cast<int>(y), static_cast<int>(run_begin), y == 0 ? a : static_cast<int>(x));
+        }
+        if (q > 0) {
+            q += 4 * a2 * (3 - 2 * y);
+        } else {
+            q += 8 * b2 * (x + 1) + 4 * a2 * (3 - 2 * y);
+            x++;
+        }
+        run_begin = x;
+        y--;
+    }
+
+    // below, x follows the curve as soon as it caught up with it, one step per row until then
+    for (int64_t row = std::min<int64_t>(y_hi, y); row >= y_lo; --row) {
+        int64_t row_x = std::min(std::max(x, region_2_x(row)), x + (y - row));
+        run(static_cast<int>(row), static_cast<int>(row_x), row == 0 ? a : static_cast<int>(row_x));
+    }
+}
+
+// Bounding box test of the ellipse: -1 when it is all outside clip, 1 when all inside, 0 otherwise.
+// The partly visible ones only traverse the quadrant rows of ellipse_rows, and their runs are cut to
+// the width of clip before any pixel is written.
+static int ellipse_visibility(Pixel center, int a, int b, const ClipRect& clip) {
+    int64_t x0 = static_cast<int64_t>(center.x) - a;
+    int64_t x1 = static_cast<int64_t>(center.x) + a;
+    int64_t y0 = static_cast<int64_t>(center.y) - b;
+    int64_t y1 = static_cast<int64_t>(center.y) + b;
+    if (x1 < 0 || y1 < 0 || x0 >= clip.width || y0 >= clip.height) {
+        return -1;
+    }
+    return x0 >= 0 && y0 >= 0 && x1 < clip.width && y1 < clip.height ? 1 : 0;
+}
+
+// The quadrant rows y of a semi-axis b with center.y + y or center.y - y inside clip, at most clip.height
+// of them; false when there are none
+static bool ellipse_rows(Pixel center, int b, const ClipRect& clip, int& y_lo, int& y_hi) {
+    // center.y - y is inside for y <= to_first, center.y + y for y <= to_last, one of them isn't negative
+    int64_t to_first = center.y;
+    int64_t to_last = static_cast<int64_t>(clip.height) - 1 - center.y;
+    int64_t lo = std::max<int64_t>({0, -to_first, -to_last});
+    int64_t hi = std::min<int64_t>(std::max(to_first, to_last), b);
+    if (lo > hi) {
+        return false;
+    }
+    y_lo = static_cast<int>(lo);
+    y_hi = static_cast<int>(hi);
+    return true;
+}
+
+// calls run(row, x_begin, x_end) with the visible part of the quadrant run [x_begin, x_end]
+// mirrored by sx, sy; the pixels on the axes only belong to the positive side
+template<typename RUN>
+static void clip_ellipse_run(Pixel center, int y, int x_begin, int x_end, const ClipRect& clip, RUN&& run) {
+    for (int sy : {1, -1}) {
+        if (sy < 0 && y == 0) {
+            break;
+        }
+        int row = center.y + sy * y;
+        if (row < 0 || row >= clip.height) {
+            continue;
+        }
+        // right side, center.x + x in [0, width)
+        int begin = std::max(x_begin, -center.x);
+        int end = std::min(x_end, clip.width - 1 - center.x);
+        if (begin <= end) {
+            run(row, center.x + begin, center.x + end);
+        }
+        // left side, center.x - x in [0, width)
+        begin = std::max({x_begin, 1, center.x - clip.width + 1});
+        end = std::min(x_end, center.x);
+        if (begin <= end) {
+            run(row, center.x - end, center.x - begin);
+        }
+    }
+}
+
+void draw_ellipse(Pixel start, Pixel end, std::vector<Pixel>& pixels, const ClipRect& clip) {
+    int a = abs(end.x - start.x);
+    int b = abs(end.y - start.y);
+    int visibility = ellipse_visibility(start, a, b, clip);
+    if (visibility != 0) {
+        if (visibility > 0) {
+            draw_ellipse(start, end, pixels);
+        }
+        return;
+    }
+    int y_lo, y_hi;
+    if (!ellipse_rows(start, b, clip, y_lo, y_hi)) {
+        return;
+    }
+    ellipse_quadrant(a, b, y_lo, y_hi, [&](int y, int x_begin, int x_end) {
+        clip_ellipse_run(start, y, x_begin, x_end, clip, [&](int row, int x0, int x1) {
+            for (int x = x0; x <= x1; ++x) {
+                pixels.emplace_back(x, row);
+            }
+        });
+    });
+}
+
+void draw_ellipse_spans(Pixel start, Pixel end, std::vector<Span>& spans, const ClipRect& clip) {
+    int a = abs(end.x - start.x);
+    int b = abs(end.y - start.y);
+    int visibility = ellipse_visibility(start, a, b, clip);
+    if (visibility != 0) {
+        if (visibility > 0) {
+            draw_ellipse_spans(start, end, spans);
+        }
+        return;
+    }
+    int y_lo, y_hi;
+    if (!ellipse_rows(start, b, clip, y_lo, y_hi)) {
+        return;
+    }
+    ellipse_quadrant(a, b, y_lo, y_hi, [&](int y, int x_begin, int x_end) {
+        clip_ellipse_run(start, y, x_begin, x_end, clip, [&](int row, int x0, int x1) {
+            // the halves of the top and bottom rows touch at the axis
+            if (!spans.empty() && spans.back().y == row && spans.back().x_begin == x1 + 1) {
+                spans.back().x_begin = x0;
+            } else {
+                spans.emplace_back(row, x0, x1 + 1);
+            }
+        });
+    });
+}
+
+void fill_ellipse_spans(Pixel start, Pixel end, std::vector<Span>& spans, const ClipRect& clip) {
+    int a = abs(end.x - start.x);
+    int b = abs(end.y - start.y);
+    int visibility = ellipse_visibility(start, a, b, clip);
+    if (visibility != 0) {
+        if (visibility > 0) {
+            fill_ellipse_spans(start, end, spans);
+        }
+        return;
+    }
+    int y_lo, y_hi;
+    if (!ellipse_rows(start, b, clip, y_lo, y_hi)) {
+        return;
+    }
+    ellipse_quadrant(a, b, y_lo, y_hi, [&](int y, int, int x_end) {
+        int x0 = std::max(start.x - x_end, 0);
+        int x1 = std::min(start.x + x_end + 1, clip.width);
+        if (x0 >= x1) {
+            return;
+        }
+        for (int sy : {1, -1}) {
+            if (sy < 0 && y == 0) {
+                break;
+            }
+            int row = start.y + sy * y;
+            if (row >= 0 && row < clip.height) {
+                spans.emplace_back(row, x0, x1);
+            }
+        }
+    });
 }
@@ -9,6 +9,41 @@
 
 void draw_line_dda(Pixel start, Pixel end, std::vector<Pixel>& pixels);
 void draw_line_bresenham(Pixel start, Pixel end, std::vector<Pixel>& pixels);
+// ellipse centered at start, the semi-axes are the distances of end from it along x and y
 void draw_ellipse(Pixel start, Pixel end, std::vector<Pixel>& pixels);
 
+// Span versions write into memory the caller already owns, out must hold line_pixel_count(start, end)
+// pixels. The pixels are the same as the vector version: from start to end, the minor axis rounded
+// to the nearest pixel with halves rounded towards start.
+size_t line_pixel_count(Pixel start, Pixel end);
+size_t draw_line_bresenham(Pixel start, Pixel end, Pixel *out);
+// the kernels behind it, draw_line_bresenham uses the AVX2 one when it is compiled in
+size_t draw_line_bresenham_scalar(Pixel start, Pixel end, Pixel *out);
+#ifdef __AVX2__
+size_t draw_line_bresenham_avx2(Pixel start, Pixel end, Pixel *out);
+#endif
+
+// Run-length output, much less to upload than one point per pixel for anything mostly horizontal.
+// draw_line_spans covers the same pixels as draw_line_bresenham without visiting them one by one.
+void draw_line_spans(Pixel start, Pixel end, std::vector<Span>& spans);
+// merges horizontally adjacent pixels of the same row, in order, for rasterizers without a span mode
+void append_spans(const Pixel *pixels, size_t count, std::vector<Span>& spans);
+// the outline of draw_ellipse as spans, and the filled ellipse as one span per row
+void draw_ellipse_spans(Pixel start, Pixel end, std::vector<Span>& spans);
+void fill_ellipse_spans(Pixel start, Pixel end, std::vector<Span>& spans);
+
+// Clipped versions: only the pixels inside clip are produced, so a cursor dragged far off the window
+// doesn't fill huge vectors. The lines are clipped in their step parameter before any pixel is
+// visited, leaving the same pixels as the unclipped line within clip. The ellipses are rejected or
+// accepted whole by their bounding box, otherwise only the rows inside clip are computed, each on its
+// own, and cut to its width; the cost follows the visible rows, not the size of the ellipse.
+void draw_line_dda(Pixel start, Pixel end, std::vector<Pixel>& pixels, const ClipRect& clip);
+void draw_line_bresenham(Pixel start, Pixel end, std::vector<Pixel>& pixels, const ClipRect& clip);
+size_t line_pixel_count(Pixel start, Pixel end, const ClipRect& clip);
+size_t draw_line_bresenham(Pixel start, Pixel end, const ClipRect& clip, Pixel *out);
+void draw_line_spans(Pixel start, Pixel end, std::vector<Span>& spans, const ClipRect& clip);
+void draw_ellipse(Pixel start, Pixel end, std::vector<Pixel>& pixels, const ClipRect& clip);
+void draw_ellipse_spans(Pixel start, Pixel end, std::vector<Span>& spans, const ClipRect& clip);
+void fill_ellipse_spans(Pixel start, Pixel end, std::vector<Span>& spans, const ClipRect& clip);
+
 #endif // RASTERIZATION_H
@@ -81,3 +81,15 @@ void Shader::use_program() {
 void Shader::delete_program() {
     glDeleteProgram(id);
 }
+
+void Shader::set_int(const char *name, int v) {
+    glUniform1i(glGetUniformLocation(id, name), v);
+}
+
+void Shader::set_ivec2(const char *name, int x, int y) {
+    glUniform2i(glGetUniformLocation(id, name), x, y);
+}
+
+void Shader::set_vec3(const char *name, float x, float y, float z) {
+    glUniform3f(glGetUniformLocation(id, name), x, y, z);
+}
@@ -19,6 +19,9 @@ public:
     ~Shader();
     void use_program();
     void delete_program();
+    void set_int(const char *name, int v);
+    void set_ivec2(const char *name, int x, int y);
+    void set_vec3(const char *name, float x, float y, float z);
 private:
     uint32_t id;
     void check_compile_errors(uint32_t shader, int type);
@@ -1,7 +1,10 @@
 #version 330 core
 
+// black unless set, the selection is drawn over the canvas in another color
+uniform vec3 color;
+
 out vec4 FragColor;
 
 void main() {
-   FragColor = vec4(0.0f, 0.0f, 0.0f, 1.0f);
-}
\ No newline at end of file
+   FragColor = vec4(color, 1.0f);
+}
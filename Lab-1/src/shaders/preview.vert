@@ -0,0 +1,49 @@
+#version 330 core
+
+// The primitive being dragged, expanded from gl_VertexID: only the endpoints are uploaded, as
+// uniforms. The lines are the pixels of the CPU rasterizers (the same closed form as the Bresenham
+// kernels), the ellipses approximate them: the outline is sampled densely enough to leave no gaps
+// and the filled one is a GL_LINES span per row. Positions are pixel centers in window pixels like
+// Pixel::to_vertex and the span ends.
+uniform int mode; // 1 dda, 2 bresenham, 3 ellipse, 4 filled ellipse
+uniform ivec2 start;
+uniform ivec2 end;
+uniform ivec2 viewport;
+uniform int vertex_count;
+
+vec4 to_ndc(vec2 p) {
+    p += 0.5;
+    return vec4(p.x / float(viewport.x) * 2.0 - 1.0, -(p.y / float(viewport.y) * 2.0) + 1.0, 0.0, 1.0);
+}
+
+void main() {
+    int i = gl_VertexID;
+    ivec2 d = end - start;
+    ivec2 ad = abs(d);
+    ivec2 s = ivec2(d.x >= 0 ? 1 : -1, d.y >= 0 ? 1 : -1);
+
+    if (mode == 1) {
+        int steps = max(ad.x, ad.y);
+        vec2 inc = steps == 0 ? vec2(0.0) : vec2(d) / float(steps);
+        // truncated like the float to int conversion of the CPU version
+        gl_Position = to_ndc(vec2(ivec2(vec2(start) + inc * float(i))));
+    } else if (mode == 2) {
+        bool steep = ad.x < ad.y;
+        int d_major = steep ? ad.y : ad.x;
+        int d_minor = steep ? ad.x : ad.y;
+        int m = d_major == 0 ? 0 : (2 * i * d_minor + d_major - 1) / (2 * d_major);
+        ivec2 p = steep ? ivec2(start.x + s.x * m, start.y + s.y * i) : ivec2(start.x + s.x * i, start.y + s.y * m);
+        gl_Position = to_ndc(vec2(p));
+    } else if (mode == 3) {
+        float angle = 6.28318530718 * float(i) / float(vertex_count);
+        vec2 p = vec2(start) + floor(vec2(ad) * vec2(cos(angle), sin(angle)) + 0.5);
+        gl_Position = to_ndc(p);
+    } else {
+        // vertex 2 k and 2 k + 1 are the ends of row k, from start.y - b to start.y + b
+        int row = i / 2 - ad.y;
+        float t = ad.y == 0 ? 0.0 : float(row) / float(ad.y);
+        float half_width = floor(float(ad.x) * sqrt(max(0.0, 1.0 - t * t)) + 0.5);
+        float x = (i % 2 == 0) ? float(start.x) - half_width : float(start.x) + half_width + 1.0;
+        gl_Position = to_ndc(vec2(x, float(start.y + row)));
+    }
+}
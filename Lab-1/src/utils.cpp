@@ -7,8 +7,9 @@ Pixel::Pixel() : x(0), y(0) {}
 Pixel::Pixel(int x, int y) : x(x), y(y) {}
 
 Vector2f Pixel::to_vertex(int width, int height) {
-    return Vector2f((static_cast<float>(x) / static_cast<float>(width) * 2) - 1.0f, 
-                    -(static_cast<float>(y) / static_cast<float>(height) * 2) + 1.0f);
+    // the pixel center, like the span ends, so both light the same row
+    return Vector2f(((static_cast<float>(x) + 0.5f) / static_cast<float>(width) * 2) - 1.0f,
+                    -((static_cast<float>(y) + 0.5f) / static_cast<float>(height) * 2) + 1.0f);
 }
 
 Pixel Pixel::operator+(const Pixel& other) const {
@@ -26,3 +27,32 @@ bool Pixel::operator==(const Pixel& other) const {
 bool Pixel::operator!=(const Pixel& other) const {
     return x != other.x || y != other.y;
 }
+
+Span::Span() : y(0), x_begin(0), x_end(0) {}
+
+Span::Span(int y, int x_begin, int x_end) : y(y), x_begin(x_begin), x_end(x_end) {}
+
+int Span::length() const {
+    return x_end - x_begin;
+}
+
+Vector2f Span::begin_vertex(int width, int height) const {
+    return Vector2f(((static_cast<float>(x_begin) + 0.5f) / static_cast<float>(width) * 2) - 1.0f,
+                    -((static_cast<float>(y) + 0.5f) / static_cast<float>(height) * 2) + 1.0f);
+}
+
+Vector2f Span::end_vertex(int width, int height) const {
+    // the last pixel of a line is left out by the diamond exit rule, so x_end is one past the run
+    return Vector2f(((static_cast<float>(x_end) + 0.5f) / static_cast<float>(width) * 2) - 1.0f,
+                    -((static_cast<float>(y) + 0.5f) / static_cast<float>(height) * 2) + 1.0f);
+}
+
+bool Span::operator==(const Span& other) const {
+    return y == other.y && x_begin == other.x_begin && x_end == other.x_end;
+}
+
+ClipRect::ClipRect(int width, int height) : width(width), height(height) {}
+
+bool ClipRect::contains(const Pixel& pixel) const {
+    return pixel.x >= 0 && pixel.x < width && pixel.y >= 0 && pixel.y < height;
+}
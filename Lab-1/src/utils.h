@@ -19,4 +19,23 @@ struct Pixel {
     bool operator!=(const Pixel& other) const;
 };
 
+// a horizontal run of pixels, [x_begin, x_end) on row y
+struct Span {
+    int y, x_begin, x_end;
+    Span();
+    Span(int y, int x_begin, int x_end);
+    int length() const;
+    // ends of a GL_LINES segment through the pixel centers, it covers exactly the run
+    Vector2f begin_vertex(int width, int height) const;
+    Vector2f end_vertex(int width, int height) const;
+    bool operator==(const Span& other) const;
+};
+
+// the framebuffer rectangle the rasterizers clip against, pixels [0, width) x [0, height)
+struct ClipRect {
+    int width, height;
+    ClipRect(int width, int height);
+    bool contains(const Pixel& pixel) const;
+};
+
 #endif // UTILS_H
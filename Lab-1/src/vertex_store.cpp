@@ -0,0 +1,127 @@
+#include "vertex_store.h"
+
+VertexStore::VertexStore(GLenum mode, uint32_t chunk_vertices) : mode(mode), allocator(chunk_vertices) {}
+
+VertexStore::~VertexStore() {
+    for (size_t i = 0; i < vaos.size(); ++i) {
+        if (vaos[i] != 0) {
+            glDeleteVertexArrays(1, &vaos[i]);
+            glDeleteBuffers(1, &vbos[i]);
+        }
+    }
+}
+
+void VertexStore::create_chunks() {
+    vaos.resize(allocator.chunk_slots(), 0);
+    vbos.resize(allocator.chunk_slots(), 0);
+    for (uint32_t i = 0; i < allocator.chunk_slots(); ++i) {
+        if (allocator.chunk_active(i) && vaos[i] == 0) {
+            glGenVertexArrays(1, &vaos[i]);
+            glBindVertexArray(vaos[i]);
+            glGenBuffers(1, &vbos[i]);
+            glBindBuffer(GL_ARRAY_BUFFER, vbos[i]);
+            glBufferData(GL_ARRAY_BUFFER, allocator.chunk_vertices() * sizeof(Vector2f), nullptr, GL_DYNAMIC_DRAW);
+            glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vector2f), 0);
+            glEnableVertexAttribArray(0);
+            glBindVertexArray(0);
+        }
+    }
+}
+
+void VertexStore::delete_chunks() {
+    for (uint32_t i = 0; i < vaos.size(); ++i) {
+        if (!allocator.chunk_active(i) && vaos[i] != 0) {
+            glDeleteVertexArrays(1, &vaos[i]);
+            glDeleteBuffers(1, &vbos[i]);
+            vaos[i] = 0;
+            vbos[i] = 0;
+        }
+    }
+}
+
+uint32_t VertexStore::append(const std::pmr::vector<Vector2f>& vertices) {
+    pieces.clear();
+    auto handle = allocator.allocate(static_cast<uint32_t>(vertices.size()), pieces);
+    create_chunks();
+
+    const Vector2f *data = vertices.data();
+    for (const auto& piece : pieces) {
+        glBindBuffer(GL_ARRAY_BUFFER, vbos[piece.chunk]);
+        glBufferSubData(GL_ARRAY_BUFFER, piece.first * sizeof(Vector2f), piece.count * sizeof(Vector2f), data);
+        data += piece.count;
+    }
+    return handle;
+}
+
+void VertexStore::append(const std::pmr::vector<Vector2f>& vertices, const std::vector<uint32_t>& ends,
+                         std::vector<uint32_t>& handles) {
+    pieces.clear();
+    uint32_t begin = 0;
+    for (auto end : ends) {
+        handles.push_back(allocator.allocate(end - begin, pieces));
+        begin = end;
+    }
+    create_chunks();
+
+    // consecutive allocations follow each other in a chunk, their pieces are uploaded together
+    const Vector2f *data = vertices.data();
+    for (size_t i = 0; i < pieces.size(); ) {
+        auto chunk = pieces[i].chunk;
+        auto first = pieces[i].first;
+        uint32_t count = 0;
+        for (; i < pieces.size() && pieces[i].chunk == chunk && pieces[i].first == first + count; ++i) {
+            count += pieces[i].count;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, vbos[chunk]);
+        glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(Vector2f), count * sizeof(Vector2f), data);
+        data += count;
+    }
+}
+
+void VertexStore::erase(uint32_t handle) {
+    allocator.free(handle);
+    delete_chunks();
+}
+
+void VertexStore::clear() {
+    allocator.clear();
+}
+
+uint32_t VertexStore::compact(uint32_t budget) {
+    moves.clear();
+    auto moved = allocator.compact(budget, moves);
+    // the destination chunks must exist before the copies, an emptied source is deleted after them
+    create_chunks();
+    for (const auto& move : moves) {
+        glBindBuffer(GL_COPY_READ_BUFFER, vbos[move.src_chunk]);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, vbos[move.dst_chunk]);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, move.src_first * sizeof(Vector2f),
+                            move.dst_first * sizeof(Vector2f), move.count * sizeof(Vector2f));
+    }
+    delete_chunks();
+    return moved;
+}
+
+void VertexStore::draw() {
+    for (uint32_t i = 0; i < allocator.chunk_slots(); ++i) {
+        if (!allocator.chunk_active(i)) {
+            continue;
+        }
+        const auto& firsts = allocator.firsts(i);
+        const auto& counts = allocator.counts(i);
+        if (firsts.empty()) {
+            continue;
+        }
+        glBindVertexArray(vaos[i]);
+        glMultiDrawArrays(mode, firsts.data(), counts.data(), static_cast<GLsizei>(firsts.size()));
+    }
+    glBindVertexArray(0);
+}
+
+void VertexStore::draw(uint32_t handle) {
+    for (const auto& piece : allocator.pieces(handle)) {
+        glBindVertexArray(vaos[piece.chunk]);
+        glDrawArrays(mode, static_cast<GLint>(piece.first), static_cast<GLsizei>(piece.count));
+    }
+    glBindVertexArray(0);
+}
@@ -0,0 +1,56 @@
+#ifndef VERTEX_STORE_H
+#define VERTEX_STORE_H
+
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <memory_resource>
+#include "glad/glad.h"
+#include "utils.h"
+#include "chunk_allocator.h"
+
+// Vertices of one primitive mode in fixed size GPU chunks that are only created when the drawing
+// needs them, so there is no upper bound on what can be drawn and nothing is reserved up front.
+// Every chunk has its own buffer and vertex array and is drawn with one glMultiDrawArrays over its
+// live ranges. compact() moves the live vertices of mostly freed chunks with GPU side copies and
+// deletes the emptied buffers; calling it once a frame with a small budget keeps it in the background.
+class VertexStore {
+public:
+    static const uint32_t CHUNK_VERTICES = 1 << 16; // 512 KB of Vector2f
+
+    explicit VertexStore(GLenum mode, uint32_t chunk_vertices = CHUNK_VERTICES);
+    ~VertexStore();
+    VertexStore(const VertexStore&) = delete;
+    VertexStore& operator=(const VertexStore&) = delete;
+
+    // returns a handle for erase
+    uint32_t append(const std::pmr::vector<Vector2f>& vertices);
+    // One handle per range of vertices, ends[i] being where range i ends, so the ranges can be erased
+    // one by one; uploaded with one call per chunk.
+    void append(const std::pmr::vector<Vector2f>& vertices, const std::vector<uint32_t>& ends, std::vector<uint32_t>& handles);
+    void erase(uint32_t handle);
+    void clear();
+    // returns the vertices moved
+    uint32_t compact(uint32_t budget);
+    void draw();
+    // only the vertices of one append
+    void draw(uint32_t handle);
+
+    uint64_t size() const { return allocator.live_vertices(); }
+    size_t chunk_count() const { return allocator.active_chunks(); }
+    size_t gpu_bytes() const { return allocator.active_chunks() * allocator.chunk_vertices() * sizeof(Vector2f); }
+
+private:
+    // GL objects for the chunks the allocator started, and deleting the ones it released
+    void create_chunks();
+    void delete_chunks();
+
+    GLenum mode;
+    ChunkAllocator allocator;
+    std::vector<GLuint> vaos;
+    std::vector<GLuint> vbos;
+    std::vector<ChunkAllocator::Piece> pieces;
+    std::vector<ChunkAllocator::Move> moves;
+};
+
+#endif // VERTEX_STORE_H
@@ -0,0 +1,29 @@
+#include "frame_scheduler.h"
+#include <algorithm>
+#include "GLFW/glfw3.h"
+
+FrameScheduler::FrameScheduler(double idle_timeout) : idle_timeout(idle_timeout) {}
+
+void FrameScheduler::wait_events() {
+    if (pending_frames > 0) {
+        pending_frames--;
+    }
+    slept = on_demand && !animating && pending_frames == 0;
+    if (!slept) {
+        glfwPollEvents();
+        return;
+    }
+
+    double before = glfwGetTime();
+    glfwWaitEventsTimeout(idle_timeout);
+    double waited = glfwGetTime() - before;
+    asleep += waited;
+    // woken before the timeout, by an event
+    if (waited < idle_timeout) {
+        request_redraw();
+    }
+}
+
+void FrameScheduler::request_redraw(uint32_t frames) {
+    pending_frames = std::max(pending_frames, frames);
+}
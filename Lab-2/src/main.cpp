@@ -1,6 +1,7 @@
 #include <iostream>
 #include <cstdint>
 #include <vector>
+#include <ctime>
 
 #include "glad/glad.h"
 #include "GLFW/glfw3.h"
@@ -11,6 +12,7 @@
 
 #include "shader.h"
 #include "transformation.h"
+#include "frame_scheduler.h"
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void error_callback(int code, const char *description);
@@ -24,6 +26,9 @@ static float trans_x = 0.0f, trans_y = 0.0f, trans_z = 0.0f;
 static float camera_height = 0.0f;
 static float camera_angle = 0.0f;
 static float fov = 120.0f;
+static bool rotating = true;
+// sleep between events while the cube stands still
+static bool on_demand = true;
 
 int main(int argc, char **argv) {
     glfwInit();
@@ -130,36 +135,88 @@ int main(int argc, char **argv) {
 
     glEnable(GL_DEPTH_TEST);
 
+    // the angle only advances while rotating, so pausing doesn't make it jump
+    double rotation_angle = 0.0;
+    double last_time = glfwGetTime();
+    FrameScheduler scheduler;
+    double report_time = last_time, report_asleep = 0.0;
+    std::clock_t report_cpu = std::clock();
+    double cpu_percent = 0.0, asleep_percent = 0.0;
+
+    // each matrix is rebuilt only when its inputs changed, and the MVP uploaded when one of them was
+    Eigen::Matrix4f sca_mat, rot_mat, tra_mat, modl_mat, view_mat, proj_mat, mvp_mat;
+    bool sca_dirty = true, rot_dirty = true, tra_dirty = true, view_dirty = true, proj_dirty = true;
+    int matrices_rebuilt = 0;
+    shader.use_program();
+    uint32_t mvp_loc = glGetUniformLocation(shader.get_id(), "MVP");
+
     while (!glfwWindowShouldClose(window)) {
         process_input(window);
 
+        double now = glfwGetTime();
+        if (rotating && now != last_time) {
+            rotation_angle += (now - last_time) * 15.0;
+            rot_dirty = true;
+        }
+        last_time = now;
+        scheduler.set_animating(rotating);
+
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
         ImGui::Begin("Attributes");
-        ImGui::SliderFloat3("Scale", &scale_x, 0.4f, 1.6f);
-        ImGui::SliderFloat3("Translation", &trans_x, -0.5f, 0.5f);
-        ImGui::SliderFloat("Camera Height", &camera_height, -2.0f, 2.0f);
-        ImGui::SliderFloat("Camera Angle", &camera_angle, -180.0f, 180.0f);
-        ImGui::SliderFloat("fov", &fov, 60.0f, 160.0f);
+        sca_dirty |= ImGui::SliderFloat3("Scale", &scale_x, 0.4f, 1.6f);
+        tra_dirty |= ImGui::SliderFloat3("Translation", &trans_x, -0.5f, 0.5f);
+        view_dirty |= ImGui::SliderFloat("Camera Height", &camera_height, -2.0f, 2.0f);
+        view_dirty |= ImGui::SliderFloat("Camera Angle", &camera_angle, -180.0f, 180.0f);
+        proj_dirty |= ImGui::SliderFloat("fov", &fov, 60.0f, 160.0f);
+        ImGui::Checkbox("Rotate", &rotating);
+        if (ImGui::Checkbox("Render on demand", &on_demand)) {
+            scheduler.set_on_demand(on_demand);
+        }
+        ImGui::Text("%.0f%% cpu, %.0f%% asleep%s", cpu_percent, asleep_percent, scheduler.idle() ? " (idle)" : "");
+        ImGui::Text("%d matrices rebuilt last frame", matrices_rebuilt);
         ImGui::End();
 
         glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        Eigen::Matrix4f sca_mat = get_scaling_matrix(Eigen::Vector3f(scale_x, scale_y, scale_z));
-        Eigen::Matrix4f rot_mat = get_rotation_matrix(glfwGetTime() * 15.0);
-        Eigen::Matrix4f tra_mat = get_translation_matrix(Eigen::Vector3f(trans_x, trans_y, trans_z));
-
-        Eigen::Matrix4f modl_mat = tra_mat * rot_mat * sca_mat;
-        Eigen::Matrix4f view_mat = get_view_matrix(Eigen::Vector3f(1.5f * sin(camera_angle / 180 * PI), camera_height, 1.5f * cos(camera_angle / 180 * PI)));
-        Eigen::Matrix4f proj_mat = get_projection_matrix(fov, (float)SCR_WIDTH / SCR_HEIGHT, .1f, 10.0f);
-
-        Eigen::Matrix4f mvp_mat = proj_mat * view_mat * modl_mat;
+        matrices_rebuilt = 0;
+        bool modl_dirty = sca_dirty || rot_dirty || tra_dirty;
+        bool mvp_dirty = modl_dirty || view_dirty || proj_dirty;
+        if (sca_dirty) {
+            sca_mat = get_scaling_matrix(Eigen::Vector3f(scale_x, scale_y, scale_z));
+            matrices_rebuilt++;
+        }
+        if (rot_dirty) {
+            rot_mat = get_rotation_matrix(rotation_angle);
+            matrices_rebuilt++;
+        }
+        if (tra_dirty) {
+            tra_mat = get_translation_matrix(Eigen::Vector3f(trans_x, trans_y, trans_z));
+            matrices_rebuilt++;
+        }
+        if (modl_dirty) {
+            modl_mat = tra_mat * rot_mat * sca_mat;
+            matrices_rebuilt++;
+        }
+        if (view_dirty) {
+            view_mat = get_view_matrix(Eigen::Vector3f(1.5f * sin(camera_angle / 180 * PI), camera_height, 1.5f * cos(camera_angle / 180 * PI)));
+            matrices_rebuilt++;
+        }
+        if (proj_dirty) {
+            proj_mat = get_projection_matrix(fov, (float)SCR_WIDTH / SCR_HEIGHT, .1f, 10.0f);
+            matrices_rebuilt++;
+        }
+        sca_dirty = rot_dirty = tra_dirty = view_dirty = proj_dirty = false;
 
         shader.use_program();
-        uint32_t view_loc = glGetUniformLocation(shader.get_id(), "MVP");
-        glUniformMatrix4fv(view_loc, 1, GL_FALSE, mvp_mat.data());
+        // the uniform keeps its value in the program between frames
+        if (mvp_dirty) {
+            mvp_mat = proj_mat * view_mat * modl_mat;
+            glUniformMatrix4fv(mvp_loc, 1, GL_FALSE, mvp_mat.data());
+            matrices_rebuilt++;
+        }
 
         glBindVertexArray(VAO);
         //glDrawArrays(GL_TRIANGLES, 0, 3);
@@ -170,7 +227,17 @@ int main(int argc, char **argv) {
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
         glfwSwapBuffers(window);
-        glfwPollEvents();
+        scheduler.wait_events();
+
+        now = glfwGetTime();
+        if (now - report_time >= 1.0) {
+            std::clock_t cpu = std::clock();
+            cpu_percent = 100.0 * static_cast<double>(cpu - report_cpu) / CLOCKS_PER_SEC / (now - report_time);
+            asleep_percent = 100.0 * (scheduler.sleep_seconds() - report_asleep) / (now - report_time);
+            report_time = now;
+            report_cpu = cpu;
+            report_asleep = scheduler.sleep_seconds();
+        }
     }
 
     glDeleteVertexArrays(1, &VAO);
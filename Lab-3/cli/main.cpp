@@ -0,0 +1,340 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <cctype>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+
+#include "utils/tools.h"
+#include "utils/mesh_io.h"
+#include "utils/heap_stats.h"
+#include "mesh_simplification.h"
+
+// Headless batch simplification: no GL, GLFW or ImGui is linked in here.
+// Every worker owns at most one mesh at a time, so memory is bounded by the thread count.
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    fs::path input_dir;
+    fs::path output_dir;
+    fs::path report_path;
+    std::vector<float> ratios;
+    uint32_t threads = 0;
+    bool binary = true;
+};
+
+struct LevelReport {
+    float ratio = 0.0f;
+    size_t vertices = 0;
+    size_t faces = 0;
+    double simplify_ms = 0.0;
+    double write_ms = 0.0;
+    uint64_t allocations = 0; // heap allocations of the simplification, the rest of it is in the worker's arena
+    std::string output;
+};
+
+struct FileReport {
+    std::string input;
+    bool ok = false;
+    std::string error;
+    size_t vertices = 0;
+    size_t faces = 0;
+    double load_ms = 0.0;
+    double total_ms = 0.0;
+    std::vector<LevelReport> levels;
+};
+
+static double elapsed_ms(Clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - since).count();
+}
+
+static void print_usage(const char *name) {
+    std::cerr << "usage: " << name << " <input dir> [options]\n"
+              << "  -o, --output <dir>       output directory (default: <input dir>/simplified)\n"
+              << "  -r, --ratios <list>      comma separated face ratios of the original mesh (default: 0.5)\n"
+              << "  -j, --threads <n>        number of worker threads (default: hardware concurrency)\n"
+              << "  -f, --format <mesh|obj>  output format (default: mesh)\n"
+              << "      --report <file>      JSON report (default: <output dir>/report.json)\n";
+}
+
+static bool parse_options(int argc, char **argv, Options& opt) {
+    std::string format = "mesh";
+    std::string ratios = "0.5";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto has_value = i + 1 < argc;
+        if ((arg == "-o" || arg == "--output") && has_value) {
+            opt.output_dir = argv[++i];
+        } else if ((arg == "-r" || arg == "--ratios") && has_value) {
+            ratios = argv[++i];
+        } else if ((arg == "-j" || arg == "--threads") && has_value) {
+            opt.threads = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        } else if ((arg == "-f" || arg == "--format") && has_value) {
+            format = argv[++i];
+        } else if (arg == "--report" && has_value) {
+            opt.report_path = argv[++i];
+        } else if (!arg.empty() && arg[0] != '-' && opt.input_dir.empty()) {
+            opt.input_dir = arg;
+        } else {
+            return false;
+        }
+    }
+
+    if (opt.input_dir.empty() || (format != "mesh" && format != "obj")) {
+        return false;
+    }
+    opt.binary = format == "mesh";
+
+    std::stringstream ss(ratios);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        auto ratio = std::strtof(item.c_str(), nullptr);
+        if (ratio <= 0.0f || ratio >= 1.0f) {
+            std::cerr << "[E] Ratio out of (0, 1): " << item << std::endl;
+            return false;
+        }
+        opt.ratios.push_back(ratio);
+    }
+    if (opt.ratios.empty()) {
+        return false;
+    }
+    // levels are produced from the previous one, finest first
+    std::sort(opt.ratios.begin(), opt.ratios.end(), std::greater<>());
+    opt.ratios.erase(std::unique(opt.ratios.begin(), opt.ratios.end()), opt.ratios.end());
+
+    if (opt.output_dir.empty()) {
+        opt.output_dir = opt.input_dir / "simplified";
+    }
+    if (opt.report_path.empty()) {
+        opt.report_path = opt.output_dir / "report.json";
+    }
+    if (opt.threads == 0) {
+        opt.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    return true;
+}
+
+static std::vector<fs::path> collect_inputs(const Options& opt) {
+    std::vector<fs::path> inputs;
+    std::error_code ec;
+    auto output_dir = fs::weakly_canonical(opt.output_dir, ec);
+    for (auto it = fs::recursive_directory_iterator(opt.input_dir, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (it->is_directory() && fs::weakly_canonical(it->path(), ec) == output_dir) {
+            it.disable_recursion_pending();
+            continue;
+        }
+        auto ext = it->path().extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (it->is_regular_file() && ext == ".obj") {
+            inputs.push_back(it->path());
+        }
+    }
+    std::sort(inputs.begin(), inputs.end());
+    return inputs;
+}
+
+static void process_file(const fs::path& input, const Options& opt, FileReport& report) {
+    auto start = Clock::now();
+    report.input = input.string();
+
+    MeshData mesh;
+    if (!Utils::load_obj(input.string(), mesh)) {
+        report.error = "failed to load";
+        return;
+    }
+    report.vertices = mesh.vertex_count();
+    report.faces = mesh.face_count();
+    report.load_ms = elapsed_ms(start);
+    if (mesh.empty()) {
+        report.error = "no faces";
+        return;
+    }
+
+    auto out_dir = opt.output_dir / input.lexically_relative(opt.input_dir).parent_path();
+    std::error_code ec;
+    fs::create_directories(out_dir, ec);
+
+    // one pass over the faces for the whole chain, every level updates the sums of the one before
+    Utils::NormalAccumulator accumulator(mesh.positions, mesh.indices);
+    std::vector<int> previous_ids;
+    float current_ratio = 1.0f;
+    for (auto ratio : opt.ratios) {
+        LevelReport level;
+        level.ratio = ratio;
+
+        auto level_start = Clock::now();
+        auto allocations = Utils::thread_heap_allocation_count();
+        mesh = simplify_mesh(std::move(mesh), ratio / current_ratio, accumulator, previous_ids);
+        current_ratio = ratio;
+        level.simplify_ms = elapsed_ms(level_start);
+        level.allocations = Utils::thread_heap_allocation_count() - allocations;
+        level.vertices = mesh.vertex_count();
+        level.faces = mesh.face_count();
+
+        char suffix[32];
+        std::snprintf(suffix, sizeof(suffix), "_%g%s", ratio, opt.binary ? ".mesh" : ".obj");
+        auto output = (out_dir / (input.stem().string() + suffix)).string();
+        auto write_start = Clock::now();
+        auto written = opt.binary ? Utils::save_mesh(output, mesh) : Utils::save_obj(output, mesh);
+        level.write_ms = elapsed_ms(write_start);
+        level.output = output;
+        report.levels.push_back(std::move(level));
+        if (!written) {
+            report.error = "failed to write " + output;
+            report.total_ms = elapsed_ms(start);
+            return;
+        }
+    }
+
+    report.ok = true;
+    report.total_ms = elapsed_ms(start);
+}
+
+static std::string json_string(const std::string& str) {
+    std::string out = "\"";
+    for (auto c : str) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            } else {
+                out += c;
+            }
+        }
+    }
+    return out + "\"";
+}
+
+static bool write_report(const Options& opt, const std::vector<FileReport>& reports, double wall_ms) {
+    std::ofstream file(opt.report_path);
+    if (!file.is_open()) {
+        std::cerr << "[E] Failed to open file: " << opt.report_path << std::endl;
+        return false;
+    }
+
+    size_t failed = 0;
+    size_t total_faces = 0;
+    for (const auto& r : reports) {
+        failed += r.ok ? 0 : 1;
+        total_faces += r.faces;
+    }
+
+    file << std::fixed << std::setprecision(3);
+    file << "{\n";
+    file << "  \"input_dir\": " << json_string(opt.input_dir.string()) << ",\n";
+    file << "  \"threads\": " << opt.threads << ",\n";
+    file << "  \"ratios\": [";
+    for (size_t i = 0; i < opt.ratios.size(); ++i) {
+        file << (i ? ", " : "") << opt.ratios[i];
+    }
+    file << "],\n";
+    file << "  \"files\": " << reports.size() << ",\n";
+    file << "  \"failed\": " << failed << ",\n";
+    file << "  \"input_faces\": " << total_faces << ",\n";
+    file << "  \"wall_ms\": " << wall_ms << ",\n";
+    file << "  \"files_per_second\": " << (wall_ms > 0.0 ? reports.size() * 1000.0 / wall_ms : 0.0) << ",\n";
+    file << "  \"faces_per_second\": " << (wall_ms > 0.0 ? total_faces * 1000.0 / wall_ms : 0.0) << ",\n";
+    file << "  \"results\": [";
+    for (size_t i = 0; i < reports.size(); ++i) {
+        const auto& r = reports[i];
+        file << (i ? "," : "") << "\n    {\n";
+        file << "      \"input\": " << json_string(r.input) << ",\n";
+        file << "      \"ok\": " << (r.ok ? "true" : "false") << ",\n";
+        if (!r.ok) {
+            file << "      \"error\": " << json_string(r.error) << ",\n";
+        }
+        file << "      \"vertices\": " << r.vertices << ",\n";
+        file << "      \"faces\": " << r.faces << ",\n";
+        file << "      \"load_ms\": " << r.load_ms << ",\n";
+        file << "      \"total_ms\": " << r.total_ms << ",\n";
+        file << "      \"faces_per_second\": " << (r.total_ms > 0.0 ? r.faces * 1000.0 / r.total_ms : 0.0) << ",\n";
+        file << "      \"levels\": [";
+        for (size_t j = 0; j < r.levels.size(); ++j) {
+            const auto& l = r.levels[j];
+            file << (j ? "," : "") << "\n        {"
+                 << "\"ratio\": " << l.ratio
+                 << ", \"vertices\": " << l.vertices
+                 << ", \"faces\": " << l.faces
+                 << ", \"simplify_ms\": " << l.simplify_ms
+                 << ", \"write_ms\": " << l.write_ms
+                 << ", \"allocations\": " << l.allocations
+                 << ", \"output\": " << json_string(l.output) << "}";
+        }
+        file << (r.levels.empty() ? "]\n" : "\n      ]\n");
+        file << "    }";
+    }
+    file << (reports.empty() ? "]\n" : "\n  ]\n");
+    file << "}\n";
+
+    return static_cast<bool>(file);
+}
+
+int main(int argc, char **argv) {
+    Options opt;
+    if (!parse_options(argc, argv, opt)) {
+        print_usage(argv[0]);
+        return -1;
+    }
+
+    auto inputs = collect_inputs(opt);
+    if (inputs.empty()) {
+        std::cerr << "[E] No OBJ files found in " << opt.input_dir << std::endl;
+        return -2;
+    }
+    std::error_code ec;
+    fs::create_directories(opt.output_dir, ec);
+
+    std::vector<FileReport> reports(inputs.size());
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> done(0);
+    std::mutex log_mutex;
+
+    auto worker = [&]() {
+        for (auto i = next.fetch_add(1); i < inputs.size(); i = next.fetch_add(1)) {
+            process_file(inputs[i], opt, reports[i]);
+            const auto& r = reports[i];
+            std::lock_guard<std::mutex> lock(log_mutex);
+            std::cerr << "[" << (r.ok ? "I" : "E") << "] (" << ++done << "/" << inputs.size() << ") "
+                      << r.input << ": " << r.faces << " faces, " << r.total_ms << " ms"
+                      << (r.ok ? "" : " - " + r.error) << std::endl;
+        }
+    };
+
+    auto start = Clock::now();
+    auto thread_cnt = std::min<size_t>(opt.threads, inputs.size());
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < thread_cnt; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& t : workers) {
+        t.join();
+    }
+    auto wall_ms = elapsed_ms(start);
+
+    if (!write_report(opt, reports, wall_ms)) {
+        return -3;
+    }
+    std::cerr << "[I] " << inputs.size() << " files in " << wall_ms << " ms, report: " << opt.report_path << std::endl;
+
+    bool all_ok = std::all_of(reports.begin(), reports.end(), [](const FileReport& r) { return r.ok; });
+    return all_ok ? 0 : 1;
+}
@@ -12,12 +12,17 @@
 #include "utils/shader.h"
 #include "utils/camera.h"
 #include "utils/model.h"
+#include "utils/mesh_io.h"
+#include "utils/lod_chain.h"
+#include "utils/arena.h"
+#include "utils/heap_stats.h"
 #include "utils/tools.h"
 #include "mesh_simplification.h"
 
 using Utils::Camera;
 using Utils::Shader;
 using Utils::Model;
+using Utils::LodChain;
 
 // declare callbacks
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
@@ -50,7 +55,7 @@ bool is_b_pressing = false;
 bool shows_border = false;
 
 // model simplification
-std::vector<std::unique_ptr<Model>> meshes;
+std::unique_ptr<LodChain> meshes;
 int current_index = 0;
 float simplification_ratio = 0.8f;
 
@@ -113,14 +118,25 @@ int main(int argc, char **argv) {
 
     border_shader.set_vecf3("border_color", border_color);
     
-    // load meshes
-    meshes.emplace_back(Model::load(RESOURCES_DIR"/squirrel.obj"));
+    // load meshes, all the simplified levels share the buffers of this chain
+    MeshData squirrel;
+    if (!Utils::load_mesh_file(RESOURCES_DIR"/squirrel.obj", squirrel)) {
+        glfwTerminate();
+        return -3;
+    }
+    Utils::normalize_mesh(squirrel);
+    meshes = std::make_unique<LodChain>(std::move(squirrel));
     
     glEnable(GL_CULL_FACE);
 
     glEnable(GL_DEPTH_TEST);
 
+    // operator new calls per frame, a steady frame should make none
+    uint64_t frame_allocations = 0;
+    uint64_t allocations_before = Utils::heap_allocation_count();
+
     while (!glfwWindowShouldClose(window)) {
+        Utils::Arena::local().reset();
         // record time
         auto current_frame = static_cast<float>(glfwGetTime());
         delta_time = current_frame - last_frame;
@@ -130,7 +146,7 @@ int main(int argc, char **argv) {
         if (!is_changing) {
             process_input(window);
         } else {
-             if (current_index < meshes.size() - 1) {
+             if (current_index < meshes->size() - 1) {
                  current_index += 1;
              } else {
                  is_changing = false;
@@ -141,18 +157,25 @@ int main(int argc, char **argv) {
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
         ImGui::Begin("Attributes");
-        ImGui::Text("vertices: %d", meshes[current_index]->positions.size());
-        ImGui::Text("faces: %d", meshes[current_index]->indices.size());
+        ImGui::Text("vertices: %zu", meshes->mesh(current_index).vertex_count());
+        ImGui::Text("faces: %zu", meshes->mesh(current_index).face_count());
+        ImGui::Text("level: %d / %zu", current_index, meshes->size() - 1);
+        ImGui::Text("level memory: %.1f KB (%.1f%% of level 0)", meshes->level_bytes(current_index) / 1024.0f,
+                    100.0f * meshes->level_bytes(current_index) / meshes->level_bytes(0));
+        ImGui::Text("chain memory: %.1f KB used, %.1f KB allocated (+%.1f%% over level 0)", meshes->used_bytes() / 1024.0f,
+                    meshes->allocated_bytes() / 1024.0f, 100.0f * (meshes->used_bytes() - meshes->level_bytes(0)) / meshes->level_bytes(0));
         ImGui::Text("borders: %s", shows_border ? "On" : "Off");
+        ImGui::Text("heap allocations last frame: %llu", static_cast<unsigned long long>(frame_allocations));
         ImGui::End();
 
         glClearColor(ambient[0], ambient[1], ambient[2], 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glPolygonMode(GL_FRONT_AND_BACK ,GL_FILL);
 
+        camera.set_viewport(SCR_WIDTH, SCR_HEIGHT, 0.1f, 100.0f);
         shader.set_vecf3("camera_pos", camera.position);
-        shader.set_matf4("projection", camera.get_projection_matrix(SCR_WIDTH, SCR_HEIGHT, 0.1f, 100.0f));
-        shader.set_matf4("view", camera.get_view_matrix());
+        shader.set_matf4("projection", camera.projection());
+        shader.set_matf4("view", camera.view());
 
         // render the model
         vecf3 model_pos(0.0f, 0.0f, 0.0f);
@@ -164,16 +187,16 @@ int main(int argc, char **argv) {
                            -sin(angle_y), 0.0f, cos(angle_y), model_pos[2],
                                     0.0f, 0.0f,         0.0f,         1.0f;
         shader.set_matf4("model", model_transform);
-        meshes[current_index]->va->draw(shader);
+        meshes->draw(shader, current_index);
 
         //render borders
         if (shows_border) {
             glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
             border_shader.set_vecf3("camera_pos", camera.position);
-            border_shader.set_matf4("projection", camera.get_projection_matrix(SCR_WIDTH, SCR_HEIGHT, 0.1f, 100.0f));
-            border_shader.set_matf4("view", camera.get_view_matrix());
+            border_shader.set_matf4("projection", camera.projection());
+            border_shader.set_matf4("view", camera.view());
             border_shader.set_matf4("model", model_transform);
-            meshes[current_index]->va->draw(border_shader);
+            meshes->draw(border_shader, current_index);
         }
 
         ImGui::Render();
@@ -181,8 +204,14 @@ int main(int argc, char **argv) {
 
         glfwSwapBuffers(window);
         glfwPollEvents();
+
+        auto allocations = Utils::heap_allocation_count();
+        frame_allocations = allocations - allocations_before;
+        allocations_before = allocations;
     }
 
+    // release the buffers while the context is still alive
+    meshes.reset();
     shader.delete_program();
 
     glfwTerminate();
@@ -250,11 +279,16 @@ void process_input(GLFWwindow *window) {
         is_left_pressing = false;
     }
     if ((glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_RELEASE) && is_right_pressing) {
-         if (current_index < meshes.size() - 1) {
+         if (current_index < meshes->size() - 1) {
              current_index += 1;
          } else {
-             if ((meshes[current_index]->indices).size() > 200) {
-                 meshes.emplace_back(simplify_mesh(meshes[current_index]->positions, meshes[current_index]->indices, simplification_ratio));
+             if (meshes->mesh(current_index).face_count() > 200) {
+                 // the current level stays displayable, so the simplifier works on a copy,
+                 // the chain's normal sums move on to the new level with it
+                 std::vector<int> previous_ids;
+                 auto simplified = simplify_mesh(MeshData(meshes->mesh(current_index)), simplification_ratio,
+                                                 meshes->accumulator(), previous_ids);
+                 meshes->append(std::move(simplified), previous_ids);
                  current_index += 1;
              }
          }
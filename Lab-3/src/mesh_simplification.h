@@ -13,17 +13,31 @@
 #include <tuple>
 #include <functional>
 #include <cassert>
+#include <deque>
+#include <memory_resource>
 
 #include "Eigen/Dense"
 
 #include "utils/tools.h"
-#include "utils/model.h"
+#include "utils/mesh_data.h"
+#include "utils/normal_accumulator.h"
+#include "utils/arena.h"
 
 #define EPSILON 1e-15
 
-using Utils::Model;
+using Utils::MeshData;
 
-Model *simplify_mesh(const std::vector<vecf3>& _vertices, const std::vector<veci3>& _faces, float ratio);
+// Pure CPU, it doesn't touch GL so it can also run in the headless batch tool.
+// The mesh is simplified in place and moved back out with matching normals,
+// pass a copy (MeshData(mesh)) to keep the original.
+MeshData simplify_mesh(MeshData&& mesh, float ratio);
+
+// The same, continuing from the sums in accumulator (which must belong to mesh) instead of summing
+// every face again, so a chain of levels only pays for the faces its collapses touch. On return the
+// accumulator follows the simplified mesh, its dirty vertices are the ones whose normal changed and
+// previous_ids[v] is the index the simplified vertex v had in mesh. The other vertices keep their
+// normal from mesh.
+MeshData simplify_mesh(MeshData&& mesh, float ratio, Utils::NormalAccumulator& accumulator, std::vector<int>& previous_ids);
 
 struct Edge {
     int first, second; // vertex id of the edge endpoints (first < second)
@@ -0,0 +1,95 @@
+#include "arena.h"
+
+#include <algorithm>
+#include <new>
+
+namespace Utils {
+
+Arena::Arena(size_t block_bytes, size_t retain_bytes) : block_bytes(block_bytes), retain_bytes(retain_bytes) {}
+
+Arena::~Arena() {
+    for (const auto& block : blocks) {
+        ::operator delete(block.data);
+    }
+}
+
+void Arena::rewind(Mark mark) {
+    if (mark.block == 0 && mark.offset == 0) {
+        reset();
+        return;
+    }
+    current = mark.block;
+    offset = mark.offset;
+}
+
+void Arena::reset() {
+    current = 0;
+    offset = 0;
+    size_t kept = 0;
+    size_t kept_bytes = 0;
+    for (const auto& block : blocks) {
+        // the first block always stays
+        if (kept == 0 || kept_bytes + block.size <= retain_bytes) {
+            blocks[kept++] = block;
+            kept_bytes += block.size;
+        } else {
+            ::operator delete(block.data);
+        }
+    }
+    blocks.resize(kept);
+}
+
+size_t Arena::used() const {
+    size_t bytes = offset;
+    for (size_t i = 0; i < current && i < blocks.size(); ++i) {
+        bytes += blocks[i].size;
+    }
+    return bytes;
+}
+
+size_t Arena::capacity() const {
+    size_t bytes = 0;
+    for (const auto& block : blocks) {
+        bytes += block.size;
+    }
+    return bytes;
+}
+
+Arena& Arena::local() {
+    thread_local Arena arena;
+    return arena;
+}
+
+void *Arena::do_allocate(size_t bytes, size_t alignment) {
+    for (;;) {
+        if (current < blocks.size()) {
+            auto& block = blocks[current];
+            auto address = reinterpret_cast<uintptr_t>(block.data) + offset;
+            size_t start = offset + ((alignment - address % alignment) % alignment);
+            if (start + bytes <= block.size) {
+                offset = start + bytes;
+                return block.data + start;
+            }
+            // the rest of the block stays unused until the next rewind
+            if (current + 1 < blocks.size()) {
+                current++;
+                offset = 0;
+                continue;
+            }
+        }
+        auto size = std::max(block_bytes, bytes + alignment);
+        blocks.push_back({static_cast<char *>(::operator new(size)), size});
+        current = blocks.size() - 1;
+        offset = 0;
+    }
+}
+
+void Arena::do_deallocate(void *, size_t, size_t) {
+    // monotonic, the memory comes back on rewind
+}
+
+bool Arena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+}
@@ -0,0 +1,77 @@
+#ifndef UTILS_ARENA_H
+#define UTILS_ARENA_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace Utils {
+
+// Monotonic allocator for the temporaries of one operation (a simplification, a load) or of a frame,
+// to be used with the std::pmr containers. Allocating bumps a pointer in the current block and
+// deallocating does nothing; rewinding keeps the blocks for the next operation, a reset gives back
+// the ones past retain_bytes. Not thread safe, every thread has its own from local(), so the batch
+// tool's workers never share one.
+class Arena : public std::pmr::memory_resource {
+public:
+    static constexpr size_t BLOCK_BYTES = 1 << 20;
+    static constexpr size_t RETAIN_BYTES = 64 << 20;
+
+    struct Mark {
+        size_t block, offset;
+    };
+
+    explicit Arena(size_t block_bytes = BLOCK_BYTES, size_t retain_bytes = RETAIN_BYTES);
+    ~Arena() override;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    Mark mark() const { return {current, offset}; }
+    // Everything allocated since the mark is dead afterwards, rewinding to the start is a reset
+    void rewind(Mark mark);
+    void reset();
+
+    size_t used() const;
+    size_t capacity() const;
+
+    // the arena of the calling thread
+    static Arena& local();
+
+private:
+    struct Block {
+        char *data;
+        size_t size;
+    };
+
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    size_t block_bytes;
+    size_t retain_bytes;
+    std::vector<Block> blocks;
+    size_t current = 0;
+    size_t offset = 0;
+};
+
+// Rewinds the arena when the operation ends, the containers allocated in the scope must be gone by then
+class ArenaScope {
+public:
+    explicit ArenaScope(Arena& arena = Arena::local()) : arena(arena), start(arena.mark()) {}
+    ~ArenaScope() { arena.rewind(start); }
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+    Arena *resource() { return &arena; }
+
+private:
+    Arena& arena;
+    Arena::Mark start;
+};
+
+}
+
+#endif // UTILS_ARENA_H
@@ -2,6 +2,43 @@
 
 namespace Utils {
 
+static matf4 look_at(const vecf3& pos, const vecf3& target, const vecf3& up) {
+    assert(abs(up.dot(up) - 1.0f) < 1e-6);
+
+    const vecf3 front = (target - pos).normalized();
+    assert(front != up);
+    vecf3 right = front.cross(up).normalized();
+    const vecf3 cam_up = right.cross(front);
+
+    matf4 m;
+    m <<  right[0],  right[1],  right[2],  -right.dot(pos),
+         cam_up[0], cam_up[1], cam_up[2], -cam_up.dot(pos),
+         -front[0], -front[1], -front[2],   front.dot(pos),
+                 0,         0,         0,                1;
+
+    return m;
+}
+
+static matf4 perspective(float fov_y, float aspect, float z_near, float z_far) {
+    assert(fov_y > 0 && aspect > 0 && z_near >= 0 && z_far > z_near);
+
+    auto tan_half_fov_y = tan(fov_y / 2.0f);
+    auto cot_half_fov_y = 1 / tan_half_fov_y;
+
+    auto m00 = cot_half_fov_y / aspect;
+    auto m11 = cot_half_fov_y;
+    auto m22 = -(z_far + z_near) / (z_far - z_near);
+    auto m23 = -(2 * z_far * z_near) / (z_far - z_near);
+
+    matf4 m;
+    m <<  m00,      0,      0,      0,
+            0,    m11,      0,      0,
+            0,      0,    m22,    m23,
+            0,      0,     -1,      0;
+
+    return m;
+}
+
 Camera::Camera(const vecf3& position, const vecf3& up, float yaw, float pitch)
     : front(vecf3(0.0f, 0.0f, -1.0f)), movement_speed(SPEED), mouse_sensitivity(SENSITIVITY), zoom(ZOOM),
       position(position), world_up(up), yaw(yaw), pitch(pitch) {
@@ -15,52 +52,114 @@ Camera::Camera(float pos_x, float pos_y, float pos_z, float up_x, float up_y, fl
 }
 
 matf4 Camera::get_view_matrix() const {
-    auto look_at = [](const vecf3& pos, const vecf3& target, const vecf3& up) {
-		assert(abs(up.dot(up) - 1.0f) < 1e-6);
+    return view();
+}
+
+matf4 Camera::get_projection_matrix(float width, float height, float near, float far) const {
+    if (width / height == aspect && near == near_plane && far == far_plane) {
+        return projection();
+    }
+    return perspective(to_radian(zoom), width / height, near, far);
+}
 
-		const vecf3 front = (target - pos).normalized();
-		assert(front != up);
-		vecf3 right = front.cross(up).normalized();
-		const vecf3 cam_up = right.cross(front);
+void Camera::set_viewport(float width, float height, float near, float far) {
+    if (width / height != aspect || near != near_plane || far != far_plane) {
+        aspect = width / height;
+        near_plane = near;
+        far_plane = far;
+        projection_dirty = true;
+    }
+}
 
-		matf4 m;
-        m <<  right[0],  right[1],  right[2],  -right.dot(pos),
-             cam_up[0], cam_up[1], cam_up[2], -cam_up.dot(pos),
-             -front[0], -front[1], -front[2],   front.dot(pos),
-                     0,         0,         0,                1;
+const matf4& Camera::view() const {
+    update_view();
+    return view_matrix;
+}
 
-		return m;
-    };
+const matf4& Camera::projection() const {
+    update_projection();
+    return projection_matrix;
+}
 
-    return look_at(position, position + front, world_up);
+const matf4& Camera::view_projection() const {
+    update_derived();
+    return view_projection_matrix;
 }
 
-matf4 Camera::get_projection_matrix(float width, float height, float near, float far) const {
-    auto perspective = [](float fov_y, float aspect, float z_near, float z_far) {
-        assert(fov_y > 0 && aspect > 0 && z_near >= 0 && z_far > z_near);
-
-        auto tan_half_fov_y = tan(fov_y / 2.0f);
-        auto cot_half_fov_y = 1 / tan_half_fov_y;
-
-        auto m00 = cot_half_fov_y / aspect;
-        auto m11 = cot_half_fov_y;
-        auto m22 = -(z_far + z_near) / (z_far - z_near);
-        auto m23 = -(2 * z_far * z_near) / (z_far - z_near);
-
-        matf4 m;
-        m <<  m00,      0,      0,      0,
-                0,    m11,      0,      0,
-                0,      0,    m22,    m23,
-                0,      0,     -1,      0;
-        
-        return m;
-    };
+const matf4& Camera::inverse_view() const {
+    update_view();
+    return inverse_view_matrix;
+}
 
-    return perspective(to_radian(zoom), width / height, near, far);
+const matf4& Camera::inverse_projection() const {
+    update_projection();
+    return inverse_projection_matrix;
+}
+
+const matf4& Camera::inverse_view_projection() const {
+    update_derived();
+    return inverse_view_projection_matrix;
+}
+
+const Frustum& Camera::frustum() const {
+    update_derived();
+    return frustum_planes;
+}
+
+const CameraUniforms& Camera::uniforms() const {
+    update_derived();
+    return uniform_block;
+}
+
+void Camera::update_view() const {
+    if (!view_dirty) {
+        return;
+    }
+    view_matrix = look_at(position, position + front, world_up);
+    // a rotation and a translation: the transposed rotation, and the position
+    inverse_view_matrix = matf4::Identity();
+    inverse_view_matrix.topLeftCorner<3, 3>() = view_matrix.topLeftCorner<3, 3>().transpose();
+    inverse_view_matrix.topRightCorner<3, 1>() = position;
+    view_dirty = false;
+    derived_dirty = true;
+}
+
+void Camera::update_projection() const {
+    if (!projection_dirty) {
+        return;
+    }
+    projection_matrix = perspective(to_radian(zoom), aspect, near_plane, far_plane);
+    // P = [a 0 0 0; 0 b 0 0; 0 0 c d; 0 0 -1 0] has the inverse [1/a 0 0 0; 0 1/b 0 0; 0 0 0 -1; 0 0 1/d c/d]
+    const auto& p = projection_matrix;
+    inverse_projection_matrix = matf4::Zero();
+    inverse_projection_matrix(0, 0) = 1.0f / p(0, 0);
+    inverse_projection_matrix(1, 1) = 1.0f / p(1, 1);
+    inverse_projection_matrix(2, 3) = -1.0f;
+    inverse_projection_matrix(3, 2) = 1.0f / p(2, 3);
+    inverse_projection_matrix(3, 3) = p(2, 2) / p(2, 3);
+    projection_dirty = false;
+    derived_dirty = true;
+}
+
+void Camera::update_derived() const {
+    update_view();
+    update_projection();
+    if (!derived_dirty) {
+        return;
+    }
+    view_projection_matrix = projection_matrix * view_matrix;
+    inverse_view_projection_matrix = inverse_view_matrix * inverse_projection_matrix;
+    frustum_planes = Frustum::from_view_projection(view_projection_matrix);
+    uniform_block.view = view_matrix;
+    uniform_block.projection = projection_matrix;
+    uniform_block.view_projection = view_projection_matrix;
+    uniform_block.position << position, 1.0f;
+    derived_dirty = false;
 }
 
 void Camera::process_keyboard(Movement direction, float delta_time) {
     float velocity = movement_speed * delta_time;
+    view_dirty = true;
     switch (direction) {
     case Movement::FORWARD:
         position += front * velocity;
@@ -107,6 +206,7 @@ void Camera::process_mouse_movement(float xoffset, float yoffset, bool constrain
 }
 
 void Camera::process_mouse_scroll(float yoffset) {
+    projection_dirty = true;
     if (zoom >= 1.0f && zoom <= 45.0f) {
         zoom -= yoffset;
     }
@@ -129,6 +229,40 @@ void Camera::update_camera_vectors() {
     // Also re-calculate the Right and Up vector
     right = front.cross(world_up).normalized(); // Normalize the vectors, because their length gets closer to 0 the more you look up or down which results in slower movement.
     up = right.cross(front).normalized();
+    view_dirty = true;
+}
+
+Frustum Frustum::from_view_projection(const matf4& m) {
+    // a point is inside when -w <= x, y, z <= w in clip space, each bound is a row sum
+    Frustum f;
+    for (int i = 0; i < 3; ++i) {
+        f.planes[2 * i] = (m.row(3) + m.row(i)).transpose();
+        f.planes[2 * i + 1] = (m.row(3) - m.row(i)).transpose();
+    }
+    for (auto& plane : f.planes) {
+        plane /= plane.head<3>().norm();
+    }
+    return f;
+}
+
+bool Frustum::intersects_sphere(const vecf3& center, float radius) const {
+    for (const auto& plane : planes) {
+        if (plane.head<3>().dot(center) + plane[3] < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Frustum::intersects_box(const vecf3& min, const vecf3& max) const {
+    for (const auto& plane : planes) {
+        // the corner farthest along the normal
+        vecf3 p(plane[0] >= 0.0f ? max[0] : min[0], plane[1] >= 0.0f ? max[1] : min[1], plane[2] >= 0.0f ? max[2] : min[2]);
+        if (plane.head<3>().dot(p) + plane[3] < 0.0f) {
+            return false;
+        }
+    }
+    return true;
 }
 
 }
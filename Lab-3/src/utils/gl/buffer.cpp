@@ -43,4 +43,13 @@ void Buffer::sub_data(GLintptr offset, GLsizeiptr size, const void *data) {
     glBufferSubData(target, offset, size, data);
 }
 
+void Buffer::copy_sub_data(GLintptr read_offset, GLintptr write_offset, GLsizeiptr size) {
+    glCopyBufferSubData(target, target, read_offset, write_offset, size);
+}
+
+void Buffer::reallocate(GLsizeiptr size, const void *data) {
+    bind();
+    glBufferData(target, size, data, usage);
+}
+
 }
\ No newline at end of file
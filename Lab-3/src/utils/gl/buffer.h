@@ -25,6 +25,10 @@ public:
     static void bind_reset(BufferType target);
 
     void sub_data(GLintptr offset, GLsizeiptr size, const void *data);
+    // copies a range of the buffer to another place in it on the GPU, the ranges must not overlap
+    void copy_sub_data(GLintptr read_offset, GLintptr write_offset, GLsizeiptr size);
+    // new storage for the same buffer object, so vertex arrays referencing it stay valid
+    void reallocate(GLsizeiptr size, const void *data = nullptr);
 
 protected:
     BufferType target;
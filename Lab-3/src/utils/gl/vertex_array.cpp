@@ -90,4 +90,12 @@ void VertexArray::draw(const Shader& shader) const {
     bind_reset();
 }
 
+void VertexArray::draw(const Shader& shader, GLsizei count, GLuint first, GLint base_vertex) const {
+    assert(is_valid());
+    shader.use_program();
+    bind();
+    glDrawElementsBaseVertex(eb->primitive, count, GL_UNSIGNED_INT, reinterpret_cast<const void *>(first * sizeof(GLuint)), base_vertex);
+    bind_reset();
+}
+
 }
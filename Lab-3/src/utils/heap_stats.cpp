@@ -0,0 +1,72 @@
+#include "heap_stats.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+static std::atomic<uint64_t> allocation_count(0);
+static thread_local uint64_t thread_allocation_count = 0;
+
+static void count_allocation() {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    thread_allocation_count++;
+}
+
+namespace Utils {
+
+uint64_t heap_allocation_count() {
+    return allocation_count.load(std::memory_order_relaxed);
+}
+
+uint64_t thread_heap_allocation_count() {
+    return thread_allocation_count;
+}
+
+}
+
+// the array and nothrow forms go through these
+void *operator new(size_t size) {
+    count_allocation();
+    if (void *p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new(size_t size, std::align_val_t alignment) {
+    count_allocation();
+    auto align = static_cast<size_t>(alignment);
+#ifdef _WIN32
+    void *p = _aligned_malloc(size == 0 ? 1 : size, align);
+#else
+    // aligned_alloc wants a multiple of the alignment
+    void *p = std::aligned_alloc(align, ((size == 0 ? 1 : size) + align - 1) / align * align);
+#endif
+    if (p) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void operator delete(void *p, size_t, std::align_val_t alignment) noexcept {
+    operator delete(p, alignment);
+}
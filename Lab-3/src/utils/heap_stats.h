@@ -0,0 +1,18 @@
+#ifndef UTILS_HEAP_STATS_H
+#define UTILS_HEAP_STATS_H
+
+#pragma once
+
+#include <cstdint>
+
+// Counts every operator new of the process, the global operator new and delete are replaced for it.
+// Memory taken with malloc directly (ImGui's) isn't seen.
+namespace Utils {
+
+uint64_t heap_allocation_count();
+// only the calling thread's, for the workers of the batch tool
+uint64_t thread_heap_allocation_count();
+
+}
+
+#endif // UTILS_HEAP_STATS_H
@@ -0,0 +1,181 @@
+#include "lod_chain.h"
+
+namespace Utils {
+
+static constexpr size_t VERTEX_BYTES = 2 * sizeof(vecf3); // position + normal
+static constexpr int MIN_COPY_RUN = 16; // vertices
+
+LodChain::LodChain(MeshData&& mesh) {
+    // room for a few coarser levels before the first regrow
+    vertex_capacity = std::max<size_t>(mesh.vertex_count() * 2, 1);
+    index_capacity = std::max<size_t>(mesh.face_count() * 3 * 2, 3);
+    vb_pos = std::make_unique<VertexBuffer>(static_cast<GLsizeiptr>(vertex_capacity * sizeof(vecf3)), nullptr);
+    vb_norm = std::make_unique<VertexBuffer>(static_cast<GLsizeiptr>(vertex_capacity * sizeof(vecf3)), nullptr);
+    eb = std::make_unique<ElementBuffer>(GL_TRIANGLES, index_capacity / 3, nullptr);
+
+    VertexArray::Format format;
+    format.attr_ptrs.emplace_back(vb_pos->attr_ptr(3, GL_FLOAT, GL_FALSE, sizeof(vecf3)));
+    format.attr_ptrs.emplace_back(vb_norm->attr_ptr(3, GL_FLOAT, GL_FALSE, sizeof(vecf3)));
+    format.eb = eb.get();
+    va = std::make_unique<VertexArray>(std::vector<GLuint>{0, 1}, format);
+
+    append(std::move(mesh));
+}
+
+size_t LodChain::append(MeshData&& mesh) {
+    // the one full pass of the level, later levels simplified from it only update the sums
+    sums.reset(mesh.positions, mesh.indices);
+    if (mesh.normals.size() != mesh.positions.size()) {
+        mesh.normals = sums.normals();
+    }
+
+    if (push_level(std::move(mesh))) {
+        upload(levels.size() - 1);
+    }
+    return levels.size() - 1;
+}
+
+size_t LodChain::append(MeshData&& mesh, const std::vector<int>& previous_ids) {
+    if (push_level(std::move(mesh))) {
+        upload_changes(levels.size() - 1, previous_ids);
+    }
+    return levels.size() - 1;
+}
+
+// false when the buffers had to grow, which uploads every level again
+bool LodChain::push_level(MeshData&& mesh) {
+    Level level;
+    level.base_vertex = static_cast<GLint>(vertex_num);
+    level.first_index = static_cast<GLuint>(index_num);
+    level.index_count = static_cast<GLsizei>(mesh.face_count() * 3);
+    vertex_num += mesh.vertex_count();
+    index_num += mesh.face_count() * 3;
+
+    levels.push_back(level);
+    meshes.push_back(std::move(mesh));
+
+    if (vertex_num > vertex_capacity || index_num > index_capacity) {
+        reserve(std::max(vertex_num, vertex_capacity * 2), std::max(index_num, index_capacity * 2));
+        return false;
+    }
+    return true;
+}
+
+void LodChain::reserve(size_t vertex_cap, size_t index_cap) {
+    vertex_capacity = vertex_cap;
+    index_capacity = index_cap;
+    vb_pos->reallocate(static_cast<GLsizeiptr>(vertex_capacity * sizeof(vecf3)));
+    vb_norm->reallocate(static_cast<GLsizeiptr>(vertex_capacity * sizeof(vecf3)));
+    VertexBuffer::bind_reset();
+    VertexArray::bind_reset();
+    eb->reallocate(static_cast<GLsizeiptr>(index_capacity * sizeof(GLuint)));
+    eb->num_points = static_cast<GLuint>(index_capacity);
+    ElementBuffer::bind_reset();
+
+    for (size_t i = 0; i < levels.size(); ++i) {
+        upload(i);
+    }
+}
+
+void LodChain::upload(size_t idx) {
+    const auto& level = levels[idx];
+    const auto& mesh = meshes[idx];
+
+    auto vertex_offset = static_cast<GLintptr>(level.base_vertex * sizeof(vecf3));
+    auto vertex_size = static_cast<GLsizeiptr>(mesh.vertex_count() * sizeof(vecf3));
+    vb_pos->bind();
+    vb_pos->sub_data(vertex_offset, vertex_size, mesh.positions.data());
+    vb_norm->bind();
+    vb_norm->sub_data(vertex_offset, vertex_size, mesh.normals.data());
+    VertexBuffer::bind_reset();
+
+    upload_indices(idx);
+}
+
+void LodChain::upload_changes(size_t idx, const std::vector<int>& previous_ids) {
+    const auto& level = levels[idx];
+    const auto& previous = levels[idx - 1];
+    const auto& mesh = meshes[idx];
+    auto vertex_count = static_cast<int>(mesh.vertex_count());
+
+    // A vertex the collapses didn't touch kept both its position and its normal, so a run of them
+    // that were also neighbours in the last level is copied from its range on the GPU. Everything
+    // between those runs is written with one ranged update. Short runs aren't worth a call of their
+    // own and are written along with the dirty vertices around them.
+    struct Run {
+        int begin, end;
+        bool copy;
+    };
+    std::vector<Run> runs;
+    int pending = 0;
+    int begin = 0;
+    while (begin < vertex_count) {
+        int end = begin + 1;
+        if (!sums.is_dirty(begin)) {
+            while (end < vertex_count && !sums.is_dirty(end) && previous_ids[end] == previous_ids[end - 1] + 1) {
+                end++;
+            }
+            if (end - begin >= MIN_COPY_RUN) {
+                if (pending < begin) {
+                    runs.push_back({pending, begin, false});
+                }
+                runs.push_back({begin, end, true});
+                pending = end;
+            }
+        }
+        begin = end;
+    }
+    if (pending < vertex_count) {
+        runs.push_back({pending, vertex_count, false});
+    }
+
+    auto write_runs = [&](VertexBuffer& vb, const std::vector<vecf3>& data) {
+        vb.bind();
+        for (const auto& run : runs) {
+            auto offset = static_cast<GLintptr>((level.base_vertex + run.begin) * sizeof(vecf3));
+            auto size = static_cast<GLsizeiptr>((run.end - run.begin) * sizeof(vecf3));
+            if (run.copy) {
+                auto read_offset = static_cast<GLintptr>((previous.base_vertex + previous_ids[run.begin]) * sizeof(vecf3));
+                vb.copy_sub_data(read_offset, offset, size);
+            } else {
+                vb.sub_data(offset, size, data.data() + run.begin);
+            }
+        }
+    };
+    write_runs(*vb_pos, mesh.positions);
+    write_runs(*vb_norm, mesh.normals);
+    VertexBuffer::bind_reset();
+
+    upload_indices(idx);
+}
+
+void LodChain::upload_indices(size_t idx) {
+    const auto& level = levels[idx];
+    const auto& mesh = meshes[idx];
+
+    // binding the element buffer outside of a vertex array would change the bound one's state
+    VertexArray::bind_reset();
+    eb->bind();
+    eb->sub_data(static_cast<GLintptr>(level.first_index * sizeof(GLuint)),
+                 static_cast<GLsizeiptr>(level.index_count * sizeof(GLuint)), mesh.indices.data());
+    ElementBuffer::bind_reset();
+}
+
+void LodChain::draw(const Shader& shader, size_t level) const {
+    const auto& l = levels[level];
+    va->draw(shader, l.index_count, l.first_index, l.base_vertex);
+}
+
+size_t LodChain::level_bytes(size_t idx) const {
+    return meshes[idx].vertex_count() * VERTEX_BYTES + meshes[idx].face_count() * sizeof(veci3);
+}
+
+size_t LodChain::used_bytes() const noexcept {
+    return vertex_num * VERTEX_BYTES + index_num * sizeof(GLuint);
+}
+
+size_t LodChain::allocated_bytes() const noexcept {
+    return vertex_capacity * VERTEX_BYTES + index_capacity * sizeof(GLuint);
+}
+
+}
@@ -0,0 +1,86 @@
+#ifndef UTILS_LOD_CHAIN_H
+#define UTILS_LOD_CHAIN_H
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+
+#include "Eigen/Dense"
+#include "glad/glad.h"
+
+#include "utils/tools.h"
+#include "utils/shader.h"
+#include "utils/mesh_data.h"
+#include "utils/normal_accumulator.h"
+#include "utils/gl/vertex_array.h"
+
+namespace Utils {
+
+using GL::VertexArray;
+using GL::VertexBuffer;
+using GL::ElementBuffer;
+
+// All the levels of detail of one mesh in a single position buffer, normal buffer and index buffer.
+// Every level is a (base vertex, first index, index count) range of them behind one vertex array,
+// so switching levels only changes the draw call. The buffers grow geometrically when a level
+// doesn't fit, which is the only time anything is uploaded again.
+class LodChain {
+public:
+    struct Level {
+        GLint base_vertex;
+        GLuint first_index;
+        GLsizei index_count;
+    };
+
+    // level 0, missing normals are generated
+    explicit LodChain(MeshData&& mesh);
+
+    // appends a coarser level and returns its index
+    size_t append(MeshData&& mesh);
+    // appends a level simplified from the last one with accumulator(), previous_ids[v] being the
+    // index vertex v had in the last level. Long runs of vertices the simplification didn't touch
+    // are copied over from the last level's range on the GPU instead of uploaded again.
+    size_t append(MeshData&& mesh, const std::vector<int>& previous_ids);
+
+    // the normal sums of the last level, to simplify it further without summing every face again
+    NormalAccumulator& accumulator() noexcept { return sums; }
+
+    void draw(const Shader& shader, size_t level) const;
+
+    size_t size() const noexcept { return levels.size(); }
+    const Level& level(size_t idx) const { return levels[idx]; }
+    const MeshData& mesh(size_t idx) const { return meshes[idx]; }
+
+    // GPU memory used by one level, and by the whole chain (allocated, including spare capacity)
+    size_t level_bytes(size_t idx) const;
+    size_t used_bytes() const noexcept;
+    size_t allocated_bytes() const noexcept;
+
+private:
+    void reserve(size_t vertex_cap, size_t index_cap);
+    void upload(size_t idx);
+    void upload_changes(size_t idx, const std::vector<int>& previous_ids);
+    void upload_indices(size_t idx);
+    bool push_level(MeshData&& mesh);
+
+    std::unique_ptr<VertexBuffer> vb_pos;
+    std::unique_ptr<VertexBuffer> vb_norm;
+    std::unique_ptr<ElementBuffer> eb;
+    std::unique_ptr<VertexArray> va;
+
+    std::vector<Level> levels;
+    std::vector<MeshData> meshes;
+    NormalAccumulator sums;
+
+    size_t vertex_num = 0;
+    size_t index_num = 0;
+    size_t vertex_capacity = 0;
+    size_t index_capacity = 0;
+};
+
+}
+
+#endif // UTILS_LOD_CHAIN_H
@@ -0,0 +1,28 @@
+#ifndef UTILS_MESH_DATA_H
+#define UTILS_MESH_DATA_H
+
+#pragma once
+
+#include <vector>
+
+#include "Eigen/Dense"
+
+#include "utils/tools.h"
+
+namespace Utils {
+
+// CPU side of a triangle mesh, no GL objects are involved so it can be built,
+// simplified and moved around on any thread. Model::load uploads it.
+struct MeshData {
+    std::vector<vecf3> positions;
+    std::vector<vecf3> normals; // may be empty, generated on upload
+    std::vector<veci3> indices;
+
+    size_t vertex_count() const noexcept { return positions.size(); }
+    size_t face_count() const noexcept { return indices.size(); }
+    bool empty() const noexcept { return indices.empty(); }
+};
+
+}
+
+#endif // UTILS_MESH_DATA_H
@@ -0,0 +1,255 @@
+#include "mesh_io.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <memory_resource>
+
+#include "utils/arena.h"
+
+namespace Utils {
+
+static bool read_file(const std::string& path, std::pmr::string& buffer) {
+    std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        std::cerr << "[E] Failed to open file: " << path << std::endl;
+        return false;
+    }
+    auto size = static_cast<size_t>(file.tellg());
+    file.seekg(0, std::ios::beg);
+    buffer.resize(size);
+    file.read(buffer.data(), static_cast<std::streamsize>(size));
+    return static_cast<bool>(file);
+}
+
+static const char *parse_floats(const char *cur, const char *line_end, float *out, int n) {
+    for (int i = 0; i < n; ++i) {
+        char *next = nullptr;
+        out[i] = std::strtof(cur, &next);
+        if (next == cur || next > line_end) {
+            return nullptr;
+        }
+        cur = next;
+    }
+    return cur;
+}
+
+// Every face must name loaded vertices, the simplifier and the draws index with them unchecked
+static bool check_indices(const std::string& path, const MeshData& mesh) {
+    auto vertex_cnt = mesh.positions.size();
+    for (const auto& idx : mesh.indices) {
+        for (int k = 0; k < 3; ++k) {
+            if (idx[k] < 0 || static_cast<size_t>(idx[k]) >= vertex_cnt) {
+                std::cerr << "[E] Face index out of range in file: " << path << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool load_obj(const std::string& path, MeshData& mesh) {
+    // the file and the polygon scratch only live for the parse
+    ArenaScope scope;
+    std::pmr::string buffer(scope.resource());
+    if (!read_file(path, buffer)) {
+        return false;
+    }
+
+    auto& positions = mesh.positions;
+    auto& normals = mesh.normals;
+    auto& indices = mesh.indices;
+    positions.clear();
+    normals.clear();
+    indices.clear();
+
+    std::pmr::vector<int> polygon(scope.resource());
+    const char *cur = buffer.c_str();
+    const char *end = cur + buffer.size();
+    while (cur < end) {
+        auto line_end = static_cast<const char *>(std::memchr(cur, '\n', end - cur));
+        if (line_end == nullptr) {
+            line_end = end;
+        }
+        while (cur < line_end && (*cur == ' ' || *cur == '\t')) {
+            cur++;
+        }
+
+        if (line_end - cur > 2 && cur[0] == 'v' && cur[1] == ' ') {
+            vecf3 pos;
+            if (parse_floats(cur + 2, line_end, pos.data(), 3)) {
+                positions.emplace_back(pos);
+            }
+        } else if (line_end - cur > 3 && cur[0] == 'v' && cur[1] == 'n' && cur[2] == ' ') {
+            vecf3 normal;
+            if (parse_floats(cur + 3, line_end, normal.data(), 3)) {
+                normals.emplace_back(normal);
+            }
+        } else if (line_end - cur > 2 && cur[0] == 'f' && cur[1] == ' ') {
+            // "f v", "f v/vt", "f v//vn" and "f v/vt/vn" only differ after the first slash
+            polygon.clear();
+            cur += 2;
+            while (cur < line_end) {
+                char *next = nullptr;
+                long idx = std::strtol(cur, &next, 10);
+                if (next == cur || next > line_end) {
+                    break;
+                }
+                long vertex = idx < 0 ? static_cast<long>(positions.size()) + idx : idx - 1;
+                // 0 and indices past int become -1 instead of wrapping, check_indices rejects them
+                polygon.push_back(vertex < 0 || vertex > INT_MAX ? -1 : static_cast<int>(vertex));
+                cur = next;
+                while (cur < line_end && *cur != ' ' && *cur != '\t') {
+                    cur++;
+                }
+            }
+            for (size_t i = 2; i < polygon.size(); ++i) {
+                indices.emplace_back(polygon[0], polygon[i - 1], polygon[i]);
+            }
+        }
+
+        cur = line_end + 1;
+    }
+
+    if (!normals.empty() && normals.size() != positions.size()) {
+        normals.clear();
+    }
+    return check_indices(path, mesh);
+}
+
+bool save_obj(const std::string& path, const MeshData& mesh) {
+    const auto& positions = mesh.positions;
+    const auto& normals = mesh.normals;
+    const auto& indices = mesh.indices;
+    std::FILE *file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        std::cerr << "[E] Failed to open file: " << path << std::endl;
+        return false;
+    }
+
+    bool has_normals = !normals.empty() && normals.size() == positions.size();
+    std::fprintf(file, "# vertices: %zu\n# faces: %zu\n", positions.size(), indices.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+        const auto& p = positions[i];
+        std::fprintf(file, "v %.6g %.6g %.6g\n", p[0], p[1], p[2]);
+        if (has_normals) {
+            const auto& n = normals[i];
+            std::fprintf(file, "vn %.6g %.6g %.6g\n", n[0], n[1], n[2]);
+        }
+    }
+    for (const auto& f : indices) {
+        if (has_normals) {
+            std::fprintf(file, "f %d//%d %d//%d %d//%d\n", f[0] + 1, f[0] + 1, f[1] + 1, f[1] + 1, f[2] + 1, f[2] + 1);
+        } else {
+            std::fprintf(file, "f %d %d %d\n", f[0] + 1, f[1] + 1, f[2] + 1);
+        }
+    }
+
+    bool ok = std::ferror(file) == 0;
+    std::fclose(file);
+    return ok;
+}
+
+bool load_mesh(const std::string& path, MeshData& mesh) {
+    ArenaScope scope;
+    std::pmr::string buffer(scope.resource());
+    if (!read_file(path, buffer)) {
+        return false;
+    }
+
+    uint32_t header[5];
+    if (buffer.size() < sizeof(header) || std::memcmp(buffer.data(), "MESH", 4) != 0) {
+        std::cerr << "[E] Not a mesh file: " << path << std::endl;
+        return false;
+    }
+    std::memcpy(header, buffer.data(), sizeof(header));
+    auto version = header[1];
+    auto vertex_cnt = static_cast<size_t>(header[2]);
+    auto face_cnt = static_cast<size_t>(header[3]);
+    bool has_normals = header[4] != 0;
+    auto expected = sizeof(header) + vertex_cnt * sizeof(vecf3) * (has_normals ? 2 : 1) + face_cnt * sizeof(veci3);
+    if (version != MESH_FILE_VERSION || buffer.size() < expected) {
+        std::cerr << "[E] Corrupted mesh file: " << path << std::endl;
+        return false;
+    }
+
+    auto& positions = mesh.positions;
+    auto& normals = mesh.normals;
+    auto& indices = mesh.indices;
+    const char *cur = buffer.data() + sizeof(header);
+    positions.resize(vertex_cnt);
+    std::memcpy(static_cast<void *>(positions.data()), cur, vertex_cnt * sizeof(vecf3));
+    cur += vertex_cnt * sizeof(vecf3);
+    normals.resize(has_normals ? vertex_cnt : 0);
+    if (has_normals) {
+        std::memcpy(static_cast<void *>(normals.data()), cur, vertex_cnt * sizeof(vecf3));
+        cur += vertex_cnt * sizeof(vecf3);
+    }
+    indices.resize(face_cnt);
+    std::memcpy(static_cast<void *>(indices.data()), cur, face_cnt * sizeof(veci3));
+
+    return check_indices(path, mesh);
+}
+
+bool save_mesh(const std::string& path, const MeshData& mesh) {
+    const auto& positions = mesh.positions;
+    const auto& normals = mesh.normals;
+    const auto& indices = mesh.indices;
+    std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "[E] Failed to open file: " << path << std::endl;
+        return false;
+    }
+
+    bool has_normals = !normals.empty() && normals.size() == positions.size();
+    uint32_t header[5] = {
+        0,
+        MESH_FILE_VERSION,
+        static_cast<uint32_t>(positions.size()),
+        static_cast<uint32_t>(indices.size()),
+        has_normals ? 1u : 0u,
+    };
+    std::memcpy(header, "MESH", 4);
+
+    file.write(reinterpret_cast<const char *>(header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(positions.data()), static_cast<std::streamsize>(positions.size() * sizeof(vecf3)));
+    if (has_normals) {
+        file.write(reinterpret_cast<const char *>(normals.data()), static_cast<std::streamsize>(normals.size() * sizeof(vecf3)));
+    }
+    file.write(reinterpret_cast<const char *>(indices.data()), static_cast<std::streamsize>(indices.size() * sizeof(veci3)));
+
+    return static_cast<bool>(file);
+}
+
+bool load_mesh_file(const std::string& path, MeshData& mesh) {
+    bool is_binary = path.size() >= 5 && path.compare(path.size() - 5, 5, ".mesh") == 0;
+    return is_binary ? load_mesh(path, mesh) : load_obj(path, mesh);
+}
+
+void normalize_mesh(MeshData& mesh) {
+    auto& positions = mesh.positions;
+    if (positions.empty()) {
+        return;
+    }
+
+    // I don't implement the bounding box for this
+    vecf3 center = vecf3::Zero();
+    float scale = 0.0f;
+    for (const auto& pos : positions) {
+        center += pos;
+    }
+    center /= static_cast<float>(positions.size());
+    for (const auto& pos : positions) {
+        scale = std::max(scale, (pos - center).norm());
+    }
+    scale = 1.0f / scale;
+    for (auto& pos : positions) {
+        pos = (pos - center) * scale;
+    }
+}
+
+}
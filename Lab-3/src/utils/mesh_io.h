@@ -0,0 +1,39 @@
+#ifndef UTILS_MESH_IO_H
+#define UTILS_MESH_IO_H
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "Eigen/Dense"
+
+#include "utils/tools.h"
+#include "utils/mesh_data.h"
+
+// Reading and writing meshes without any GL dependency, shared by the viewer and the batch tool
+namespace Utils {
+
+// Parses positions, per-vertex normals and faces (polygons are fan-triangulated) of an OBJ file.
+// Normals are dropped if they don't match the positions one to one.
+bool load_obj(const std::string& path, MeshData& mesh);
+bool save_obj(const std::string& path, const MeshData& mesh);
+
+// Binary mesh layout (little endian):
+//   char[4] "MESH", uint32 version, uint32 vertex count, uint32 face count, uint32 has normals,
+//   float positions[3 * vertex count], float normals[3 * vertex count] (optional), int32 indices[3 * face count]
+static constexpr uint32_t MESH_FILE_VERSION = 1;
+
+bool load_mesh(const std::string& path, MeshData& mesh);
+bool save_mesh(const std::string& path, const MeshData& mesh);
+
+// Centers the mesh at its vertex average and scales it into the unit sphere
+void normalize_mesh(MeshData& mesh);
+
+// Picks the reader from the extension, ".mesh" is binary and anything else is parsed as OBJ
+bool load_mesh_file(const std::string& path, MeshData& mesh);
+
+}
+
+#endif // UTILS_MESH_IO_H
@@ -7,6 +7,7 @@
 #include <string>
 #include <map>
 #include <memory>
+#include <algorithm>
 #include <utility>
 #include <iostream>
 #include <fstream>
@@ -15,6 +16,8 @@
 #include "Eigen/Dense"
 
 #include "utils/tools.h"
+#include "utils/mesh_data.h"
+#include "utils/mesh_io.h"
 #include "utils/gl/vertex_array.h"
 
 namespace Utils {
@@ -23,21 +26,24 @@ using GL::VertexArray;
 using GL::VertexBuffer;
 using GL::ElementBuffer;
 
+// GPU side of a mesh. The CPU data lives in MeshData and is only uploaded by load,
+// so the meshes can be prepared (e.g. simplified) without a GL context and uploaded later.
 struct Model {
+    Model() = default;
+    Model(Model&& other) noexcept = default;
+    Model& operator=(Model&& other) noexcept = default;
     ~Model();
 
     std::unique_ptr<VertexArray> va = nullptr;
     std::unique_ptr<ElementBuffer> eb = nullptr;
 
     std::map<std::string, std::unique_ptr<VertexBuffer>> vbos;
-    std::vector<vecf3> positions;
-    std::vector<vecf3> normals;
-    std::vector<veci3> indices;
+    MeshData mesh;
     
+    // read the file and upload it, centered and scaled into the unit sphere
     static Model *load(const std::string& path);
-    // from mesh
-    static Model *load(std::vector<vecf3>&& positions, std::vector<veci3>&& indices);
-    static Model *load(const std::vector<vecf3>& positions, const std::vector<veci3>& indices);
+    // upload an already built mesh, needs a current GL context. Missing normals are generated.
+    static Model *load(MeshData&& mesh);
 };
 
 } 
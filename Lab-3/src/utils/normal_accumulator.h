@@ -0,0 +1,51 @@
+#ifndef UTILS_NORMAL_ACCUMULATOR_H
+#define UTILS_NORMAL_ACCUMULATOR_H
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+#include "Eigen/Dense"
+
+#include "utils/tools.h"
+
+namespace Utils {
+
+// Keeps the area-weighted face normal sums of every vertex, so that local edits
+// (edge collapses, vertex splits) only touch the vertices of the affected faces
+// instead of running generate_normals over the whole mesh again.
+class NormalAccumulator {
+public:
+    NormalAccumulator() = default;
+    NormalAccumulator(const std::vector<vecf3>& positions, const std::vector<veci3>& indices);
+
+    // Rebuilds all the sums from scratch, the dirty set is cleared
+    void reset(const std::vector<vecf3>& positions, const std::vector<veci3>& indices);
+
+    // The positions must be the same ones the face was added with when it is removed
+    void add_face(const std::vector<vecf3>& positions, const veci3& face);
+    void remove_face(const std::vector<vecf3>& positions, const veci3& face);
+
+    vecf3 normal(int vertex) const;
+    std::vector<vecf3> normals() const;
+
+    // Whether the sum of the vertex changed since the last clear_dirty()
+    bool is_dirty(int vertex) const { return dirty_flags[vertex] != 0; }
+    void clear_dirty();
+
+    // Follows a compaction of the vertices: vertex i of the compacted mesh was previous_ids[i],
+    // which must be increasing. The sums and dirty marks of the dropped vertices are discarded.
+    void compact(const std::vector<int>& previous_ids);
+
+private:
+    void accumulate(const std::vector<vecf3>& positions, const veci3& face, float sign);
+
+    std::vector<vecf3> sums;
+    std::vector<uint8_t> dirty_flags;
+};
+
+}
+
+#endif // UTILS_NORMAL_ACCUMULATOR_H
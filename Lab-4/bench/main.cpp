@@ -0,0 +1,538 @@
+#include <iostream>
+#include <iomanip>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <cstdio>
+#include <filesystem>
+
+#include "Eigen/Dense"
+#include "Eigen/Geometry"
+
+#include "utils/tools.h"
+#include "utils/affine.h"
+#include "utils/transform.h"
+#include "utils/scene_graph.h"
+#include "utils/camera.h"
+#include "utils/thread_pool.h"
+#include "utils/instance_table.h"
+#include "utils/mesh_io.h"
+#include "utils/mesh_simplification.h"
+#include "utils/procedural.h"
+#include "utils/stress_scene.h"
+
+// Matrices per second of the batched transforms in Utils::Transform against the scalar Eigen path
+// that the viewer used per instance, and the largest difference between the two; then the world
+// transforms a scene graph recomputes per frame, the updates and queries of an instance table
+// against linear scans, and the synthetic meshes through the OBJ loader and the simplifier.
+// No window is needed.
+//   lighting-bench [-n <instances>]
+
+using Clock = std::chrono::steady_clock;
+using Utils::Affine;
+using Utils::SceneGraph;
+using Utils::Camera;
+using Utils::Frustum;
+using Utils::ThreadPool;
+using Utils::InstanceTable;
+using Utils::MeshData;
+using Utils::StressScene;
+using Utils::Transform::Vec3Array;
+using Utils::Transform::AxisAngleArray;
+using Utils::Transform::QuatArray;
+
+static constexpr size_t ITEMS_PER_RUN = 1 << 23;
+static constexpr float TOLERANCE = 1e-4f;
+
+// random instances in structure of arrays layout, from a fixed seed so runs are comparable
+struct Instances {
+    std::vector<float> px, py, pz;
+    std::vector<float> sx, sy, sz;
+    std::vector<float> ax, ay, az, angle;
+    std::vector<float> qx, qy, qz, qw;
+
+    Vec3Array pos() const { return {px.data(), py.data(), pz.data()}; }
+    Vec3Array scale() const { return {sx.data(), sy.data(), sz.data()}; }
+    AxisAngleArray axis_angle() const { return {ax.data(), ay.data(), az.data(), angle.data()}; }
+    QuatArray quat() const { return {qx.data(), qy.data(), qz.data(), qw.data()}; }
+};
+
+static Instances make_instances(size_t n, uint32_t seed) {
+    auto uniform = [&](float lo, float hi) {
+        seed = seed * 1664525u + 1013904223u;
+        return lo + (hi - lo) * static_cast<float>(seed >> 8) / static_cast<float>(1 << 24);
+    };
+    Instances in;
+    for (size_t i = 0; i < n; ++i) {
+        in.px.push_back(uniform(-50.0f, 50.0f));
+        in.py.push_back(uniform(-50.0f, 50.0f));
+        in.pz.push_back(uniform(-50.0f, 50.0f));
+        in.sx.push_back(uniform(0.5f, 2.0f));
+        in.sy.push_back(uniform(0.5f, 2.0f));
+        in.sz.push_back(uniform(0.5f, 2.0f));
+        vecf3 axis = vecf3(uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f) + 2.0f).normalized();
+        // animated angles grow without bound, the range reduction has to hold up
+        float angle = uniform(-100.0f, 100.0f);
+        in.ax.push_back(axis.x());
+        in.ay.push_back(axis.y());
+        in.az.push_back(axis.z());
+        in.angle.push_back(angle);
+        Eigen::Quaternionf q(Eigen::AngleAxisf(angle, axis));
+        in.qx.push_back(q.x());
+        in.qy.push_back(q.y());
+        in.qz.push_back(q.z());
+        in.qw.push_back(q.w());
+    }
+    return in;
+}
+
+// returns items per second
+template<typename RUN>
+static double measure(size_t items, RUN&& run) {
+    size_t passes = ITEMS_PER_RUN / items + 1;
+    run(); // warm up
+    auto start = Clock::now();
+    for (size_t p = 0; p < passes; ++p) {
+        run();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return static_cast<double>(passes * items) / seconds;
+}
+
+static float max_difference(const std::vector<Affine>& a, const std::vector<matf4>& b) {
+    float diff = 0.0f;
+    for (size_t i = 0; i < a.size(); ++i) {
+        diff = std::max(diff, (a[i].matrix() - b[i]).cwiseAbs().maxCoeff());
+    }
+    return diff;
+}
+
+static float max_difference(const std::vector<Affine>& a, const std::vector<matf3>& b) {
+    float diff = 0.0f;
+    for (size_t i = 0; i < a.size(); ++i) {
+        diff = std::max(diff, (a[i].linear() - b[i]).cwiseAbs().maxCoeff());
+    }
+    return diff;
+}
+
+// A tree of depth levels below one root, every node with branching children, added a level at a
+// time so the first update has to sort it depth first. Returns the nodes per depth.
+static std::vector<std::vector<SceneGraph::Node>> build_hierarchy(SceneGraph& graph, int depth, int branching) {
+    std::vector<std::vector<SceneGraph::Node>> levels(1, {graph.add()});
+    for (int d = 1; d <= depth; ++d) {
+        levels.emplace_back();
+        for (auto parent : levels[d - 1]) {
+            for (int c = 0; c < branching; ++c) {
+                float angle = 0.3f * static_cast<float>(c);
+                levels[d].push_back(graph.add(parent, vecf3(std::cos(angle), 0.5f, std::sin(angle)),
+                                              Eigen::Quaternionf(Eigen::AngleAxisf(angle, vecf3::UnitY())),
+                                              vecf3::Constant(0.9f)));
+            }
+        }
+    }
+    return levels;
+}
+
+// the world transform from the chain of parents, without the cache
+static matf4 world_of(const SceneGraph& graph, SceneGraph::Node node) {
+    matf4 world = matf4::Identity();
+    for (; node != SceneGraph::NONE; node = graph.parent(node)) {
+        matf4 local = matf4::Identity();
+        local.topLeftCorner<3, 3>() = graph.rotation(node).toRotationMatrix() * graph.scale(node).asDiagonal();
+        local.topRightCorner<3, 1>() = graph.position(node);
+        world = local * world;
+    }
+    return world;
+}
+
+static bool bench_scene_graph() {
+    SceneGraph graph;
+    auto levels = build_hierarchy(graph, 5, 10);
+    graph.update();
+    std::cout << "[I] scene graph of " << graph.size() << " nodes, 5 levels of 10 children" << std::endl;
+    std::cout << std::setw(28) << std::left << "changed per frame" << std::right << std::setw(12) << "updates"
+              << std::setw(12) << "us/frame" << std::endl;
+
+    auto frame = [&](const char *name, auto&& change) {
+        constexpr size_t FRAMES = 100;
+        size_t updates = 0;
+        auto start = Clock::now();
+        for (size_t f = 0; f < FRAMES; ++f) {
+            change(static_cast<float>(f));
+            updates += graph.update();
+        }
+        double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / FRAMES;
+        std::cout << std::setw(28) << std::left << name << std::right << std::setw(12) << updates / FRAMES
+                  << std::setw(12) << std::fixed << std::setprecision(1) << us << std::endl;
+    };
+    auto spin = [&](SceneGraph::Node node, float t) {
+        graph.set_rotation(node, Eigen::Quaternionf(Eigen::AngleAxisf(0.01f * t, vecf3::UnitY())));
+    };
+    frame("nothing", [](float) {});
+    frame("1% of the leaves", [&](float t) {
+        for (size_t i = 0; i < levels[5].size(); i += 100) {
+            spin(levels[5][i], t);
+        }
+    });
+    frame("one node of level 1", [&](float t) { spin(levels[1][3], t); });
+    frame("the root", [&](float t) { spin(levels[0][0], t); });
+
+    // the caches against the chains, for nodes of every level
+    float diff = 0.0f;
+    for (const auto& level : levels) {
+        for (size_t i = 0; i < level.size(); i += 997) {
+            diff = std::max(diff, (graph.world(level[i]).matrix() - world_of(graph, level[i])).cwiseAbs().maxCoeff());
+        }
+    }
+    std::cout << "[I] scene graph max diff " << std::scientific << std::setprecision(1) << diff << std::endl;
+    return diff < TOLERANCE;
+}
+
+// every instance moves, then a few, then the queries against scans over all the spheres
+static bool bench_instances(const Instances& in, size_t n) {
+    ThreadPool pool;
+    InstanceTable table;
+    auto model = table.add_model(vecf3(0.0f, 0.1f, 0.0f), 1.0f);
+    for (size_t i = 0; i < n; ++i) {
+        table.add(model, vecf3(in.px[i], in.py[i], in.pz[i]),
+                  Eigen::Quaternionf(in.qw[i], in.qx[i], in.qy[i], in.qz[i]), in.sx[i]);
+    }
+    auto start = Clock::now();
+    table.update(pool);
+    double build_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    std::cout << "[I] instance table of " << n << " on " << pool.size() << " threads, "
+              << table.index().node_count() << " nodes built in " << std::fixed << std::setprecision(2)
+              << build_ms << " ms" << std::endl;
+    std::cout << std::setw(28) << std::left << "moved per frame" << std::right << std::setw(12) << "updates"
+              << std::setw(12) << "rebuilds" << std::setw(12) << "ms/frame" << std::endl;
+
+    auto frame = [&](const char *name, auto&& move) {
+        constexpr size_t FRAMES = 20;
+        size_t updates = 0, rebuilds = 0;
+        auto start = Clock::now();
+        for (size_t f = 0; f < FRAMES; ++f) {
+            move(static_cast<float>(f));
+            updates += table.update(pool);
+            rebuilds += table.last_rebuilt() ? 1 : 0;
+        }
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / FRAMES;
+        std::cout << std::setw(28) << std::left << name << std::right << std::setw(12) << updates / FRAMES
+                  << std::setw(12) << rebuilds << std::setw(12) << std::fixed << std::setprecision(2) << ms << std::endl;
+    };
+    frame("nothing", [](float) {});
+    frame("1%", [&](float t) {
+        for (size_t i = 0; i < n; i += 100) {
+            table.set_position(static_cast<uint32_t>(i), vecf3(in.px[i] + 0.1f * t, in.py[i], in.pz[i]));
+        }
+    });
+    frame("all, drifting", [&](float t) {
+        table.run(pool, [&, t](size_t begin, size_t end) {
+            auto x = table.x();
+            for (size_t i = begin; i < end; ++i) {
+                x[i] = in.px[i] + 0.5f * std::sin(0.3f * t + in.angle[i]);
+            }
+        });
+    });
+
+    // a camera in the middle of the cloud looking down -z
+    Camera camera(vecf3(0.0f, 0.0f, 10.0f));
+    camera.set_viewport(800.0f, 600.0f, 0.1f, 100.0f);
+    const auto& frustum = camera.frustum();
+    auto bounds = table.bounds();
+    auto sphere = [&](size_t i) { return vecf3(bounds.x[i], bounds.y[i], bounds.z[i]); };
+
+    std::vector<uint32_t> visible, expected;
+    constexpr size_t QUERIES = 20;
+    start = Clock::now();
+    for (size_t q = 0; q < QUERIES; ++q) {
+        visible.clear();
+        table.cull(frustum, visible);
+    }
+    double cull_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / QUERIES;
+    start = Clock::now();
+    for (size_t q = 0; q < QUERIES; ++q) {
+        expected.clear();
+        for (size_t i = 0; i < n; ++i) {
+            if (frustum.intersects_sphere(sphere(i), bounds.radius[i])) {
+                expected.push_back(static_cast<uint32_t>(i));
+            }
+        }
+    }
+    double scan_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / QUERIES;
+    std::sort(visible.begin(), visible.end());
+    // a box entirely inside adds its items untested, the frustum test of a sphere is conservative too
+    bool ok = std::includes(visible.begin(), visible.end(), expected.begin(), expected.end());
+    std::cout << "[I] cull " << visible.size() << " visible (scan " << expected.size() << ") in " << cull_ms
+              << " ms, scan " << scan_ms << " ms" << std::endl;
+
+    uint32_t seed = 777;
+    auto uniform = [&](float lo, float hi) {
+        seed = seed * 1664525u + 1013904223u;
+        return lo + (hi - lo) * static_cast<float>(seed >> 8) / static_cast<float>(1 << 24);
+    };
+    constexpr size_t RAYS = 1000;
+    std::vector<vecf3> origins, directions;
+    for (size_t r = 0; r < RAYS; ++r) {
+        origins.emplace_back(uniform(-60.0f, 60.0f), uniform(-60.0f, 60.0f), 70.0f);
+        directions.push_back(vecf3(uniform(-0.5f, 0.5f), uniform(-0.5f, 0.5f), -1.0f).normalized());
+    }
+    std::vector<uint32_t> picks(RAYS);
+    std::vector<float> distances(RAYS, FLT_MAX);
+    start = Clock::now();
+    for (size_t r = 0; r < RAYS; ++r) {
+        picks[r] = table.pick(origins[r], directions[r], &distances[r]);
+    }
+    double pick_us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / RAYS;
+    size_t hits = 0, mismatches = 0;
+    start = Clock::now();
+    for (size_t r = 0; r < RAYS; ++r) {
+        float best = FLT_MAX;
+        for (size_t i = 0; i < n; ++i) {
+            vecf3 oc = origins[r] - sphere(i);
+            float b = oc.dot(directions[r]);
+            float c = oc.dot(oc) - bounds.radius[i] * bounds.radius[i];
+            float discriminant = b * b - c;
+            if ((c > 0.0f && b > 0.0f) || discriminant < 0.0f) {
+                continue;
+            }
+            best = std::min(best, std::max(-b - std::sqrt(discriminant), 0.0f));
+        }
+        hits += best < FLT_MAX ? 1 : 0;
+        // equal distances may pick either sphere
+        bool same = picks[r] == InstanceTable::NONE ? best == FLT_MAX : std::abs(distances[r] - best) < 1e-3f;
+        mismatches += same ? 0 : 1;
+    }
+    double scan_pick_us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / RAYS;
+    std::cout << "[I] pick " << hits << " of " << RAYS << " rays hit, " << pick_us << " us/ray, scan "
+              << scan_pick_us << " us/ray, " << mismatches << " mismatches" << std::endl;
+    return ok && mismatches == 0;
+}
+
+// generated, written and read back, then simplified to half, at a few sizes
+static bool bench_meshes() {
+    auto path = (std::filesystem::temp_directory_path() / "lighting-bench.obj").string();
+    std::cout << std::setw(10) << std::left << "mesh" << std::right << std::setw(12) << "triangles"
+              << std::setw(12) << "generate ms" << std::setw(12) << "save ms" << std::setw(12) << "load ms"
+              << std::setw(12) << "simplify ms" << std::setw(12) << "error" << std::endl;
+    bool ok = true;
+    for (size_t triangles : {2000, 20000, 200000}) {
+        for (int kind = 0; kind < 2; ++kind) {
+            auto start = Clock::now();
+            auto lap = [&] {
+                auto now = Clock::now();
+                double ms = std::chrono::duration<double, std::milli>(now - start).count();
+                start = now;
+                return ms;
+            };
+            auto mesh = kind == 0 ? Utils::Procedural::sphere(triangles) : Utils::Procedural::terrain(triangles, 1);
+            double generate_ms = lap();
+            ok = ok && Utils::save_obj(path, mesh);
+            double save_ms = lap();
+            MeshData loaded;
+            ok = ok && Utils::load_obj(path, loaded);
+            double load_ms = lap();
+            ok = ok && loaded.positions == mesh.positions && loaded.indices == mesh.indices && loaded.normals.size() == mesh.normals.size();
+            float error = 0.0f;
+            auto simplified = Utils::simplify_mesh(std::move(loaded), 0.5f, &error);
+            double simplify_ms = lap();
+            std::cout << std::setw(10) << std::left << (kind == 0 ? "sphere" : "terrain") << std::right
+                      << std::setw(12) << mesh.face_count() << std::fixed << std::setprecision(2)
+                      << std::setw(12) << generate_ms << std::setw(12) << save_ms << std::setw(12) << load_ms
+                      << std::setw(12) << simplify_ms << std::setw(12) << std::scientific << std::setprecision(1)
+                      << error << std::endl;
+        }
+    }
+    std::remove(path.c_str());
+    return ok;
+}
+
+// the same options twice give the same scene, and the same frame at the same time
+static bool bench_stress_scene(size_t n) {
+    ThreadPool pool;
+    StressScene::Options options;
+    options.instances = n;
+    options.distribution = StressScene::Distribution::CLUSTERED;
+    options.lights = 16;
+    options.seed = 42;
+    auto start = Clock::now();
+    StressScene a(options);
+    double generate_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    StressScene b(options);
+    a.animate(pool, 1.5f);
+    a.instances.update(pool);
+    b.animate(pool, 1.5f);
+    b.instances.update(pool);
+    bool same = a.meshes.size() == b.meshes.size() && a.lights.size() == b.lights.size();
+    for (size_t m = 0; same && m < a.meshes.size(); ++m) {
+        same = a.meshes[m].positions == b.meshes[m].positions && a.meshes[m].indices == b.meshes[m].indices;
+    }
+    for (size_t i = 0; same && i < a.instances.size(); ++i) {
+        same = a.instances.model(i) == b.instances.model(i) && a.instances.world(i).rows == b.instances.world(i).rows;
+    }
+    std::cout << "[I] stress scene of " << n << " instances, " << a.meshes.size() << " meshes and " << a.lights.size()
+              << " lights generated in " << std::fixed << std::setprecision(2) << generate_ms << " ms, "
+              << (same ? "reproducible" : "NOT reproducible") << std::endl;
+    return same;
+}
+
+static void print_row(const char *name, double per_second, double baseline, float diff) {
+    std::cout << std::setw(28) << std::left << name << std::right
+              << std::setw(12) << std::fixed << std::setprecision(2) << per_second / 1e6
+              << std::setw(10) << per_second / baseline
+              << std::setw(12) << std::scientific << std::setprecision(1) << diff << std::endl;
+}
+
+int main(int argc, char **argv) {
+    size_t n = 100000;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "-n" || arg == "--instances") && i + 1 < argc) {
+            n = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else {
+            std::cerr << "usage: " << argv[0] << " [-n <instances>]" << std::endl;
+            return -1;
+        }
+    }
+
+#if defined(__AVX2__)
+    const char *isa = "avx2";
+#elif defined(__SSE2__) || defined(_M_X64)
+    const char *isa = "sse2";
+#else
+    const char *isa = "scalar";
+#endif
+    std::cout << "[I] " << n << " instances, batched kernels built for " << isa << std::endl;
+
+    auto in = make_instances(n, 12345);
+    std::vector<matf4> scalar_models(n);
+    std::vector<matf3> scalar_normals(n);
+    std::vector<Affine> models(n), normals(n);
+    bool ok = true;
+
+    auto scalar = [&](bool with_normals) {
+        for (size_t i = 0; i < n; ++i) {
+            auto rotate = Utils::Transform::rotate_with(in.angle[i], vecf3(in.ax[i], in.ay[i], in.az[i]));
+            scalar_models[i] = Utils::Transform::generate_model_matrix(vecf3(in.px[i], in.py[i], in.pz[i]),
+                                                                       vecf3(in.sx[i], in.sy[i], in.sz[i]), rotate);
+            if (with_normals) {
+                scalar_normals[i] = scalar_models[i].topLeftCorner<3, 3>().inverse().transpose();
+            }
+        }
+    };
+
+    std::cout << std::setw(28) << std::left << "model matrices" << std::right << std::setw(12) << "M/s"
+              << std::setw(10) << "speedup" << std::setw(12) << "max diff" << std::endl;
+    double base = measure(n, [&] { scalar(false); });
+    print_row("eigen, axis angle", base, base, 0.0f);
+    double rate = measure(n, [&] {
+        Utils::Transform::generate_model_matrices(n, in.pos(), in.scale(), in.axis_angle(), models.data());
+    });
+    float diff = max_difference(models, scalar_models);
+    ok = ok && diff < TOLERANCE;
+    print_row("batched, axis angle", rate, base, diff);
+    rate = measure(n, [&] {
+        Utils::Transform::generate_model_matrices(n, in.pos(), in.scale(), in.quat(), models.data());
+    });
+    diff = max_difference(models, scalar_models);
+    ok = ok && diff < TOLERANCE;
+    print_row("batched, quaternion", rate, base, diff);
+
+    std::cout << std::setw(28) << std::left << "model and normal matrices" << std::right << std::endl;
+    base = measure(n, [&] { scalar(true); });
+    print_row("eigen, axis angle", base, base, 0.0f);
+    rate = measure(n, [&] {
+        Utils::Transform::generate_model_matrices(n, in.pos(), in.scale(), in.axis_angle(), models.data(), normals.data());
+    });
+    diff = std::max(max_difference(models, scalar_models), max_difference(normals, scalar_normals));
+    ok = ok && diff < TOLERANCE;
+    print_row("batched, axis angle", rate, base, diff);
+    rate = measure(n, [&] {
+        Utils::Transform::generate_model_matrices(n, in.pos(), in.scale(), in.quat(), models.data(), normals.data());
+    });
+    diff = std::max(max_difference(models, scalar_models), max_difference(normals, scalar_normals));
+    ok = ok && diff < TOLERANCE;
+    print_row("batched, quaternion", rate, base, diff);
+
+    // the positions as points through one of the models
+    std::cout << std::setw(28) << std::left << "points" << std::right << std::endl;
+    const matf4& m = scalar_models[n / 2];
+    Affine affine(m);
+    std::vector<float> ox(n), oy(n), oz(n);
+    std::vector<vecf3> scalar_points(n);
+    base = measure(n, [&] {
+        for (size_t i = 0; i < n; ++i) {
+            scalar_points[i] = (m * vecf4(in.px[i], in.py[i], in.pz[i], 1.0f)).head<3>();
+        }
+    });
+    print_row("eigen", base, base, 0.0f);
+    rate = measure(n, [&] {
+        Utils::Transform::transform_points(affine, n, in.pos(), ox.data(), oy.data(), oz.data());
+    });
+    diff = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        diff = std::max(diff, (scalar_points[i] - vecf3(ox[i], oy[i], oz[i])).cwiseAbs().maxCoeff());
+    }
+    // the points reach a few hundred, the tolerance is relative to that
+    ok = ok && diff < TOLERANCE * 1000.0f;
+    print_row("batched", rate, base, diff);
+
+    // parents times children and their inverses, as a hierarchy would
+    std::cout << std::setw(28) << std::left << "compose and invert" << std::right << std::endl;
+    std::vector<matf4> products(n);
+    std::vector<Affine> affine_products(n);
+    base = measure(n, [&] {
+        for (size_t i = 0; i < n; ++i) {
+            products[i] = scalar_models[i] * scalar_models[n - 1 - i];
+        }
+    });
+    print_row("matf4 product", base, base, 0.0f);
+    rate = measure(n, [&] {
+        for (size_t i = 0; i < n; ++i) {
+            affine_products[i] = models[i] * models[n - 1 - i];
+        }
+    });
+    diff = max_difference(affine_products, products);
+    ok = ok && diff < TOLERANCE * 100.0f;
+    print_row("affine product", rate, base, diff);
+    base = measure(n, [&] {
+        for (size_t i = 0; i < n; ++i) {
+            products[i] = scalar_models[i].inverse();
+        }
+    });
+    print_row("matf4 inverse", base, base, 0.0f);
+    rate = measure(n, [&] {
+        for (size_t i = 0; i < n; ++i) {
+            affine_products[i] = models[i].inverse();
+        }
+    });
+    diff = max_difference(affine_products, products);
+    ok = ok && diff < TOLERANCE * 1000.0f;
+    print_row("affine inverse", rate, base, diff);
+
+    if (!ok) {
+        std::cerr << "[E] The batched transforms differ from the scalar ones." << std::endl;
+        return -2;
+    }
+    if (!bench_scene_graph()) {
+        std::cerr << "[E] The scene graph's world transforms differ from their parent chains." << std::endl;
+        return -3;
+    }
+    if (!bench_instances(in, n)) {
+        std::cerr << "[E] The instance table's queries differ from the scans." << std::endl;
+        return -4;
+    }
+    if (!bench_meshes()) {
+        std::cerr << "[E] The synthetic meshes did not read back as they were written." << std::endl;
+        return -5;
+    }
+    if (!bench_stress_scene(n)) {
+        std::cerr << "[E] The stress scene differs between two runs with the same seed." << std::endl;
+        return -6;
+    }
+    return 0;
+}
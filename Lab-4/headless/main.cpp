@@ -0,0 +1,329 @@
+#include <iostream>
+#include <iomanip>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "Eigen/Dense"
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include "utils/tools.h"
+#include "utils/camera.h"
+#include "utils/transform.h"
+#include "utils/mesh_io.h"
+#include "utils/thread_pool.h"
+#include "utils/soft_rasterizer.h"
+#include "utils/instance_table.h"
+#include "utils/stress_scene.h"
+
+// Headless render of the cow scene with the software rasterizer: no GL, GLFW or window is needed,
+// so it runs on CI and batch hosts without a GPU. --stress renders a generated scene instead, to see
+// how the frame time scales with the instances, triangles and lights.
+
+using Clock = std::chrono::steady_clock;
+using Utils::Camera;
+using Utils::MeshData;
+using Utils::SoftTexture;
+using Utils::SoftMaterial;
+using Utils::SoftLight;
+using Utils::SoftRasterizer;
+using Utils::ThreadPool;
+using Utils::InstanceTable;
+using Utils::StressScene;
+using Utils::Transform::generate_model_matrix;
+using Utils::Transform::perspective;
+using Utils::Transform::rotate_with;
+
+struct Options {
+    std::string output = "cows.ppm";
+    int width = 800;
+    int height = 600;
+    size_t threads = 0;
+    size_t frames = 60;
+    bool bench = false;
+    bool stress = false;
+    StressScene::Options scene;
+};
+
+// the generated scene and how the headless renderer sees it
+struct Stress {
+    explicit Stress(const StressScene::Options& options) : scene(options) {}
+
+    StressScene scene;
+    Camera camera;
+    std::vector<SoftLight> lights;
+    std::vector<SoftMaterial> materials;
+    std::vector<InstanceTable::Instance> visible;
+};
+
+struct Scene {
+    MeshData cow;
+    MeshData plane;
+    SoftTexture cow_texture;
+    SoftTexture plane_texture;
+    std::vector<vecf3> cow_translates;
+    matf4 plane_transform;
+    Camera camera{vecf3(0.0f, 0.0f, 3.0f)};
+    SoftLight light;
+};
+
+static void print_usage(const char *name) {
+    std::cerr << "usage: " << name << " [options]\n"
+              << "  -o, --output <file>    PPM image of the last frame (default: cows.ppm)\n"
+              << "  -s, --size <w>x<h>     image size (default: 800x600)\n"
+              << "  -j, --threads <n>      number of threads (default: hardware concurrency)\n"
+              << "  -n, --frames <n>       number of frames to time (default: 60)\n"
+              << "      --bench            time every thread count from 1 to the hardware concurrency\n"
+              << "      --stress <n>       a generated scene of n instances instead of the cows, options:\n"
+              << "      --meshes <m>       number of synthetic meshes, spheres and terrains (default: 4)\n"
+              << "      --triangles <t>    triangles per mesh (default: 2000)\n"
+              << "      --lights <l>       number of point lights (default: 1)\n"
+              << "      --distribution <d> uniform, clustered or grid (default: uniform)\n"
+              << "      --motion <m>       static, spin or orbit (default: orbit)\n"
+              << "      --seed <s>         seed of the generator (default: 1)\n";
+}
+
+static bool parse_options(int argc, char **argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto has_value = i + 1 < argc;
+        if ((arg == "-o" || arg == "--output") && has_value) {
+            opt.output = argv[++i];
+        } else if ((arg == "-s" || arg == "--size") && has_value) {
+            if (std::sscanf(argv[++i], "%dx%d", &opt.width, &opt.height) != 2 || opt.width <= 0 || opt.height <= 0) {
+                std::cerr << "[E] Invalid size: " << argv[i] << std::endl;
+                return false;
+            }
+        } else if ((arg == "-j" || arg == "--threads") && has_value) {
+            opt.threads = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if ((arg == "-n" || arg == "--frames") && has_value) {
+            opt.frames = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--bench") {
+            opt.bench = true;
+        } else if (arg == "--stress" && has_value) {
+            opt.stress = true;
+            opt.scene.instances = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--meshes" && has_value) {
+            opt.scene.meshes = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--triangles" && has_value) {
+            opt.scene.triangles = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--lights" && has_value) {
+            opt.scene.lights = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--distribution" && has_value) {
+            if (!StressScene::parse(argv[++i], opt.scene.distribution)) {
+                std::cerr << "[E] Unknown distribution: " << argv[i] << std::endl;
+                return false;
+            }
+        } else if (arg == "--motion" && has_value) {
+            if (!StressScene::parse(argv[++i], opt.scene.motion)) {
+                std::cerr << "[E] Unknown motion: " << argv[i] << std::endl;
+                return false;
+            }
+        } else if (arg == "--seed" && has_value) {
+            opt.scene.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else {
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool load_texture(const char *path, SoftTexture& tex) {
+    stbi_set_flip_vertically_on_load(true);
+    uint8_t *data = stbi_load(path, &tex.width, &tex.height, &tex.channels, 0);
+    if (data == nullptr) {
+        std::cerr << "[E] Failed to load texture." << std::endl;
+        return false;
+    }
+    tex.data.assign(data, data + static_cast<size_t>(tex.width) * tex.height * tex.channels);
+    stbi_image_free(data);
+    return true;
+}
+
+static bool load_mesh(const char *path, MeshData& mesh) {
+    // the same preparation as Model::load
+    if (!Utils::load_obj(path, mesh)) {
+        return false;
+    }
+    Utils::normalize_mesh(mesh);
+    if (mesh.normals.empty()) {
+        mesh.normals = Utils::generate_normals(mesh.positions, mesh.indices);
+    }
+    return true;
+}
+
+// the scene of the viewer, at a fixed time so that images can be compared
+static bool load_scene(Scene& scene) {
+    if (!load_mesh(RESOURCES_DIR"/spot_triangulated_good.obj", scene.cow) ||
+        !load_mesh(RESOURCES_DIR"/plane.obj", scene.plane) ||
+        !load_texture(RESOURCES_DIR"/spot_albedo.png", scene.cow_texture) ||
+        !load_texture(RESOURCES_DIR"/checkerboard.png", scene.plane_texture)) {
+        return false;
+    }
+    scene.cow_translates = {
+        vecf3(0.0f,  -1.0f,  0.0f),
+        vecf3(2.0f,  5.0f, -15.0f),
+        vecf3(-1.5f, -1.2f, -2.5f),
+        vecf3(-3.8f, 3.0f, -12.3f),
+        vecf3(2.4f, 0.4f, -3.5f),
+        vecf3(-1.7f,  3.0f, -7.5f),
+        vecf3(1.3f, 5.0f, -2.5f),
+        vecf3(1.5f,  2.0f, -2.5f),
+        vecf3(1.5f,  0.2f, -1.5f),
+        vecf3(-1.3f,  1.0f, -1.5f),
+    };
+    scene.plane_transform = generate_model_matrix(vecf3(0.0f, -3.0f, -8.0f), vecf3(20.0f, 1.0f, 20.0f), matf4::Identity());
+    scene.light.position = vecf3(0.0f, 10.0f, 0.0f);
+    scene.light.radiance = vecf3(200.0f, 200.0f, 200.0f);
+    scene.light.ambient = 0.2f;
+    scene.light.specular = 0.8f;
+    return true;
+}
+
+static void render(const Scene& scene, SoftRasterizer& rasterizer, float time) {
+    const auto& camera = scene.camera;
+    auto aspect = static_cast<float>(rasterizer.width()) / static_cast<float>(rasterizer.height());
+    rasterizer.set_camera(camera.get_view_matrix(), perspective(to_radian(camera.zoom), aspect, 0.1f, 100.0f), camera.position);
+    rasterizer.set_light(scene.light);
+    rasterizer.clear(vecf3::Constant(scene.light.ambient));
+
+    SoftMaterial cow_material;
+    cow_material.albedo = &scene.cow_texture;
+    for (size_t i = 0; i < scene.cow_translates.size(); ++i) {
+        float angle = 20.0f * i + 10.0f * time;
+        auto model_mat = generate_model_matrix(scene.cow_translates[i], vecf3(1.0f, 1.0f, 1.0f),
+                                               rotate_with(to_radian(angle), vecf3(0.26726124, 0.53452248, 0.80178373)));
+        rasterizer.draw(scene.cow, model_mat, cow_material);
+    }
+
+    SoftMaterial plane_material;
+    plane_material.albedo = &scene.plane_texture;
+    rasterizer.draw(scene.plane, scene.plane_transform, plane_material);
+
+    rasterizer.flush();
+}
+
+// above the middle of the square looking down at it, one light per scene light
+static void setup_stress(Stress& stress) {
+    float extent = stress.scene.options.extent;
+    stress.camera = Camera(vecf3(0.0f, 0.6f * extent, 1.3f * extent), vecf3(0.0f, 1.0f, 0.0f), Camera::YAW, -30.0f);
+    for (const auto& light : stress.scene.lights) {
+        SoftLight soft;
+        soft.position = light.position;
+        soft.radiance = light.radiance;
+        stress.lights.push_back(soft);
+    }
+    for (const auto& color : stress.scene.colors) {
+        SoftMaterial material;
+        material.color = color;
+        stress.materials.push_back(material);
+    }
+}
+
+// the generated scene at time seconds, the instances out of view are culled before drawing
+static void render_stress(Stress& stress, ThreadPool& pool, SoftRasterizer& rasterizer, float time) {
+    auto& scene = stress.scene;
+    scene.animate(pool, time);
+    scene.instances.update(pool);
+
+    auto& camera = stress.camera;
+    camera.set_viewport(static_cast<float>(rasterizer.width()), static_cast<float>(rasterizer.height()),
+                        0.1f, 4.0f * scene.options.extent);
+    stress.visible.clear();
+    scene.instances.cull(camera.frustum(), stress.visible);
+
+    rasterizer.set_camera(camera.view(), camera.projection(), camera.position);
+    rasterizer.set_lights(stress.lights);
+    rasterizer.clear(vecf3::Constant(stress.lights[0].ambient));
+    for (auto i : stress.visible) {
+        auto model = scene.instances.model(i);
+        rasterizer.draw(scene.meshes[model], scene.instances.world(i).matrix(), stress.materials[model]);
+    }
+    rasterizer.flush();
+}
+
+// average milliseconds per frame of render(time), the last frame is left in the rasterizer
+template<typename RENDER>
+static double time_frames(RENDER&& render, size_t frames) {
+    render(0.0f); // warm up, sizes the bins
+    auto start = Clock::now();
+    for (size_t i = 0; i < frames; ++i) {
+        render(static_cast<float>(i) / 60.0f);
+    }
+    auto total = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    render(0.0f);
+    return total / static_cast<double>(frames);
+}
+
+int main(int argc, char **argv) {
+    Options opt;
+    if (!parse_options(argc, argv, opt)) {
+        return -1;
+    }
+
+    Scene scene;
+    std::unique_ptr<Stress> stress;
+    if (opt.stress) {
+        auto start = Clock::now();
+        stress = std::make_unique<Stress>(opt.scene);
+        setup_stress(*stress);
+        const char *distributions[] = {"uniform", "clustered", "grid"};
+        const char *motions[] = {"static", "spin", "orbit"};
+        std::cout << "[I] stress scene of " << opt.scene.instances << " instances of " << stress->scene.meshes.size()
+                  << " meshes of " << stress->scene.meshes[0].face_count() << " triangles, "
+                  << distributions[static_cast<int>(opt.scene.distribution)] << ", "
+                  << motions[static_cast<int>(opt.scene.motion)] << ", " << opt.scene.lights << " lights, seed "
+                  << opt.scene.seed << ", generated in "
+                  << std::chrono::duration<double, std::milli>(Clock::now() - start).count() << " ms" << std::endl;
+    } else if (!load_scene(scene)) {
+        return -2;
+    }
+
+    size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<size_t> thread_counts;
+    if (opt.bench) {
+        for (size_t n = 1; n < hardware; n *= 2) {
+            thread_counts.push_back(n);
+        }
+        thread_counts.push_back(hardware);
+    } else {
+        thread_counts.push_back(opt.threads == 0 ? hardware : opt.threads);
+    }
+
+    std::cout << "[I] " << opt.width << "x" << opt.height << ", " << hardware << " hardware threads" << std::endl;
+    std::cout << std::setw(8) << "threads" << std::setw(12) << "ms/frame" << std::setw(10) << "fps"
+              << std::setw(10) << "speedup" << std::setw(12) << "triangles" << std::endl;
+    double single_ms = 0.0;
+    std::unique_ptr<ThreadPool> last_pool;
+    std::unique_ptr<SoftRasterizer> last;
+    for (auto threads : thread_counts) {
+        auto pool = std::make_unique<ThreadPool>(threads);
+        auto rasterizer = std::make_unique<SoftRasterizer>(*pool, opt.width, opt.height);
+        auto ms = opt.stress ? time_frames([&](float time) { render_stress(*stress, *pool, *rasterizer, time); }, opt.frames)
+                             : time_frames([&](float time) { render(scene, *rasterizer, time); }, opt.frames);
+        if (single_ms == 0.0) {
+            single_ms = ms;
+        }
+        std::cout << std::setw(8) << threads
+                  << std::setw(12) << std::fixed << std::setprecision(2) << ms
+                  << std::setw(10) << 1000.0 / ms
+                  << std::setw(10) << single_ms / ms
+                  << std::setw(12) << rasterizer->triangle_count() << std::endl;
+        last = std::move(rasterizer);
+        last_pool = std::move(pool);
+    }
+
+    if (!last->save_ppm(opt.output)) {
+        return -3;
+    }
+    std::cout << "[I] Saved " << opt.output << std::endl;
+    return 0;
+}
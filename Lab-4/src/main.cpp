@@ -1,5 +1,8 @@
 #include <iostream>
 #include <cstdint>
+#include <cstdlib>
+#include <cmath>
+#include <string>
 #include <vector>
 #include <memory>
 
@@ -12,8 +15,11 @@
 #include "utils/shader.h"
 #include "utils/camera.h"
 #include "utils/model.h"
+#include "utils/lod_selector.h"
 #include "utils/tools.h"
 #include "utils/transform.h"
+#include "utils/thread_pool.h"
+#include "utils/instance_table.h"
 #include "utils/gl/core.h"
 #include "utils/gl/texture.h"
 #include "utils/gl/frame_buffer.h"
@@ -21,12 +27,16 @@
 using Utils::Camera;
 using Utils::Shader;
 using Utils::Model;
+using Utils::Affine;
+using Utils::LodSelector;
+using Utils::Frustum;
+using Utils::ThreadPool;
+using Utils::InstanceTable;
 using Utils::GL::Texture2D;
 using Utils::GL::FrameBuffer;
 using Utils::Transform::generate_model_matrix;
 using Utils::Transform::look_at;
-using Utils::Transform::perspective;
-using Utils::Transform::rotate_with;
+using Utils::Transform::orthographic;
 
 // declare callbacks
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
@@ -57,11 +67,35 @@ float last_frame = 0.0f;
 // runtime status
 bool is_space_pressing = false;
 bool show_shadow = false;
+bool is_l_pressing = false;
+bool use_lod = true;
+bool is_p_pressing = false;
+bool pick_requested = false;
 
 // shadow map settings
 constexpr size_t SHADOW_TEXTURE_SIZE = 1024;
 
+// level of detail settings, each level keeps half of the faces of the previous one
+constexpr float LOD_RATIO = 0.5f;
+constexpr size_t LOD_MIN_FACES = 200;
+constexpr size_t LOD_MAX_LEVELS = 6;
+
+// the axis every cow spins about, (1, 2, 3) normalized
+const vecf3 COW_AXIS(0.26726124f, 0.53452248f, 0.80178373f);
+
 int main(int argc, char **argv) {
+    // cows wandering around the ten placed ones, -n 100000 for a large scene
+    size_t field_cows = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "-n" || arg == "--cows") && i + 1 < argc) {
+            field_cows = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        } else {
+            std::cerr << "usage: " << argv[0] << " [-n <cows>]" << std::endl;
+            return -3;
+        }
+    }
+
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -110,6 +144,11 @@ int main(int argc, char **argv) {
     // load cow model
     auto cow_model = std::unique_ptr<Model>(Model::load(RESOURCES_DIR"/spot_triangulated_good.obj"));
     auto cow_texture = load_texture(RESOURCES_DIR"/spot_albedo.png");
+    cow_model->build_lods(LOD_RATIO, LOD_MIN_FACES, LOD_MAX_LEVELS);
+    for (size_t i = 0; i < cow_model->lods.size(); ++i) {
+        std::cout << "[I] cow lod " << i << ": " << cow_model->face_count(i) << " faces, error "
+                  << cow_model->lods[i].error << std::endl;
+    }
     std::vector<vecf3> cow_translates = {
         vecf3(0.0f,  -1.0f,  0.0f),
         vecf3(2.0f,  5.0f, -15.0f),
@@ -122,13 +161,46 @@ int main(int argc, char **argv) {
         vecf3(1.5f,  0.2f, -1.5f),
         vecf3(-1.3f,  1.0f, -1.5f),
     };
+    // The table has the positions and rotations the motion system writes; the orbits around a home
+    // and the spin phases are components of the viewer. The placed cows only spin.
+    ThreadPool pool;
+    InstanceTable cows;
+    auto cow_id = cows.add_model(cow_model->positions);
+    std::vector<float> cow_home_x, cow_home_z, cow_orbits, cow_phases, cow_spins;
+    auto add_cow = [&](const vecf3& home, float orbit, float phase) {
+        cow_home_x.push_back(home[0]);
+        cow_home_z.push_back(home[2]);
+        cow_orbits.push_back(orbit);
+        cow_phases.push_back(phase);
+        cow_spins.push_back(to_radian(static_cast<float>((20 * cows.size()) % 360)));
+        cows.add(cow_id, home);
+    };
+    for (const auto& t : cow_translates) {
+        add_cow(t, 0.0f, 0.0f);
+    }
+    uint32_t seed = 2024;
+    auto uniform = [&](float lo, float hi) {
+        seed = seed * 1664525u + 1013904223u;
+        return lo + (hi - lo) * static_cast<float>(seed >> 8) / static_cast<float>(1 << 24);
+    };
+    float field = 1.5f * std::sqrt(static_cast<float>(field_cows));
+    for (size_t i = 0; i < field_cows; ++i) {
+        add_cow(vecf3(uniform(-field, field), uniform(-2.0f, 6.0f), uniform(-field, field) - 8.0f),
+                uniform(0.5f, 3.0f), uniform(0.0f, 6.2831853f));
+    }
+    std::cout << "[I] " << cows.size() << " cows" << std::endl;
+    // the level each cow used last frame, the selector needs it for hysteresis
+    std::vector<size_t> cow_lods(cows.size(), 0);
+    std::vector<InstanceTable::Instance> visible_cows, shadow_cows;
+    LodSelector lod_selector;
 
     // load plane model
     auto plane_model = std::unique_ptr<Model>(Model::load(RESOURCES_DIR"/plane.obj"));
     auto plane_texture = load_texture(RESOURCES_DIR"/checkerboard.png");
     vecf3 plane_pos(0.0f, -3.0f, -8.0f);
     vecf3 plane_scale(20.0f, 1.0f, 20.0f);
-    matf4 plane_transform = generate_model_matrix(plane_pos, plane_scale, matf4::Identity());
+    Affine plane_transform(generate_model_matrix(plane_pos, plane_scale, matf4::Identity()));
+    Affine plane_normals = plane_transform.normal_matrix();
 
     glEnable(GL_CULL_FACE);
     glEnable(GL_DEPTH_TEST);
@@ -139,6 +211,19 @@ int main(int argc, char **argv) {
     FrameBuffer shadow_fbo;
     shadow_fbo.attach(GL_DEPTH_ATTACHMENT, &shadow_map);
 
+    // frame statistics, printed once per second
+    double stats_time = 0.0;
+    size_t stats_frames = 0;
+    size_t stats_triangles = 0;
+    size_t stats_shadow_triangles = 0;
+    size_t stats_visible = 0;
+
+    // the light looks at the plane, the orthographic box covers all of it
+    auto light_projection = orthographic(40.0f, 40.0f, 0.1f, 40.0f);
+    auto light_view = look_at(light_pos, plane_pos, vecf3(0.0f, 0.0f, -1.0f));
+    matf4 light_space_matrix = light_projection * light_view;
+    auto light_frustum = Frustum::from_view_projection(light_space_matrix);
+
     while (!glfwWindowShouldClose(window)) {
         // record time
         auto current_frame = static_cast<float>(glfwGetTime());
@@ -148,29 +233,70 @@ int main(int argc, char **argv) {
         process_input(window);
         process_release(window);
 
+        // both passes use the same transforms and levels
+        float time = static_cast<float>(glfwGetTime());
+        cows.run(pool, [&](size_t begin, size_t end) {
+            auto x = cows.x(), z = cows.z();
+            auto qx = cows.qx(), qy = cows.qy(), qz = cows.qz(), qw = cows.qw();
+            for (size_t i = begin; i < end; ++i) {
+                float half = 0.5f * (cow_spins[i] + to_radian(10.0f) * time);
+                float s = std::sin(half);
+                qx[i] = COW_AXIS[0] * s;
+                qy[i] = COW_AXIS[1] * s;
+                qz[i] = COW_AXIS[2] * s;
+                qw[i] = std::cos(half);
+                float orbit = 0.3f * time + cow_phases[i];
+                x[i] = cow_home_x[i] + cow_orbits[i] * std::cos(orbit);
+                z[i] = cow_home_z[i] + cow_orbits[i] * std::sin(orbit);
+            }
+        });
+        cows.update(pool);
+
+        camera.set_viewport(static_cast<float>(SCR_WIDTH), static_cast<float>(SCR_HEIGHT), 0.1f, 100.0f);
+        visible_cows.clear();
+        cows.cull(camera.frustum(), visible_cows);
+        shadow_cows.clear();
+        cows.cull(light_frustum, shadow_cows);
+
+        if (pick_requested) {
+            pick_requested = false;
+            float distance;
+            auto picked = cows.pick(camera.position, camera.front, &distance);
+            if (picked == InstanceTable::NONE) {
+                std::cout << "[I] no cow under the crosshair" << std::endl;
+            } else {
+                std::cout << "[I] picked cow " << picked << " at distance " << distance << std::endl;
+            }
+        }
+
+        lod_selector.set_projection(to_radian(camera.zoom), static_cast<float>(SCR_HEIGHT));
+        size_t frame_triangles = 0;
+        size_t frame_shadow_triangles = 0;
+        for (auto i : visible_cows) {
+            float distance = (cows.position(i) - camera.position).norm();
+            cow_lods[i] = use_lod ? lod_selector.select(*cow_model, distance, cow_lods[i]) : 0;
+        }
+
         /////////////////////////////////////////////////
         // render shadow map
         shadow_fbo.bind();
         glViewport(0, 0, SHADOW_TEXTURE_SIZE, SHADOW_TEXTURE_SIZE);
         glClear(GL_DEPTH_BUFFER_BIT);
 
-        // TODO 4.2 : Uncomment the following segment, then modify the light_projection and light_view implementations yourself.
-        auto light_projection = matf4::Identity();
-        auto light_view = matf4::Identity();
-        auto light_space_matrix = light_projection * light_view;
-//        shadow_shader.set_matf4("projection", light_projection);
-//        shadow_shader.set_matf4("view", light_view);
-//
-//        for (auto i = 0; i < cow_translates.size(); ++i) {
-//            float angle = 20.0f * i + 10.0f * static_cast<float>(glfwGetTime());
-//            auto model_mat = generate_model_matrix(cow_translates[i], vecf3(1.0f, 1.0f, 1.0f),
-//                                                rotate_with(to_radian(angle), vecf3(0.26726124, 0.53452248, 0.80178373)));
-//            shadow_shader.set_matf4("model", model_mat);
-//            cow_model->va->draw(shadow_shader);
-//        }
-//
-//        shadow_shader.set_matf4("model", plane_transform);
-//        plane_model->va->draw(shadow_shader);
+        shadow_shader.set_matf4("projection", light_projection);
+        shadow_shader.set_matf4("view", light_view);
+
+        // cows out of view keep the level they were last seen with
+        for (auto i : shadow_cows) {
+            auto lod = lod_selector.shadow_level(*cow_model, cow_lods[i]);
+            shadow_shader.set_affine("model", cows.world(i));
+            cow_model->draw(shadow_shader, lod);
+            frame_shadow_triangles += cow_model->face_count(lod);
+        }
+
+        shadow_shader.set_affine("model", plane_transform);
+        plane_model->va->draw(shadow_shader);
+        frame_shadow_triangles += plane_model->indices.size();
         FrameBuffer::bind_reset();
 
         /////////////////////////////////////////////////
@@ -182,24 +308,41 @@ int main(int argc, char **argv) {
         light_shader.set_vecf3("camera_pos", camera.position);
         light_shader.active_texture(0, &cow_texture);
         light_shader.active_texture(1, &shadow_map);
-
-        auto projection = perspective(to_radian(camera.zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        light_shader.set_matf4("projection", projection);
-        light_shader.set_matf4("view", camera.get_view_matrix());
+        light_shader.set_matf4("projection", camera.projection());
+        light_shader.set_matf4("view", camera.view());
         light_shader.set_bool("have_shadow", show_shadow);
         light_shader.set_matf4("light_space_matrix", light_space_matrix);
 
-        for (auto i = 0; i < cow_translates.size(); ++i) {
-            float angle = 20.0f * i + 10.0f * static_cast<float>(glfwGetTime());
-            auto model_mat = generate_model_matrix(cow_translates[i], vecf3(1.0f, 1.0f, 1.0f),
-                                                rotate_with(to_radian(angle), vecf3(0.26726124, 0.53452248, 0.80178373)));
-            light_shader.set_matf4("model", model_mat);
-            cow_model->va->draw(light_shader);
+        for (auto i : visible_cows) {
+            light_shader.set_affine("model", cows.world(i));
+            light_shader.set_affine("normal_matrix", cows.normal_matrix(i));
+            cow_model->draw(light_shader, cow_lods[i]);
+            frame_triangles += cow_model->face_count(cow_lods[i]);
         }
 
         light_shader.active_texture(0, &plane_texture);
-        light_shader.set_matf4("model", plane_transform);
+        light_shader.set_affine("model", plane_transform);
+        light_shader.set_affine("normal_matrix", plane_normals);
         plane_model->va->draw(light_shader);
+        frame_triangles += plane_model->indices.size();
+
+        stats_frames += 1;
+        stats_triangles += frame_triangles;
+        stats_shadow_triangles += frame_shadow_triangles;
+        stats_visible += visible_cows.size();
+        stats_time += delta_time;
+        if (stats_time >= 1.0) {
+            std::cout << "[I] " << (use_lod ? "lod" : "full") << ": "
+                      << 1000.0 * stats_time / static_cast<double>(stats_frames) << " ms/frame, "
+                      << stats_triangles / stats_frames << " triangles, "
+                      << stats_shadow_triangles / stats_frames << " shadow triangles, "
+                      << stats_visible / stats_frames << " of " << cows.size() << " cows visible" << std::endl;
+            stats_time = 0.0;
+            stats_frames = 0;
+            stats_triangles = 0;
+            stats_shadow_triangles = 0;
+            stats_visible = 0;
+        }
 
         // show
         glfwSwapBuffers(window);
@@ -250,6 +393,12 @@ void process_input(GLFWwindow *window) {
     if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
         is_space_pressing = true;
     } 
+    if (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS) {
+        is_l_pressing = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS) {
+        is_p_pressing = true;
+    }
 }
 
 void process_release(GLFWwindow *window) {
@@ -257,6 +406,14 @@ void process_release(GLFWwindow *window) {
         is_space_pressing = false;
         show_shadow = !show_shadow;
     }
+    if (glfwGetKey(window, GLFW_KEY_L) == GLFW_RELEASE && is_l_pressing) {
+        is_l_pressing = false;
+        use_lod = !use_lod;
+    }
+    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_RELEASE && is_p_pressing) {
+        is_p_pressing = false;
+        pick_requested = true;
+    }
 }
 
 void mouse_callback(GLFWwindow *window, double x_pos, double y_pos) {
@@ -4,9 +4,12 @@ layout (location = 0) in vec3 aPos;
 
 uniform mat4 projection;
 uniform mat4 view;
-uniform mat4 model;
+// rows of the affine model matrix
+uniform vec4 model[3];
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    vec4 pos = vec4(aPos, 1.0);
+    vec3 worldPos = vec3(dot(model[0], pos), dot(model[1], pos), dot(model[2], pos));
+    gl_Position = projection * view * vec4(worldPos, 1.0);
 }
@@ -12,15 +12,18 @@ out VS_OUT {
 
 uniform mat4 projection;
 uniform mat4 view;
-uniform mat4 model;
+// rows of the affine model matrix and of its inverse transpose, both computed once per instance
+uniform vec4 model[3];
+uniform vec4 normal_matrix[3];
 
 void main()
 {
-    vec4 worldPos = model * vec4(aPos, 1.0);
+    vec4 pos = vec4(aPos, 1.0);
+    vec3 worldPos = vec3(dot(model[0], pos), dot(model[1], pos), dot(model[2], pos));
 	
-	vs_out.WorldPos = worldPos.xyz / worldPos.w;
+	vs_out.WorldPos = worldPos;
     vs_out.TexCoord = aTexCoord;
-    vs_out.Normal = normalize(transpose(inverse(mat3(model))) * aNormal);
+    vs_out.Normal = normalize(vec3(dot(normal_matrix[0].xyz, aNormal), dot(normal_matrix[1].xyz, aNormal), dot(normal_matrix[2].xyz, aNormal)));
 	
-    gl_Position = projection * view * worldPos;
+    gl_Position = projection * view * vec4(worldPos, 1.0);
 }
@@ -0,0 +1,114 @@
+#ifndef UTILS_AFFINE_H
+#define UTILS_AFFINE_H
+
+#pragma once
+
+#include "Eigen/Dense"
+
+#include "utils/tools.h"
+
+namespace Utils {
+
+// An affine transform in 12 floats: the rows of [linear | translation], the last row 0 0 0 1 is
+// implied. Composing is a 3x4 by 3x4 product and the rows are contiguous, so a transform uploads
+// as a vec4[3] uniform (Shader::set_affine) that the shader applies with three dot products.
+class Affine {
+public:
+    using Rows = Eigen::Matrix<float, 3, 4, Eigen::RowMajor>;
+
+    Affine() { rows.setIdentity(); }
+    // the last row of m is dropped, it must be 0 0 0 1
+    explicit Affine(const matf4& m) : rows(m.topRows<3>()) {}
+    Affine(const matf3& linear, const vecf3& translation);
+
+    matf3 linear() const { return rows.leftCols<3>(); }
+    vecf3 translation() const { return rows.col(3); }
+    matf4 matrix() const;
+    // the three rows, 12 floats
+    const float *data() const { return rows.data(); }
+    float *data() { return rows.data(); }
+
+    Affine operator*(const Affine& rhs) const;
+    vecf3 transform_point(const vecf3& p) const { return rows.leftCols<3>() * p + rows.col(3); }
+    vecf3 transform_vector(const vecf3& v) const { return rows.leftCols<3>() * v; }
+
+    // From the cofactors of the linear part: its inverse transpose has the rows r1 x r2, r2 x r0 and
+    // r0 x r1 over the determinant, no general 3x3 inverse is needed.
+    Affine inverse() const;
+    // the inverse transpose of the linear part with no translation, for normals
+    Affine normal_matrix() const;
+
+    Rows rows;
+
+private:
+    struct Uninitialized {};
+    // for results that set every entry
+    explicit Affine(Uninitialized) {}
+};
+
+inline Affine::Affine(const matf3& linear, const vecf3& translation) {
+    rows.leftCols<3>() = linear;
+    rows.col(3) = translation;
+}
+
+inline matf4 Affine::matrix() const {
+    matf4 m;
+    m.topRows<3>() = rows;
+    m.row(3) << 0.0f, 0.0f, 0.0f, 1.0f;
+    return m;
+}
+
+inline Affine Affine::operator*(const Affine& rhs) const {
+    const float *a = data();
+    const float *b = rhs.data();
+    Affine result{Uninitialized{}};
+    float *r = result.data();
+    for (int i = 0; i < 3; ++i) {
+        const float *row = a + i * 4;
+        for (int j = 0; j < 4; ++j) {
+            r[i * 4 + j] = row[0] * b[j] + row[1] * b[4 + j] + row[2] * b[8 + j];
+        }
+        r[i * 4 + 3] += row[3];
+    }
+    return result;
+}
+
+inline Affine Affine::inverse() const {
+    // the inverse of the linear part is the transpose of normal_matrix()
+    Affine normals = normal_matrix();
+    const float *n = normals.data();
+    const float *t = data();
+    Affine result{Uninitialized{}};
+    float *r = result.data();
+    for (int i = 0; i < 3; ++i) {
+        r[i * 4] = n[i];
+        r[i * 4 + 1] = n[4 + i];
+        r[i * 4 + 2] = n[8 + i];
+        r[i * 4 + 3] = -(n[i] * t[3] + n[4 + i] * t[7] + n[8 + i] * t[11]);
+    }
+    return result;
+}
+
+inline Affine Affine::normal_matrix() const {
+    const float *m = data();
+    // the cross products of the rows
+    float c[9] = {
+        m[5] * m[10] - m[6] * m[9], m[6] * m[8] - m[4] * m[10], m[4] * m[9] - m[5] * m[8],
+        m[9] * m[2] - m[10] * m[1], m[10] * m[0] - m[8] * m[2], m[8] * m[1] - m[9] * m[0],
+        m[1] * m[6] - m[2] * m[5], m[2] * m[4] - m[0] * m[6], m[0] * m[5] - m[1] * m[4],
+    };
+    float inv_det = 1.0f / (m[0] * c[0] + m[1] * c[1] + m[2] * c[2]);
+    Affine result{Uninitialized{}};
+    float *r = result.data();
+    for (int i = 0; i < 3; ++i) {
+        r[i * 4] = c[i * 3] * inv_det;
+        r[i * 4 + 1] = c[i * 3 + 1] * inv_det;
+        r[i * 4 + 2] = c[i * 3 + 2] * inv_det;
+        r[i * 4 + 3] = 0.0f;
+    }
+    return result;
+}
+
+} // namespace Utils
+
+#endif // UTILS_AFFINE_H
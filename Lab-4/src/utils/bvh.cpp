@@ -0,0 +1,294 @@
+#include "bvh.h"
+
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+#include <functional>
+
+namespace Utils {
+
+// deep enough for any balanced tree of 32 bit item counts
+static constexpr int STACK_SIZE = 64;
+
+static double surface(const float *min, const float *max) {
+    if (min[0] > max[0]) {
+        return 0.0;
+    }
+    double dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+    return 2.0 * (dx * dy + dy * dz + dz * dx);
+}
+
+void Bvh::clear() {
+    nodes.clear();
+    parents.clear();
+    items.clear();
+    leaf_of.clear();
+    subtree_roots.clear();
+    subtree_ends.clear();
+    top.clear();
+    marked.clear();
+    area = built_area = 0.0;
+}
+
+void Bvh::build(size_t n, const SphereArray& spheres) {
+    clear();
+    if (n == 0) {
+        return;
+    }
+    items.resize(n);
+    std::iota(items.begin(), items.end(), 0u);
+    leaf_of.resize(n);
+    std::vector<vecf3> centers(n);
+    for (size_t i = 0; i < n; ++i) {
+        centers[i] = vecf3(spheres.x[i], spheres.y[i], spheres.z[i]);
+    }
+    nodes.reserve(2 * (n / LEAF_SIZE + 1));
+    parents.reserve(nodes.capacity());
+    build_node(0, static_cast<uint32_t>(n), NONE, 0, centers);
+
+    marked.assign(nodes.size(), 0);
+    for (auto i = static_cast<uint32_t>(nodes.size()); i-- > 0; ) {
+        area += fit(i, spheres);
+    }
+    built_area = area;
+}
+
+uint32_t Bvh::build_node(uint32_t begin, uint32_t end, uint32_t parent, int depth, const std::vector<vecf3>& centers) {
+    auto node = static_cast<uint32_t>(nodes.size());
+    nodes.push_back({{FLT_MAX, FLT_MAX, FLT_MAX}, 0, {-FLT_MAX, -FLT_MAX, -FLT_MAX}, 0});
+    parents.push_back(parent);
+    bool leaf = end - begin <= LEAF_SIZE;
+
+    // a leaf above the split depth is a subtree of its own
+    size_t subtree = subtree_roots.size();
+    bool subtree_root = depth == SPLIT_DEPTH || (depth < SPLIT_DEPTH && leaf);
+    if (subtree_root) {
+        subtree_roots.push_back(node);
+        subtree_ends.push_back(node + 1);
+    } else if (depth < SPLIT_DEPTH) {
+        top.push_back(node);
+    }
+
+    if (leaf) {
+        nodes[node].first = begin;
+        nodes[node].count = end - begin;
+        for (auto i = begin; i < end; ++i) {
+            leaf_of[items[i]] = node;
+        }
+        return node;
+    }
+
+    vecf3 lo = vecf3::Constant(FLT_MAX), hi = vecf3::Constant(-FLT_MAX);
+    for (auto i = begin; i < end; ++i) {
+        lo = lo.cwiseMin(centers[items[i]]);
+        hi = hi.cwiseMax(centers[items[i]]);
+    }
+    int axis;
+    (hi - lo).maxCoeff(&axis);
+    auto mid = begin + (end - begin) / 2;
+    std::nth_element(items.begin() + begin, items.begin() + mid, items.begin() + end,
+                     [&](uint32_t a, uint32_t b) { return centers[a][axis] < centers[b][axis]; });
+
+    build_node(begin, mid, node, depth + 1, centers);
+    nodes[node].first = build_node(mid, end, node, depth + 1, centers);
+    if (subtree_root) {
+        subtree_ends[subtree] = static_cast<uint32_t>(nodes.size());
+    }
+    return node;
+}
+
+double Bvh::fit(uint32_t i, const SphereArray& spheres) {
+    auto& node = nodes[i];
+    double before = surface(node.min, node.max);
+    float lo[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+    float hi[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    if (node.count > 0) {
+        for (auto k = node.first; k < node.first + node.count; ++k) {
+            auto item = items[k];
+            float c[3] = {spheres.x[item], spheres.y[item], spheres.z[item]};
+            float r = spheres.radius[item];
+            for (int a = 0; a < 3; ++a) {
+                lo[a] = std::min(lo[a], c[a] - r);
+                hi[a] = std::max(hi[a], c[a] + r);
+            }
+        }
+    } else {
+        const auto& left = nodes[i + 1];
+        const auto& right = nodes[node.first];
+        for (int a = 0; a < 3; ++a) {
+            lo[a] = std::min(left.min[a], right.min[a]);
+            hi[a] = std::max(left.max[a], right.max[a]);
+        }
+    }
+    std::copy(lo, lo + 3, node.min);
+    std::copy(hi, hi + 3, node.max);
+    return surface(node.min, node.max) - before;
+}
+
+void Bvh::refit(ThreadPool& pool, const SphereArray& spheres) {
+    if (nodes.empty()) {
+        return;
+    }
+    std::vector<double> changes(subtree_roots.size(), 0.0);
+    pool.run(subtree_roots.size(), [&](size_t k, size_t) {
+        double change = 0.0;
+        for (auto i = subtree_ends[k]; i-- > subtree_roots[k]; ) {
+            change += fit(i, spheres);
+        }
+        changes[k] = change;
+    });
+    for (auto change : changes) {
+        area += change;
+    }
+    for (auto i = top.rbegin(); i != top.rend(); ++i) {
+        area += fit(*i, spheres);
+    }
+}
+
+void Bvh::refit(const SphereArray& spheres, const std::vector<uint32_t>& moved) {
+    refit_nodes.clear();
+    for (auto item : moved) {
+        for (auto i = leaf_of[item]; i != NONE && !marked[i]; i = parents[i]) {
+            marked[i] = 1;
+            refit_nodes.push_back(i);
+        }
+    }
+    // children before their parents
+    std::sort(refit_nodes.begin(), refit_nodes.end(), std::greater<uint32_t>());
+    for (auto i : refit_nodes) {
+        area += fit(i, spheres);
+        marked[i] = 0;
+    }
+}
+
+void Bvh::item_range(uint32_t node, uint32_t& begin, uint32_t& end) const {
+    auto first = node;
+    while (nodes[first].count == 0) {
+        first = first + 1;
+    }
+    auto last = node;
+    while (nodes[last].count == 0) {
+        last = nodes[last].first;
+    }
+    begin = nodes[first].first;
+    end = nodes[last].first + nodes[last].count;
+}
+
+void Bvh::cull(const Frustum& frustum, const SphereArray& spheres, std::vector<uint32_t>& visible) const {
+    if (nodes.empty()) {
+        return;
+    }
+    uint32_t stack[STACK_SIZE];
+    int depth = 0;
+    stack[depth++] = 0;
+    while (depth > 0) {
+        auto i = stack[--depth];
+        const auto& node = nodes[i];
+        // against the corners farthest along and against each normal
+        bool outside = false, inside = true;
+        for (const auto& plane : frustum.planes) {
+            float farthest = plane[3], nearest = plane[3];
+            for (int a = 0; a < 3; ++a) {
+                farthest += plane[a] * (plane[a] >= 0.0f ? node.max[a] : node.min[a]);
+                nearest += plane[a] * (plane[a] >= 0.0f ? node.min[a] : node.max[a]);
+            }
+            if (farthest < 0.0f) {
+                outside = true;
+                break;
+            }
+            inside = inside && nearest >= 0.0f;
+        }
+        if (outside) {
+            continue;
+        }
+        if (inside) {
+            uint32_t begin, end;
+            item_range(i, begin, end);
+            visible.insert(visible.end(), items.begin() + begin, items.begin() + end);
+        } else if (node.count > 0) {
+            for (auto k = node.first; k < node.first + node.count; ++k) {
+                auto item = items[k];
+                if (frustum.intersects_sphere(vecf3(spheres.x[item], spheres.y[item], spheres.z[item]), spheres.radius[item])) {
+                    visible.push_back(item);
+                }
+            }
+        } else {
+            stack[depth++] = node.first;
+            stack[depth++] = i + 1;
+        }
+    }
+}
+
+uint32_t Bvh::pick(const vecf3& origin, const vecf3& direction, const SphereArray& spheres, float *distance) const {
+    uint32_t best = NONE;
+    float best_t = FLT_MAX;
+    if (nodes.empty()) {
+        return best;
+    }
+    // slabs, the NaN of a zero component on a slab plane is ignored by min and max
+    vecf3 inv = direction.cwiseInverse();
+    auto enter = [&](const Node& node) {
+        float t0 = 0.0f, t1 = best_t;
+        for (int a = 0; a < 3; ++a) {
+            float lo = (node.min[a] - origin[a]) * inv[a];
+            float hi = (node.max[a] - origin[a]) * inv[a];
+            if (lo > hi) {
+                std::swap(lo, hi);
+            }
+            t0 = std::max(t0, lo);
+            t1 = std::min(t1, hi);
+        }
+        return t0 <= t1 ? t0 : FLT_MAX;
+    };
+
+    uint32_t stack[STACK_SIZE];
+    int depth = 0;
+    stack[depth++] = 0;
+    while (depth > 0) {
+        auto i = stack[--depth];
+        const auto& node = nodes[i];
+        // best_t may have shrunk since the node was pushed
+        if (enter(node) == FLT_MAX) {
+            continue;
+        }
+        if (node.count > 0) {
+            for (auto k = node.first; k < node.first + node.count; ++k) {
+                auto item = items[k];
+                vecf3 oc = origin - vecf3(spheres.x[item], spheres.y[item], spheres.z[item]);
+                float b = oc.dot(direction);
+                float c = oc.dot(oc) - spheres.radius[item] * spheres.radius[item];
+                float discriminant = b * b - c;
+                if ((c > 0.0f && b > 0.0f) || discriminant < 0.0f) {
+                    continue;
+                }
+                // 0 when the origin is inside the sphere
+                float t = std::max(-b - std::sqrt(discriminant), 0.0f);
+                if (t < best_t) {
+                    best_t = t;
+                    best = item;
+                }
+            }
+            continue;
+        }
+        // the nearer child is popped first
+        auto left = i + 1, right = node.first;
+        float t_left = enter(nodes[left]), t_right = enter(nodes[right]);
+        if (t_left > t_right) {
+            std::swap(left, right);
+            std::swap(t_left, t_right);
+        }
+        if (t_right != FLT_MAX) {
+            stack[depth++] = right;
+        }
+        if (t_left != FLT_MAX) {
+            stack[depth++] = left;
+        }
+    }
+    if (distance != nullptr && best != NONE) {
+        *distance = best_t;
+    }
+    return best;
+}
+
+} // namespace Utils
@@ -0,0 +1,88 @@
+#ifndef UTILS_BVH_H
+#define UTILS_BVH_H
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "Eigen/Dense"
+
+#include "utils/tools.h"
+#include "utils/camera.h"
+#include "utils/thread_pool.h"
+
+namespace Utils {
+
+// bounding spheres in structure of arrays layout
+struct SphereArray {
+    const float *x, *y, *z, *radius;
+};
+
+// A bounding volume hierarchy over spheres, the items being their indices. build() splits at the
+// median of the widest axis of the centers down to LEAF_SIZE items, so the tree stays balanced.
+// Moving items only needs a refit: the boxes of their leaves and of the ancestors grow or shrink to
+// fit again, the topology is kept. Refits let boxes overlap more and more as items travel,
+// degraded() tells when a build pays off again. Nodes are depth first, the left child of a node
+// follows it and a subtree is a contiguous range, so a full refit is one reverse sweep per subtree.
+class Bvh {
+public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+    static constexpr uint32_t LEAF_SIZE = 4;
+    // subtrees at this depth are refitted in parallel, the nodes above them after
+    static constexpr int SPLIT_DEPTH = 6;
+    // the summed node areas against the ones after the build
+    static constexpr double REBUILD_RATIO = 1.5;
+
+    void build(size_t n, const SphereArray& spheres);
+    void clear();
+    // every node, in parallel over the subtrees
+    void refit(ThreadPool& pool, const SphereArray& spheres);
+    // only the leaves of the items and their ancestors
+    void refit(const SphereArray& spheres, const std::vector<uint32_t>& moved);
+    bool degraded() const { return area > REBUILD_RATIO * built_area; }
+
+    // The items whose sphere intersects the frustum, appended. A node entirely inside adds its items
+    // without testing them.
+    void cull(const Frustum& frustum, const SphereArray& spheres, std::vector<uint32_t>& visible) const;
+    // The first item the ray hits, NONE if there is none. direction must be normalized; distance
+    // gets how far along the ray the sphere is hit.
+    uint32_t pick(const vecf3& origin, const vecf3& direction, const SphereArray& spheres, float *distance = nullptr) const;
+
+    size_t size() const { return items.size(); }
+    size_t node_count() const { return nodes.size(); }
+
+private:
+    // an interior node has count 0, its children are the next node and first
+    struct Node {
+        float min[3];
+        uint32_t first;
+        float max[3];
+        uint32_t count;
+    };
+
+    uint32_t build_node(uint32_t begin, uint32_t end, uint32_t parent, int depth, const std::vector<vecf3>& centers);
+    // returns the change of the node's area
+    double fit(uint32_t node, const SphereArray& spheres);
+    // the range of items below a node
+    void item_range(uint32_t node, uint32_t& begin, uint32_t& end) const;
+
+    std::vector<Node> nodes;
+    std::vector<uint32_t> parents;
+    // the items of the leaves, left to right
+    std::vector<uint32_t> items;
+    std::vector<uint32_t> leaf_of;
+    // the roots and ends of the subtrees refitted in parallel, and the nodes above them depth first
+    std::vector<uint32_t> subtree_roots;
+    std::vector<uint32_t> subtree_ends;
+    std::vector<uint32_t> top;
+    // for the partial refit
+    std::vector<uint8_t> marked;
+    std::vector<uint32_t> refit_nodes;
+    double area = 0.0;
+    double built_area = 0.0;
+};
+
+}
+
+#endif // UTILS_BVH_H
@@ -10,6 +10,25 @@
 
 namespace Utils {
 
+// The six planes of a view projection, normals pointing inside and normalized, so a plane's dot
+// product with (p, 1) is the signed distance of p.
+struct Frustum {
+    vecf4 planes[6];
+
+    static Frustum from_view_projection(const matf4& view_projection);
+    bool intersects_sphere(const vecf3& center, float radius) const;
+    bool intersects_box(const vecf3& min, const vecf3& max) const;
+};
+
+// std140 layout, for a uniform block of three mat4 and a vec4
+struct CameraUniforms {
+    matf4 view;
+    matf4 projection;
+    matf4 view_projection;
+    vecf4 position;
+};
+static_assert(sizeof(CameraUniforms) == 208, "CameraUniforms must match the std140 block");
+
 class Camera {
 public:
     // Defines several possible options for camera movement. Used as abstraction to stay away from window-system specific input methods
@@ -29,7 +48,8 @@ public:
     static constexpr float SENSITIVITY = 0.1f;
     static constexpr float ZOOM = 45.0f;
     
-    // Camera Attributes
+    // Camera Attributes, the process_* functions keep the cached matrices up to date and code that
+    // assigns them directly calls invalidate()
     vecf3 position;
     vecf3 front;
     vecf3 up;
@@ -53,6 +73,21 @@ public:
     // Returns the projection matrix
     matf4 get_projection_matrix(float width, float height, float near, float far) const;
 
+    // The projection of the accessors below, only a change invalidates it
+    void set_viewport(float width, float height, float near, float far);
+    void invalidate() { view_dirty = projection_dirty = true; }
+
+    // Cached, each is computed again on the first call after a change. The inverses of the view and
+    // of the perspective are in closed form.
+    const matf4& view() const;
+    const matf4& projection() const;
+    const matf4& view_projection() const;
+    const matf4& inverse_view() const;
+    const matf4& inverse_projection() const;
+    const matf4& inverse_view_projection() const;
+    const Frustum& frustum() const;
+    const CameraUniforms& uniforms() const;
+
     // Processes input received from any keyboard-like input system. Accepts input parameter in the form of camera defined ENUM (to abstract it from windowing systems)
     void process_keyboard(Movement direction, float delta_time);
 
@@ -65,6 +100,26 @@ public:
 private:
     // Calculates the front vector from the Camera's (updated) Euler Angles
     void update_camera_vectors();
+    void update_view() const;
+    void update_projection() const;
+    void update_derived() const;
+
+    float aspect = 4.0f / 3.0f;
+    float near_plane = 0.1f;
+    float far_plane = 100.0f;
+
+    mutable bool view_dirty = true;
+    mutable bool projection_dirty = true;
+    // the products, inverse, frustum and uniforms
+    mutable bool derived_dirty = true;
+    mutable matf4 view_matrix;
+    mutable matf4 inverse_view_matrix;
+    mutable matf4 projection_matrix;
+    mutable matf4 inverse_projection_matrix;
+    mutable matf4 view_projection_matrix;
+    mutable matf4 inverse_view_projection_matrix;
+    mutable Frustum frustum_planes;
+    mutable CameraUniforms uniform_block;
 };
 }
 
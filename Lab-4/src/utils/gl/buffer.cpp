@@ -43,4 +43,9 @@ void Buffer::sub_data(GLintptr offset, GLsizeiptr size, const void *data) {
     glBufferSubData(target, offset, size, data);
 }
 
+void Buffer::reallocate(GLsizeiptr size, const void *data) {
+    bind();
+    glBufferData(target, size, data, usage);
+}
+
 }
\ No newline at end of file
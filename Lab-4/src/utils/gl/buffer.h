@@ -25,6 +25,8 @@ public:
     static void bind_reset(BufferType target);
 
     void sub_data(GLintptr offset, GLsizeiptr size, const void *data);
+    // new storage for the same buffer object, so vertex arrays referencing it stay valid
+    void reallocate(GLsizeiptr size, const void *data = nullptr);
 
 protected:
     BufferType target;
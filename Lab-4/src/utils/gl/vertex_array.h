@@ -38,6 +38,8 @@ public:
     void attach(const std::vector<GLuint>& indices, const Format& format);
 
     void draw(const Shader& shader) const;
+    // draw count indices starting at first, added to base_vertex (a sub-mesh of a shared buffer)
+    void draw(const Shader& shader, GLsizei count, GLuint first, GLint base_vertex) const;
 
     bool is_valid() const noexcept;
 
@@ -0,0 +1,179 @@
+#include "instance_table.h"
+
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+
+#include "utils/transform.h"
+
+namespace Utils {
+
+uint32_t InstanceTable::add_model(const vecf3& center, float radius) {
+    model_centers.push_back(center);
+    model_radii.push_back(radius);
+    return static_cast<uint32_t>(model_radii.size() - 1);
+}
+
+uint32_t InstanceTable::add_model(const std::vector<vecf3>& positions) {
+    vecf3 lo = vecf3::Constant(FLT_MAX), hi = vecf3::Constant(-FLT_MAX);
+    for (const auto& p : positions) {
+        lo = lo.cwiseMin(p);
+        hi = hi.cwiseMax(p);
+    }
+    vecf3 center = positions.empty() ? vecf3::Zero() : vecf3(0.5f * (lo + hi));
+    float radius = 0.0f;
+    for (const auto& p : positions) {
+        radius = std::max(radius, (p - center).norm());
+    }
+    return add_model(center, radius);
+}
+
+InstanceTable::Instance InstanceTable::add(uint32_t model, const vecf3& position, const Eigen::Quaternionf& rotation, float scale) {
+    assert(model < model_radii.size());
+    auto i = static_cast<Instance>(models.size());
+    xs.push_back(position[0]);
+    ys.push_back(position[1]);
+    zs.push_back(position[2]);
+    qxs.push_back(rotation.x());
+    qys.push_back(rotation.y());
+    qzs.push_back(rotation.z());
+    qws.push_back(rotation.w());
+    scales.push_back(scale);
+    models.push_back(model);
+    worlds.emplace_back();
+    normals.emplace_back();
+    bound_xs.push_back(0.0f);
+    bound_ys.push_back(0.0f);
+    bound_zs.push_back(0.0f);
+    bound_radii.push_back(0.0f);
+    touched.resize(blocks(), 0);
+    changed.push_back(0);
+    touched[i / BLOCK] = 1;
+    return i;
+}
+
+void InstanceTable::clear() {
+    for (auto column : {&xs, &ys, &zs, &qxs, &qys, &qzs, &qws, &scales, &bound_xs, &bound_ys, &bound_zs, &bound_radii}) {
+        column->clear();
+    }
+    models.clear();
+    worlds.clear();
+    normals.clear();
+    touched.clear();
+    changed.clear();
+    changes.clear();
+    bvh.clear();
+    indexed = 0;
+}
+
+void InstanceTable::touch(Instance i) {
+    if (!changed[i]) {
+        changed[i] = 1;
+        changes.push_back(i);
+    }
+}
+
+void InstanceTable::set_position(Instance i, const vecf3& position) {
+    xs[i] = position[0];
+    ys[i] = position[1];
+    zs[i] = position[2];
+    touch(i);
+}
+
+void InstanceTable::set_rotation(Instance i, const Eigen::Quaternionf& rotation) {
+    qxs[i] = rotation.x();
+    qys[i] = rotation.y();
+    qzs[i] = rotation.z();
+    qws[i] = rotation.w();
+    touch(i);
+}
+
+void InstanceTable::set_scale(Instance i, float scale) {
+    scales[i] = scale;
+    touch(i);
+}
+
+void InstanceTable::run(ThreadPool& pool, const System& system) {
+    auto n = size();
+    pool.run(blocks(), [&](size_t b, size_t) {
+        system(b * BLOCK, std::min(n, (b + 1) * BLOCK));
+    });
+    std::fill(touched.begin(), touched.end(), 1);
+}
+
+size_t InstanceTable::update(ThreadPool& pool) {
+    auto n = size();
+    // the changes in touched blocks are done with them
+    changes.erase(std::remove_if(changes.begin(), changes.end(), [&](uint32_t i) {
+        changed[i] = 0;
+        return touched[i / BLOCK] != 0;
+    }), changes.end());
+    size_t touched_blocks = 0;
+    updates = changes.size();
+    for (size_t b = 0; b < touched.size(); ++b) {
+        if (touched[b]) {
+            touched_blocks++;
+            updates += std::min(n, (b + 1) * BLOCK) - b * BLOCK;
+        }
+    }
+
+    auto transform = [&](size_t begin, size_t count) {
+        Transform::generate_model_matrices(count, {xs.data() + begin, ys.data() + begin, zs.data() + begin},
+                                           {scales.data() + begin, scales.data() + begin, scales.data() + begin},
+                                           Transform::QuatArray{qxs.data() + begin, qys.data() + begin, qzs.data() + begin, qws.data() + begin},
+                                           worlds.data() + begin, normals.data() + begin);
+        for (auto i = begin; i < begin + count; ++i) {
+            auto m = models[i];
+            vecf3 center = worlds[i].transform_point(model_centers[m]);
+            bound_xs[i] = center[0];
+            bound_ys[i] = center[1];
+            bound_zs[i] = center[2];
+            bound_radii[i] = model_radii[m] * std::abs(scales[i]);
+        }
+    };
+    pool.run(blocks(), [&](size_t b, size_t) {
+        if (touched[b]) {
+            transform(b * BLOCK, std::min(n, (b + 1) * BLOCK) - b * BLOCK);
+        }
+    });
+    for (auto i : changes) {
+        transform(i, 1);
+    }
+
+    rebuilt = false;
+    if (indexed != n) {
+        bvh.build(n, bounds());
+        indexed = n;
+        rebuilt = true;
+    } else if (touched_blocks > FULL_REFIT_SHARE * static_cast<float>(touched.size())) {
+        bvh.refit(pool, bounds());
+    } else if (updates > 0) {
+        moved.assign(changes.begin(), changes.end());
+        for (size_t b = 0; b < touched.size(); ++b) {
+            if (touched[b]) {
+                for (auto i = b * BLOCK; i < std::min(n, (b + 1) * BLOCK); ++i) {
+                    moved.push_back(static_cast<uint32_t>(i));
+                }
+            }
+        }
+        bvh.refit(bounds(), moved);
+    }
+    if (!rebuilt && bvh.degraded()) {
+        bvh.build(n, bounds());
+        rebuilt = true;
+    }
+    std::fill(touched.begin(), touched.end(), 0);
+    changes.clear();
+    return updates;
+}
+
+void InstanceTable::cull(const Frustum& frustum, std::vector<Instance>& visible) const {
+    bvh.cull(frustum, bounds(), visible);
+}
+
+InstanceTable::Instance InstanceTable::pick(const vecf3& origin, const vecf3& direction, float *distance) const {
+    return bvh.pick(origin, direction, bounds(), distance);
+}
+
+} // namespace Utils
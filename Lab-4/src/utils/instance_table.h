@@ -0,0 +1,112 @@
+#ifndef UTILS_INSTANCE_TABLE_H
+#define UTILS_INSTANCE_TABLE_H
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+#include "Eigen/Dense"
+#include "Eigen/Geometry"
+
+#include "utils/tools.h"
+#include "utils/affine.h"
+#include "utils/camera.h"
+#include "utils/bvh.h"
+#include "utils/thread_pool.h"
+
+namespace Utils {
+
+// Instances of models in structure of arrays layout: a position, a rotation, a uniform scale and a
+// model id each, and from them the world transforms and bounding spheres. Systems run over blocks
+// of BLOCK instances on a thread pool and write the columns they own; update() then computes the
+// transforms of the blocks they touched with the batched kernels and refits a Bvh over the spheres,
+// which the culling and picking queries walk instead of the instances.
+class InstanceTable {
+public:
+    using Instance = uint32_t;
+    static constexpr Instance NONE = UINT32_MAX;
+    static constexpr size_t BLOCK = 1024;
+    // more blocks touched than this share and the whole Bvh is refitted in parallel
+    static constexpr float FULL_REFIT_SHARE = 0.25f;
+
+    // begin and end are instances of one block
+    using System = std::function<void(size_t begin, size_t end)>;
+
+    // a bounding sphere in the model's space, returns the model id
+    uint32_t add_model(const vecf3& center, float radius);
+    // the sphere around the center of the positions' box
+    uint32_t add_model(const std::vector<vecf3>& positions);
+
+    Instance add(uint32_t model, const vecf3& position,
+                 const Eigen::Quaternionf& rotation = Eigen::Quaternionf::Identity(), float scale = 1.0f);
+    void clear();
+
+    void set_position(Instance i, const vecf3& position);
+    void set_rotation(Instance i, const Eigen::Quaternionf& rotation);
+    void set_scale(Instance i, float scale);
+
+    // Runs system over every block in parallel, all of them count as touched. The columns below are
+    // for systems, writing them elsewhere leaves the transforms stale.
+    void run(ThreadPool& pool, const System& system);
+    float *x() { return xs.data(); }
+    float *y() { return ys.data(); }
+    float *z() { return zs.data(); }
+    // unit quaternions, w is the real part
+    float *qx() { return qxs.data(); }
+    float *qy() { return qys.data(); }
+    float *qz() { return qzs.data(); }
+    float *qw() { return qws.data(); }
+    float *scale() { return scales.data(); }
+
+    // Transforms and bounds of the touched blocks and of the instances set, then the Bvh: built when
+    // instances were added or the refits degraded it, else refitted. Returns the instances transformed.
+    size_t update(ThreadPool& pool);
+
+    // as of the last update()
+    void cull(const Frustum& frustum, std::vector<Instance>& visible) const;
+    Instance pick(const vecf3& origin, const vecf3& direction, float *distance = nullptr) const;
+
+    size_t size() const { return models.size(); }
+    size_t blocks() const { return (size() + BLOCK - 1) / BLOCK; }
+    uint32_t model(Instance i) const { return models[i]; }
+    vecf3 position(Instance i) const { return vecf3(xs[i], ys[i], zs[i]); }
+    const Affine& world(Instance i) const { return worlds[i]; }
+    const Affine& normal_matrix(Instance i) const { return normals[i]; }
+    SphereArray bounds() const { return {bound_xs.data(), bound_ys.data(), bound_zs.data(), bound_radii.data()}; }
+    const Bvh& index() const { return bvh; }
+    size_t last_updates() const { return updates; }
+    // built again rather than refitted by the last update()
+    bool last_rebuilt() const { return rebuilt; }
+
+private:
+    void touch(Instance i);
+
+    // the bounding spheres of the models
+    std::vector<vecf3> model_centers;
+    std::vector<float> model_radii;
+
+    std::vector<float> xs, ys, zs;
+    std::vector<float> qxs, qys, qzs, qws;
+    std::vector<float> scales;
+    std::vector<uint32_t> models;
+
+    std::vector<Affine> worlds;
+    std::vector<Affine> normals;
+    std::vector<float> bound_xs, bound_ys, bound_zs, bound_radii;
+
+    // blocks touched by run() and single instances by the setters
+    std::vector<uint8_t> touched;
+    std::vector<uint8_t> changed;
+    std::vector<uint32_t> changes;
+    std::vector<uint32_t> moved;
+    Bvh bvh;
+    size_t indexed = 0;
+    size_t updates = 0;
+    bool rebuilt = false;
+};
+
+}
+
+#endif // UTILS_INSTANCE_TABLE_H
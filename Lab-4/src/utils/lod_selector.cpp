@@ -0,0 +1,39 @@
+#include "lod_selector.h"
+
+namespace Utils {
+
+void LodSelector::set_projection(float fov_y, float screen_height) {
+    projection_scale = screen_height / (2.0f * std::tan(fov_y / 2.0f));
+}
+
+float LodSelector::screen_error(const Model& model, size_t lod, float distance) const {
+    // inside the near plane everything is as close as it gets
+    distance = std::max(distance, 0.1f);
+    return model.lods[lod].error * projection_scale / distance;
+}
+
+size_t LodSelector::select(const Model& model, float distance, size_t current) const {
+    current = std::min(current, model.lods.size() - 1);
+
+    // the coarsest level that is still good enough
+    size_t target = 0;
+    for (size_t i = model.lods.size(); i-- > 0; ) {
+        if (screen_error(model, i, distance) <= threshold) {
+            target = i;
+            break;
+        }
+    }
+
+    // refining happens right away, coarsening only past the hysteresis band
+    float coarsen_threshold = threshold * (1.0f - hysteresis);
+    while (target > current && screen_error(model, target, distance) > coarsen_threshold) {
+        target--;
+    }
+    return target;
+}
+
+size_t LodSelector::shadow_level(const Model& model, size_t lod) const {
+    return std::min(lod + shadow_bias, model.lods.size() - 1);
+}
+
+}
@@ -0,0 +1,42 @@
+#ifndef UTILS_LOD_SELECTOR_H
+#define UTILS_LOD_SELECTOR_H
+
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "Eigen/Dense"
+
+#include "utils/tools.h"
+#include "utils/model.h"
+
+namespace Utils {
+
+// Picks a model's level of detail from the error it would show on screen:
+// a level's error projected at the instance's distance must stay under threshold pixels.
+// A coarser level is only taken once it is under (1 - hysteresis) of the threshold,
+// so instances near the boundary don't flicker between two levels every frame.
+class LodSelector {
+public:
+    float threshold = 1.0f;     // pixels
+    float hysteresis = 0.25f;
+    size_t shadow_bias = 1;     // the shadow map is blurry anyway, draw it this many levels coarser
+
+    // pixels per model unit at distance 1, screen_height / (2 * tan(fov_y / 2))
+    void set_projection(float fov_y, float screen_height);
+
+    float screen_error(const Model& model, size_t lod, float distance) const;
+
+    // current is the level the instance used last frame
+    size_t select(const Model& model, float distance, size_t current) const;
+    size_t shadow_level(const Model& model, size_t lod) const;
+
+private:
+    float projection_scale = 1.0f;
+};
+
+}
+
+#endif // UTILS_LOD_SELECTOR_H
@@ -0,0 +1,196 @@
+#include "mesh_io.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+
+namespace Utils {
+
+static bool read_file(const std::string& path, std::string& buffer) {
+    std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        std::cerr << "[E] Failed to open file: " << path << std::endl;
+        return false;
+    }
+    auto size = static_cast<size_t>(file.tellg());
+    file.seekg(0, std::ios::beg);
+    buffer.resize(size);
+    file.read(buffer.data(), static_cast<std::streamsize>(size));
+    return static_cast<bool>(file);
+}
+
+static const char *parse_floats(const char *cur, const char *line_end, float *out, int n) {
+    for (int i = 0; i < n; ++i) {
+        char *next = nullptr;
+        out[i] = std::strtof(cur, &next);
+        if (next == cur || next > line_end) {
+            return nullptr;
+        }
+        cur = next;
+    }
+    return cur;
+}
+
+template<typename T>
+static void drop_unmatched(std::vector<T>& attr, size_t vertex_cnt) {
+    if (!attr.empty() && attr.size() != vertex_cnt) {
+        attr.clear();
+    }
+}
+
+// Every face must name loaded vertices, the simplifier and the draws index with them unchecked
+static bool check_indices(const std::string& path, const MeshData& mesh) {
+    auto vertex_cnt = mesh.positions.size();
+    for (const auto& idx : mesh.indices) {
+        for (int k = 0; k < 3; ++k) {
+            if (idx[k] < 0 || static_cast<size_t>(idx[k]) >= vertex_cnt) {
+                std::cerr << "[E] Face index out of range in file: " << path << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool load_obj(const std::string& path, MeshData& mesh) {
+    std::string buffer;
+    if (!read_file(path, buffer)) {
+        return false;
+    }
+
+    mesh = MeshData();
+    auto& positions = mesh.positions;
+    auto& indices = mesh.indices;
+
+    std::vector<int> polygon;
+    const char *cur = buffer.c_str();
+    const char *end = cur + buffer.size();
+    while (cur < end) {
+        auto line_end = static_cast<const char *>(std::memchr(cur, '\n', end - cur));
+        if (line_end == nullptr) {
+            line_end = end;
+        }
+        while (cur < line_end && (*cur == ' ' || *cur == '\t')) {
+            cur++;
+        }
+
+        auto len = line_end - cur;
+        if (len > 2 && cur[0] == 'v' && cur[1] == ' ') {
+            vecf3 pos;
+            if (parse_floats(cur + 2, line_end, pos.data(), 3)) {
+                positions.emplace_back(pos);
+            }
+        } else if (len > 3 && cur[0] == 'v' && cur[1] == 't' && cur[2] == ' ') {
+            vecf2 tex;
+            if (parse_floats(cur + 3, line_end, tex.data(), 2)) {
+                mesh.texcoords.emplace_back(tex);
+            }
+        } else if (len > 3 && cur[0] == 'v' && cur[1] == 'n' && cur[2] == ' ') {
+            vecf3 normal;
+            if (parse_floats(cur + 3, line_end, normal.data(), 3)) {
+                mesh.normals.emplace_back(normal);
+            }
+        } else if (len > 2 && cur[0] == 't' && cur[1] == ' ') {
+            vecf3 tangent;
+            if (parse_floats(cur + 2, line_end, tangent.data(), 3)) {
+                mesh.tangents.emplace_back(tangent);
+            }
+        } else if (len > 2 && cur[0] == 'f' && cur[1] == ' ') {
+            // "f v", "f v/vt", "f v//vn" and "f v/vt/vn" only differ after the first slash
+            polygon.clear();
+            cur += 2;
+            while (cur < line_end) {
+                char *next = nullptr;
+                long idx = std::strtol(cur, &next, 10);
+                if (next == cur || next > line_end) {
+                    break;
+                }
+                long vertex = idx < 0 ? static_cast<long>(positions.size()) + idx : idx - 1;
+                // 0 and indices past int become -1 instead of wrapping, check_indices rejects them
+                polygon.push_back(vertex < 0 || vertex > INT_MAX ? -1 : static_cast<int>(vertex));
+                cur = next;
+                while (cur < line_end && *cur != ' ' && *cur != '\t') {
+                    cur++;
+                }
+            }
+            for (size_t i = 2; i < polygon.size(); ++i) {
+                indices.emplace_back(polygon[0], polygon[i - 1], polygon[i]);
+            }
+        }
+
+        cur = line_end + 1;
+    }
+
+    drop_unmatched(mesh.texcoords, positions.size());
+    drop_unmatched(mesh.normals, positions.size());
+    drop_unmatched(mesh.tangents, positions.size());
+    return check_indices(path, mesh);
+}
+
+bool save_obj(const std::string& path, const MeshData& mesh) {
+    std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "[E] Failed to open file: " << path << std::endl;
+        return false;
+    }
+    // enough digits for the floats to read back the same
+    file.precision(9);
+    for (const auto& p : mesh.positions) {
+        file << "v " << p[0] << ' ' << p[1] << ' ' << p[2] << '\n';
+    }
+    for (const auto& t : mesh.texcoords) {
+        file << "vt " << t[0] << ' ' << t[1] << '\n';
+    }
+    for (const auto& n : mesh.normals) {
+        file << "vn " << n[0] << ' ' << n[1] << ' ' << n[2] << '\n';
+    }
+    for (const auto& t : mesh.tangents) {
+        file << "t " << t[0] << ' ' << t[1] << ' ' << t[2] << '\n';
+    }
+    bool texcoords = !mesh.texcoords.empty(), normals = !mesh.normals.empty();
+    for (const auto& idx : mesh.indices) {
+        file << 'f';
+        for (int k = 0; k < 3; ++k) {
+            auto i = idx[k] + 1;
+            file << ' ' << i;
+            if (texcoords || normals) {
+                file << '/';
+                if (texcoords) {
+                    file << i;
+                }
+                if (normals) {
+                    file << '/' << i;
+                }
+            }
+        }
+        file << '\n';
+    }
+    return static_cast<bool>(file);
+}
+
+void normalize_mesh(MeshData& mesh) {
+    auto& positions = mesh.positions;
+    if (positions.empty()) {
+        return;
+    }
+
+    // I don't implement the bounding box for this
+    vecf3 center = vecf3::Zero();
+    float scale = 0.0f;
+    for (const auto& pos : positions) {
+        center += pos;
+    }
+    center /= static_cast<float>(positions.size());
+    for (const auto& pos : positions) {
+        scale = std::max(scale, (pos - center).norm());
+    }
+    scale = 1.0f / scale;
+    for (auto& pos : positions) {
+        pos = (pos - center) * scale;
+    }
+}
+
+}
@@ -0,0 +1,30 @@
+#ifndef UTILS_MESH_IO_H
+#define UTILS_MESH_IO_H
+
+#pragma once
+
+#include <vector>
+#include <string>
+
+#include "Eigen/Dense"
+
+#include "utils/tools.h"
+#include "utils/mesh_data.h"
+
+// Reading meshes without any GL dependency, shared by Model and the headless renderer
+namespace Utils {
+
+// Parses positions, texcoords (vt), normals (vn), tangents (t) and faces of an OBJ file,
+// polygons are fan-triangulated. Attributes are indexed by the position index, like the
+// resources of this lab, and dropped if they don't match the positions one to one.
+bool load_obj(const std::string& path, MeshData& mesh);
+
+// Writes the attributes indexed by the position index the way load_obj reads them back
+bool save_obj(const std::string& path, const MeshData& mesh);
+
+// Centers the mesh at its vertex average and scales it into the unit sphere
+void normalize_mesh(MeshData& mesh);
+
+}
+
+#endif // UTILS_MESH_IO_H
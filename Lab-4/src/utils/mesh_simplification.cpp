@@ -0,0 +1,255 @@
+#include "mesh_simplification.h"
+
+#include <cmath>
+
+namespace Utils {
+
+static constexpr float EPSILON = 1e-15f;
+
+struct Edge {
+    int first, second; // vertex id of the edge endpoints (first < second)
+    float cost; // cost of the edge
+
+    bool operator==(const Edge& other) const {
+        return first == other.first && second == other.second && std::abs(cost - other.cost) < EPSILON;
+    }
+    bool operator<(const Edge& other) const {
+        if (std::abs(cost - other.cost) < EPSILON) {
+            if (first == other.first) {
+                return second < other.second;
+            } else {
+                return first < other.first;
+            }
+        } else {
+          	return cost < other.cost;
+        }
+    }
+};
+
+MeshData simplify_mesh(MeshData&& mesh, float ratio, float *error) {
+
+    auto& vertices = mesh.positions;
+    auto& faces = mesh.indices;
+    auto& normals = mesh.normals;
+    auto& texcoords = mesh.texcoords;
+    auto& tangents = mesh.tangents;
+    bool has_texcoords = texcoords.size() == vertices.size();
+    bool has_tangents = tangents.size() == vertices.size();
+    float max_cost = 0.0f;
+
+    // record whether the vertex is deleted
+    std::deque<bool> vertices_deleted(vertices.size(), false);
+
+    // record the face index of each vertex,
+    std::vector<std::vector<int>> faces_of_vertices(vertices.size());
+    for (int i = 0; i < faces.size(); ++i) {
+        for (int j = 0; j < 3; ++j) {
+            faces_of_vertices[faces[i][j]].push_back(i);
+        }
+    }
+    for (int i = 0; i < vertices.size(); ++i) {
+        if (faces_of_vertices[i].empty()) {
+            vertices_deleted[i] = true;
+        }
+    }
+
+    // the weighted face normal sums are kept up to date while collapsing,
+    // so the simplified mesh doesn't need another generate_normals pass
+    NormalAccumulator accumulator(vertices, faces);
+
+    // 3.1:
+    // compute the Q matrices for all the initial vertices
+    std::vector<matf4> quadrics(vertices.size(), matf4::Zero());
+    for (const auto& face : faces) {
+        const auto& p0 = vertices[face[0]];
+        vecf3 normal = (vertices[face[1]] - p0).cross(vertices[face[2]] - p0);
+        if (normal.norm() < EPSILON) {
+            continue;
+        }
+        normal.normalize();
+        vecf4 plane(normal[0], normal[1], normal[2], -normal.dot(p0));
+        matf4 kp = plane * plane.transpose();
+        for (int j = 0; j < 3; ++j) {
+            quadrics[face[j]] += kp;
+        }
+    }
+
+    // 3.2:
+    // select all valid pairs(edges) and compute the cost of each edge
+    auto optimal_position = [&](int v1, int v2) -> vecf3 {
+        matf4 q = quadrics[v1] + quadrics[v2];
+        q.row(3) << 0.0f, 0.0f, 0.0f, 1.0f;
+        Eigen::FullPivLU<matf4> lu(q);
+        if (lu.isInvertible()) {
+            vecf4 v = lu.solve(vecf4(0.0f, 0.0f, 0.0f, 1.0f));
+            return v.head<3>();
+        }
+        return (vertices[v1] + vertices[v2]) / 2.0f;
+    };
+
+    std::set<Edge> heap;
+    std::map<std::pair<int, int>, float> edge_costs;
+    auto push_edge = [&](int v1, int v2) {
+        if (v1 > v2) {
+            std::swap(v1, v2);
+        }
+        if (edge_costs.count({v1, v2})) {
+            return;
+        }
+        vecf3 pos = optimal_position(v1, v2);
+        vecf4 v(pos[0], pos[1], pos[2], 1.0f);
+        float cost = v.dot((quadrics[v1] + quadrics[v2]) * v);
+        heap.insert(Edge{v1, v2, cost});
+        edge_costs[{v1, v2}] = cost;
+    };
+    auto pop_edge = [&](int v1, int v2) {
+        if (v1 > v2) {
+            std::swap(v1, v2);
+        }
+        auto it = edge_costs.find({v1, v2});
+        if (it != edge_costs.end()) {
+            heap.erase(Edge{v1, v2, it->second});
+            edge_costs.erase(it);
+        }
+    };
+
+    for (const auto& face : faces) {
+        push_edge(face[0], face[1]);
+        push_edge(face[1], face[2]);
+        push_edge(face[2], face[0]);
+    }
+
+    // 3.3:
+    // iteratively remove the pair of the least cost from the heap
+    uint32_t face_cnt = faces.size();
+    uint32_t target_face_cnt = face_cnt * ratio;
+    // scratch of every collapse, reused
+    std::vector<int> touched;
+    std::vector<int> kept;
+    while (face_cnt > target_face_cnt && !heap.empty()) {
+        // remove the min edge from the heap
+        Edge edge = *heap.begin();
+        pop_edge(edge.first, edge.second);
+        int v1 = edge.first;
+        int v2 = edge.second;
+        if (vertices_deleted[v1] || vertices_deleted[v2]) {
+            continue;
+        }
+
+        // faces around the pair, the shared ones are only listed once
+        touched.assign(faces_of_vertices[v1].begin(), faces_of_vertices[v1].end());
+        for (auto f : faces_of_vertices[v2]) {
+            const auto& face = faces[f];
+            if (face[0] != v1 && face[1] != v1 && face[2] != v1) {
+                touched.push_back(f);
+            }
+        }
+        for (auto f : touched) {
+            accumulator.remove_face(vertices, faces[f]);
+            for (int j = 0; j < 3; ++j) {
+                auto v = faces[f][j];
+                if (v != v1 && v != v2) {
+                    pop_edge(v1, v);
+                    pop_edge(v2, v);
+                }
+            }
+        }
+
+        max_cost = std::max(max_cost, edge.cost);
+
+        // merge v2 into v1
+        vertices[v1] = optimal_position(v1, v2);
+        quadrics[v1] += quadrics[v2];
+        vertices_deleted[v2] = true;
+
+        // maintain the faces
+        // set face invalid (with -1, -1, -1)
+        kept.clear();
+        for (auto f : touched) {
+            auto& face = faces[f];
+            bool has_v1 = face[0] == v1 || face[1] == v1 || face[2] == v1;
+            bool has_v2 = face[0] == v2 || face[1] == v2 || face[2] == v2;
+            if (has_v1 && has_v2) {
+                for (int j = 0; j < 3; ++j) {
+                    auto v = face[j];
+                    if (v == v1 || v == v2) {
+                        continue;
+                    }
+                    auto& around = faces_of_vertices[v];
+                    around.erase(std::remove(around.begin(), around.end(), f), around.end());
+                    if (around.empty()) {
+                        vertices_deleted[v] = true;
+                    }
+                }
+                face = veci3(-1, -1, -1);
+                face_cnt -= 1;
+            } else {
+                for (int j = 0; j < 3; ++j) {
+                    if (face[j] == v2) {
+                        face[j] = v1;
+                    }
+                }
+                accumulator.add_face(vertices, face);
+                kept.push_back(f);
+            }
+        }
+        faces_of_vertices[v1].assign(kept.begin(), kept.end());
+        faces_of_vertices[v2].clear();
+        if (faces_of_vertices[v1].empty()) {
+            vertices_deleted[v1] = true;
+            continue;
+        }
+
+        // update the costs of all valid pairs
+        for (auto f : faces_of_vertices[v1]) {
+            for (int j = 0; j < 3; ++j) {
+                if (faces[f][j] != v1) {
+                    push_edge(v1, faces[f][j]);
+                }
+            }
+        }
+    }
+
+    // create the new mesh
+    int new_vert_cnt = 0;
+    int new_face_cnt = 0;
+    normals.clear();
+    for (auto i = 0; i < vertices.size(); ++i) {
+        if (!vertices_deleted[i]) {
+            vertices[new_vert_cnt] = vertices[i];
+            if (has_texcoords) {
+                texcoords[new_vert_cnt] = texcoords[i];
+            }
+            if (has_tangents) {
+                tangents[new_vert_cnt] = tangents[i];
+            }
+            normals.emplace_back(accumulator.normal(i));
+            for (auto face : faces_of_vertices[i]) {
+                assert(face != -1);
+                for (int j = 0; j < 3; ++j) {
+                    if (faces[face][j] == i) {
+                        faces[face][j] = new_vert_cnt;
+                    }
+                }
+            }
+            new_vert_cnt += 1;
+        }
+    }
+    for (int i = 0; i < faces.size(); ++i) {
+        if (faces[i][0] != faces[i][1] && faces[i][1] != faces[i][2] && faces[i][2] != faces[i][0]) {
+            faces[new_face_cnt] = faces[i];
+            new_face_cnt += 1;
+        }
+    }
+    vertices.resize(new_vert_cnt);
+    faces.resize(new_face_cnt);
+    texcoords.resize(has_texcoords ? new_vert_cnt : 0);
+    tangents.resize(has_tangents ? new_vert_cnt : 0);
+    if (error != nullptr) {
+        *error = std::sqrt(std::max(max_cost, 0.0f));
+    }
+
+    return std::move(mesh);
+}
+
+}
@@ -0,0 +1,30 @@
+#ifndef UTILS_MESH_SIMPLIFICATION_H
+#define UTILS_MESH_SIMPLIFICATION_H
+
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <deque>
+#include <cassert>
+
+#include "Eigen/Dense"
+
+#include "utils/tools.h"
+#include "utils/mesh_data.h"
+#include "utils/normal_accumulator.h"
+
+namespace Utils {
+
+// Quadric error edge collapse, the same algorithm as Lab 3. A kept vertex keeps its own
+// texcoord and tangent, normals are maintained incrementally and replaced.
+// ratio is the fraction of faces to keep. If error is given it receives the largest
+// collapse error, the square root of the quadric cost, which is in model units.
+MeshData simplify_mesh(MeshData&& mesh, float ratio, float *error = nullptr);
+
+}
+
+#endif // UTILS_MESH_SIMPLIFICATION_H
@@ -1,88 +1,24 @@
 #include <utils/model.h>
+#include <utils/mesh_simplification.h>
+#include <utils/mesh_io.h>
 
 namespace Utils {
 
 Model::~Model() = default;
 
 Model *Model::load(const std::string& path) {
-    std::ifstream file(path, std::ios::in | std::ios::ate);
-    if (!file.is_open()) {
-        std::cerr << "[E] Failed to open file: " << path << std::endl;
+    MeshData mesh;
+    if (!load_obj(path, mesh)) {
         return nullptr;
     }
+    normalize_mesh(mesh);
 
-    auto size = static_cast<size_t>(file.tellg());
-    file.seekg(0, std::ios::beg);
-    char *buffer = new char[size + 1];
-    buffer[size] = 0;
-    file.read(buffer, static_cast<int64_t>(size));
-    file.close();
-
-    std::vector<std::string> lines;
-    for (size_t i = 0; i <= size; ) {
-        auto j = 0;
-        while ((buffer[i + j] != '\n') && (buffer[i + j] != '\0')) {
-            j++;
-        }
-        lines.emplace_back(buffer + i, j);
-        i += j + 1;
-    }
-    delete[] buffer;
-    buffer = nullptr;
-    
-    std::vector<vecf3> positions;
-    std::vector<vecf3> normals;
-    std::vector<vecf2> texcoords;
-    std::vector<veci3> indices;
-    std::vector<vecf3> tangents;
-    for (const auto& line : lines) {
-        if (line.empty() || line == "\n" || line == "\r\n") {
-            continue;
-        }
-
-        std::stringstream ss(line);
-        std::string id;
-        ss >> id;
-        if (id == "v") {
-            vecf3 pos;
-            ss >> pos[0] >> pos[1] >> pos[2];
-            positions.emplace_back(pos);
-        } else if (id == "f") {
-            veci3 idx;
-            ss >> idx[0] >> idx[1] >> idx[2];
-            indices.emplace_back(idx - veci3::Ones());
-        } else if (id == "vt") {
-            vecf2 tex;
-            ss >> tex[0] >> tex[1];
-            texcoords.emplace_back(tex);
-        } else if (id == "vn") {
-            vecf3 normal;
-            ss >> normal[0] >> normal[1] >> normal[2];
-            normals.emplace_back(normal);
-        } else if (id == "t") {
-            vecf3 tangent;
-            ss >> tangent[0] >> tangent[1] >> tangent[2];
-            tangents.emplace_back(tangent);
-        }
-    }
-    
     auto model = new Model;
-
-    // I don't implement the bounding box for this
-    vecf3 center = vecf3::Zero();
-    float scale = 0.0f;
-    for (const auto& pos : positions) {
-        center += pos;
-    }
-    center /= static_cast<float>(positions.size());
-    for (const auto& pos : positions) {
-        scale = std::max(scale, (pos - center).norm());
-    }
-    scale = 1.0f / scale;
-    for (auto& pos : positions) {
-        pos = (pos - center) * scale;
-    }
-    
+    auto& positions = mesh.positions;
+    auto& texcoords = mesh.texcoords;
+    auto& normals = mesh.normals;
+    auto& tangents = mesh.tangents;
+    auto& indices = mesh.indices;
     if (normals.empty()) {
         normals = generate_normals(positions, indices);
     }
@@ -101,7 +37,9 @@ Model *Model::load(const std::string& path) {
     format.eb = eb;
 
     model->vbos["position"] = std::unique_ptr<VertexBuffer>(vb_pos);
+    model->vbos["texcoord"] = std::unique_ptr<VertexBuffer>(vb_uv);
     model->vbos["normal"] = std::unique_ptr<VertexBuffer>(vb_norm);
+    model->vbos["tangent"] = std::unique_ptr<VertexBuffer>(vb_t);
     model->eb = std::unique_ptr<ElementBuffer>(eb);
     model->va = std::make_unique<VertexArray>(std::vector<GLuint>{0, 1, 2, 3}, format);
 
@@ -110,6 +48,7 @@ Model *Model::load(const std::string& path) {
     model->normals = std::move(normals);
     model->tangents = std::move(tangents);
     model->indices = std::move(indices);
+    model->lods.push_back({0, 0, static_cast<GLsizei>(model->indices.size() * 3), 0.0f});
 
     return model;
 }
@@ -134,6 +73,7 @@ Model *Model::load(std::vector<vecf3>&& positions, std::vector<veci3>&& indices)
     model->positions = std::move(positions);
     model->normals = std::move(normals);
     model->indices = std::move(indices);
+    model->lods.push_back({0, 0, static_cast<GLsizei>(model->indices.size() * 3), 0.0f});
 
     return model;
 }
@@ -158,8 +98,81 @@ Model *Model::load(const std::vector<vecf3>& positions, const std::vector<veci3>
     model->positions = positions;
     model->normals = std::move(normals);
     model->indices = indices;
+    model->lods.push_back({0, 0, static_cast<GLsizei>(model->indices.size() * 3), 0.0f});
 
     return model;
 }
 
+void Model::build_lods(float ratio, size_t min_faces, size_t max_levels) {
+    auto per_vertex = [this](size_t n) { return n == 0 || n == positions.size(); };
+    if (!per_vertex(texcoords.size()) || !per_vertex(normals.size()) || !per_vertex(tangents.size())) {
+        std::cerr << "[E] Levels of detail need one attribute per vertex." << std::endl;
+        return;
+    }
+
+    std::vector<MeshData> meshes(1);
+    meshes[0].positions = positions;
+    meshes[0].texcoords = texcoords;
+    meshes[0].normals = normals;
+    meshes[0].tangents = tangents;
+    meshes[0].indices = indices;
+
+    lods.resize(1);
+    float error = 0.0f;
+    while (lods.size() < max_levels) {
+        const auto& prev = meshes.back();
+        if (static_cast<size_t>(static_cast<float>(prev.face_count()) * ratio) < min_faces) {
+            break;
+        }
+        float step_error = 0.0f;
+        auto mesh = simplify_mesh(MeshData(prev), ratio, &step_error);
+        if (mesh.empty() || mesh.face_count() >= prev.face_count()) {
+            break;
+        }
+        // each level is simplified from the previous one, so the errors add up
+        error += step_error;
+
+        const auto& last = lods.back();
+        lods.push_back({last.base_vertex + static_cast<GLint>(prev.vertex_count()),
+                        last.first_index + static_cast<GLuint>(last.index_count),
+                        static_cast<GLsizei>(mesh.face_count() * 3), error});
+        meshes.push_back(std::move(mesh));
+    }
+    if (meshes.size() == 1) {
+        return;
+    }
+
+    // the levels back to back, so that a level is just a draw range
+    MeshData all;
+    for (const auto& mesh : meshes) {
+        all.positions.insert(all.positions.end(), mesh.positions.begin(), mesh.positions.end());
+        all.texcoords.insert(all.texcoords.end(), mesh.texcoords.begin(), mesh.texcoords.end());
+        all.normals.insert(all.normals.end(), mesh.normals.begin(), mesh.normals.end());
+        all.tangents.insert(all.tangents.end(), mesh.tangents.begin(), mesh.tangents.end());
+        all.indices.insert(all.indices.end(), mesh.indices.begin(), mesh.indices.end());
+    }
+
+    auto upload = [this](const std::string& name, GLsizeiptr size, const void *data) {
+        auto it = vbos.find(name);
+        if (it != vbos.end()) {
+            it->second->reallocate(size, data);
+        }
+    };
+    upload("position", static_cast<GLsizeiptr>(all.positions.size() * sizeof(vecf3)), all.positions.data());
+    upload("texcoord", static_cast<GLsizeiptr>(all.texcoords.size() * sizeof(vecf2)), all.texcoords.data());
+    upload("normal", static_cast<GLsizeiptr>(all.normals.size() * sizeof(vecf3)), all.normals.data());
+    upload("tangent", static_cast<GLsizeiptr>(all.tangents.size() * sizeof(vecf3)), all.tangents.data());
+    VertexBuffer::bind_reset();
+
+    // binding the element buffer outside of a vertex array would change the bound one's state
+    VertexArray::bind_reset();
+    eb->reallocate(static_cast<GLsizeiptr>(all.indices.size() * sizeof(veci3)), all.indices.data());
+    ElementBuffer::bind_reset();
+}
+
+void Model::draw(const Shader& shader, size_t lod) const {
+    const auto& l = lods[std::min(lod, lods.size() - 1)];
+    va->draw(shader, l.index_count, l.first_index, l.base_vertex);
+}
+
 }
@@ -15,6 +15,8 @@
 #include "Eigen/Dense"
 
 #include "utils/tools.h"
+#include "utils/shader.h"
+#include "utils/mesh_data.h"
 #include "utils/gl/vertex_array.h"
 
 namespace Utils {
@@ -24,6 +26,15 @@ using GL::VertexBuffer;
 using GL::ElementBuffer;
 
 struct Model {
+    // One level of detail, a range of the model's buffers. error is how far (in model units)
+    // the level may deviate from the full resolution mesh.
+    struct Lod {
+        GLint base_vertex;
+        GLuint first_index;
+        GLsizei index_count;
+        float error;
+    };
+
     ~Model();
 
     std::unique_ptr<VertexArray> va = nullptr;
@@ -35,6 +46,15 @@ struct Model {
     std::vector<vecf3> normals;
     std::vector<vecf3> tangents;
     std::vector<veci3> indices;
+
+    // lods[0] is the full mesh, the vectors above only keep that one
+    std::vector<Lod> lods;
+
+    // Simplifies by ratio level after level until a level would have less than min_faces,
+    // then uploads every level once into the existing buffers. va->draw keeps drawing level 0.
+    void build_lods(float ratio, size_t min_faces, size_t max_levels);
+    void draw(const Shader& shader, size_t lod) const;
+    size_t face_count(size_t lod) const { return lods[lod].index_count / 3; }
     
     static Model *load(const std::string& path);
     // from mesh
@@ -0,0 +1,48 @@
+#include "normal_accumulator.h"
+
+namespace Utils {
+
+NormalAccumulator::NormalAccumulator(const std::vector<vecf3>& positions, const std::vector<veci3>& indices) {
+    reset(positions, indices);
+}
+
+void NormalAccumulator::reset(const std::vector<vecf3>& positions, const std::vector<veci3>& indices) {
+    sums.assign(positions.size(), vecf3::Zero());
+    for (const auto& idx : indices) {
+        const auto& p0 = positions[idx[0]];
+        auto normal = (positions[idx[1]] - p0).cross(positions[idx[2]] - p0);
+        sums[idx[0]] += normal;
+        sums[idx[1]] += normal;
+        sums[idx[2]] += normal;
+    }
+}
+
+void NormalAccumulator::add_face(const std::vector<vecf3>& positions, const veci3& face) {
+    accumulate(positions, face, 1.0f);
+}
+
+void NormalAccumulator::remove_face(const std::vector<vecf3>& positions, const veci3& face) {
+    accumulate(positions, face, -1.0f);
+}
+
+void NormalAccumulator::accumulate(const std::vector<vecf3>& positions, const veci3& face, float sign) {
+    const auto& p0 = positions[face[0]];
+    vecf3 normal = sign * (positions[face[1]] - p0).cross(positions[face[2]] - p0);
+    for (int i = 0; i < 3; ++i) {
+        sums[face[i]] += normal;
+    }
+}
+
+vecf3 NormalAccumulator::normal(int vertex) const {
+    return sums[vertex].normalized();
+}
+
+std::vector<vecf3> NormalAccumulator::normals() const {
+    std::vector<vecf3> normals(sums.size());
+    for (size_t i = 0; i < sums.size(); ++i) {
+        normals[i] = sums[i].normalized();
+    }
+    return normals;
+}
+
+}
@@ -0,0 +1,40 @@
+#ifndef UTILS_NORMAL_ACCUMULATOR_H
+#define UTILS_NORMAL_ACCUMULATOR_H
+
+#pragma once
+
+#include <vector>
+
+#include "Eigen/Dense"
+
+#include "utils/tools.h"
+
+namespace Utils {
+
+// Keeps the area-weighted face normal sums of every vertex, so that local edits
+// (edge collapses, vertex splits) only touch the vertices of the affected faces
+// instead of running generate_normals over the whole mesh again.
+class NormalAccumulator {
+public:
+    NormalAccumulator() = default;
+    NormalAccumulator(const std::vector<vecf3>& positions, const std::vector<veci3>& indices);
+
+    // Rebuilds all the sums from scratch
+    void reset(const std::vector<vecf3>& positions, const std::vector<veci3>& indices);
+
+    // The positions must be the same ones the face was added with when it is removed
+    void add_face(const std::vector<vecf3>& positions, const veci3& face);
+    void remove_face(const std::vector<vecf3>& positions, const veci3& face);
+
+    vecf3 normal(int vertex) const;
+    std::vector<vecf3> normals() const;
+
+private:
+    void accumulate(const std::vector<vecf3>& positions, const veci3& face, float sign);
+
+    std::vector<vecf3> sums;
+};
+
+}
+
+#endif // UTILS_NORMAL_ACCUMULATOR_H
@@ -0,0 +1,167 @@
+#include "procedural.h"
+
+#include <cmath>
+#include <algorithm>
+#include <unordered_map>
+
+namespace Utils::Procedural {
+
+static constexpr float PI = 3.14159265358979f;
+
+vecf3 Random::unit_vector() {
+    // uniform on the sphere from a uniform height and angle
+    float y = uniform(-1.0f, 1.0f);
+    float phi = uniform(0.0f, 2.0f * PI);
+    float r = std::sqrt(std::max(0.0f, 1.0f - y * y));
+    return vecf3(r * std::cos(phi), y, r * std::sin(phi));
+}
+
+MeshData sphere(size_t triangles) {
+    const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+    const vecf3 corners[12] = {
+        {-1.0f,  t, 0.0f}, {1.0f,  t, 0.0f}, {-1.0f, -t, 0.0f}, {1.0f, -t, 0.0f},
+        {0.0f, -1.0f,  t}, {0.0f, 1.0f,  t}, {0.0f, -1.0f, -t}, {0.0f, 1.0f, -t},
+        { t, 0.0f, -1.0f}, { t, 0.0f, 1.0f}, {-t, 0.0f, -1.0f}, {-t, 0.0f, 1.0f},
+    };
+    // counterclockwise seen from outside
+    const int faces[20][3] = {
+        {0, 11, 5}, {0, 5, 1}, {0, 1, 7}, {0, 7, 10}, {0, 10, 11},
+        {1, 5, 9}, {5, 11, 4}, {11, 10, 2}, {10, 7, 6}, {7, 1, 8},
+        {3, 9, 4}, {3, 4, 2}, {3, 2, 6}, {3, 6, 8}, {3, 8, 9},
+        {4, 9, 5}, {2, 4, 11}, {6, 2, 10}, {8, 6, 7}, {9, 8, 1},
+    };
+    auto f = static_cast<uint32_t>(std::max(1.0, std::round(std::sqrt(static_cast<double>(triangles) / 20.0))));
+
+    MeshData mesh;
+    // a point on the edge of two faces is keyed by its corners and its weight, a corner by itself
+    std::unordered_map<uint64_t, uint32_t> shared;
+    auto add_vertex = [&](const vecf3& p) {
+        vecf3 n = p.normalized();
+        mesh.positions.push_back(n);
+        mesh.normals.push_back(n);
+        mesh.texcoords.emplace_back(0.5f + std::atan2(n[2], n[0]) / (2.0f * PI), 0.5f + std::asin(n[1]) / PI);
+        return static_cast<uint32_t>(mesh.positions.size() - 1);
+    };
+    auto vertex = [&](const int *face, uint32_t wa, uint32_t wb, uint32_t wc) {
+        uint32_t weights[3] = {wa, wb, wc};
+        int ids[3] = {};
+        uint32_t ws[3];
+        int nonzero = 0;
+        for (int k = 0; k < 3; ++k) {
+            if (weights[k] > 0) {
+                ids[nonzero] = face[k];
+                ws[nonzero++] = weights[k];
+            }
+        }
+        auto point = [&] {
+            vecf3 p = vecf3::Zero();
+            for (int k = 0; k < nonzero; ++k) {
+                p += static_cast<float>(ws[k]) * corners[ids[k]];
+            }
+            return p;
+        };
+        if (nonzero == 3) {
+            return add_vertex(point());
+        }
+        uint64_t key = static_cast<uint64_t>(ids[0]);
+        if (nonzero == 2) {
+            if (ids[0] > ids[1]) {
+                std::swap(ids[0], ids[1]);
+                std::swap(ws[0], ws[1]);
+            }
+            key = 12 + (static_cast<uint64_t>(ids[0] * 12 + ids[1]) * (f + 1) + ws[1]);
+        }
+        auto it = shared.find(key);
+        if (it != shared.end()) {
+            return it->second;
+        }
+        auto index = add_vertex(point());
+        shared.emplace(key, index);
+        return index;
+    };
+
+    std::vector<uint32_t> rows;
+    for (const auto& face : faces) {
+        // the vertices of row r, parallel to the edge opposite to the first corner, at rows[r (r + 1) / 2 + s]
+        rows.clear();
+        for (uint32_t r = 0; r <= f; ++r) {
+            for (uint32_t s = 0; s <= r; ++s) {
+                rows.push_back(vertex(face, f - r, r - s, s));
+            }
+        }
+        auto at = [&](uint32_t r, uint32_t s) { return static_cast<int>(rows[r * (r + 1) / 2 + s]); };
+        for (uint32_t r = 0; r < f; ++r) {
+            for (uint32_t s = 0; s <= r; ++s) {
+                mesh.indices.emplace_back(at(r, s), at(r + 1, s), at(r + 1, s + 1));
+                if (s < r) {
+                    mesh.indices.emplace_back(at(r, s), at(r + 1, s + 1), at(r, s + 1));
+                }
+            }
+        }
+    }
+    return mesh;
+}
+
+// in [0, 1), the same for the same lattice point and seed
+static float lattice(int32_t x, int32_t z, uint32_t seed) {
+    uint32_t h = static_cast<uint32_t>(x) * 0x8da6b343u ^ static_cast<uint32_t>(z) * 0xd8163841u ^ seed * 0xcb1ab31fu;
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    h *= 0x297a2d39u;
+    h ^= h >> 15;
+    return static_cast<float>(h >> 8) * (1.0f / 16777216.0f);
+}
+
+static float value_noise(float x, float z, uint32_t seed) {
+    float fx = std::floor(x), fz = std::floor(z);
+    auto ix = static_cast<int32_t>(fx), iz = static_cast<int32_t>(fz);
+    float tx = x - fx, tz = z - fz;
+    // smoothstep, so the slopes and the normals are continuous across the cells
+    tx = tx * tx * (3.0f - 2.0f * tx);
+    tz = tz * tz * (3.0f - 2.0f * tz);
+    float a = lattice(ix, iz, seed), b = lattice(ix + 1, iz, seed);
+    float c = lattice(ix, iz + 1, seed), d = lattice(ix + 1, iz + 1, seed);
+    float bottom = a + (b - a) * tx, top = c + (d - c) * tx;
+    return bottom + (top - bottom) * tz;
+}
+
+MeshData terrain(size_t triangles, uint32_t seed, float height) {
+    constexpr int OCTAVES = 5;
+    auto quads = std::max<size_t>(triangles / 2, 1);
+    auto n = static_cast<uint32_t>(std::max(1.0, std::round(std::sqrt(static_cast<double>(quads)))));
+    auto m = static_cast<uint32_t>(std::max<size_t>(1, (quads + n / 2) / n));
+
+    MeshData mesh;
+    mesh.positions.reserve(static_cast<size_t>(n + 1) * (m + 1));
+    mesh.texcoords.reserve(mesh.positions.capacity());
+    for (uint32_t j = 0; j <= m; ++j) {
+        for (uint32_t i = 0; i <= n; ++i) {
+            float u = static_cast<float>(i) / static_cast<float>(n);
+            float v = static_cast<float>(j) / static_cast<float>(m);
+            float x = 2.0f * u - 1.0f, z = 2.0f * v - 1.0f;
+            float sum = 0.0f, amplitude = 1.0f, total = 0.0f, frequency = 2.0f;
+            for (int o = 0; o < OCTAVES; ++o) {
+                sum += amplitude * value_noise(x * frequency, z * frequency, seed + o);
+                total += amplitude;
+                amplitude *= 0.5f;
+                frequency *= 2.0f;
+            }
+            mesh.positions.emplace_back(x, height * (2.0f * sum / total - 1.0f), z);
+            mesh.texcoords.emplace_back(u, v);
+        }
+    }
+    mesh.indices.reserve(2 * static_cast<size_t>(n) * m);
+    auto at = [&](uint32_t i, uint32_t j) { return static_cast<int>(j * (n + 1) + i); };
+    for (uint32_t j = 0; j < m; ++j) {
+        for (uint32_t i = 0; i < n; ++i) {
+            // facing up
+            mesh.indices.emplace_back(at(i, j), at(i, j + 1), at(i + 1, j + 1));
+            mesh.indices.emplace_back(at(i, j), at(i + 1, j + 1), at(i + 1, j));
+        }
+    }
+    mesh.normals = generate_normals(mesh.positions, mesh.indices);
+    return mesh;
+}
+
+}
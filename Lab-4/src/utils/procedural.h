@@ -0,0 +1,51 @@
+#ifndef UTILS_PROCEDURAL_H
+#define UTILS_PROCEDURAL_H
+
+#pragma once
+
+#include <cstdint>
+
+#include "Eigen/Dense"
+
+#include "utils/tools.h"
+#include "utils/mesh_data.h"
+
+// Synthetic meshes of any size for the loaders, the simplifier and the stress scenes
+namespace Utils::Procedural {
+
+// PCG32, the same numbers for a seed on every platform and standard library, which the
+// std distributions don't promise
+class Random {
+public:
+    explicit Random(uint64_t seed) { next(); state += seed; next(); }
+
+    uint32_t next() {
+        uint64_t old = state;
+        state = old * 6364136223846793005ULL + 1442695040888963407ULL;
+        auto xorshifted = static_cast<uint32_t>(((old >> 18u) ^ old) >> 27u);
+        auto rot = static_cast<uint32_t>(old >> 59u);
+        return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+    }
+    // [lo, hi)
+    float uniform(float lo = 0.0f, float hi = 1.0f) {
+        return lo + (hi - lo) * static_cast<float>(next() >> 8) * (1.0f / 16777216.0f);
+    }
+    uint32_t below(uint32_t n) { return static_cast<uint32_t>((static_cast<uint64_t>(next()) * n) >> 32); }
+    vecf3 unit_vector();
+
+private:
+    uint64_t state = 0;
+};
+
+// A geodesic sphere of radius 1: every icosahedron face split into f * f triangles, f being
+// chosen so there are about as many triangles as asked (20 f^2). The vertices on the edges are
+// shared so the mesh is closed. Normals and spherical texcoords are set.
+MeshData sphere(size_t triangles);
+
+// A height field over [-1, 1] x [-1, 1] in xz, a grid of about triangles / 2 quads. The heights are
+// octaves of value noise from seed, up to height. Normals and texcoords are set.
+MeshData terrain(size_t triangles, uint32_t seed, float height = 0.25f);
+
+}
+
+#endif // UTILS_PROCEDURAL_H
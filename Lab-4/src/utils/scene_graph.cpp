@@ -0,0 +1,176 @@
+#include "scene_graph.h"
+
+#include <cassert>
+#include <algorithm>
+#include <type_traits>
+
+namespace Utils {
+
+SceneGraph::Node SceneGraph::add(Node parent, const vecf3& position, const Eigen::Quaternionf& rotation, const vecf3& scale) {
+    assert(parent == NONE || parent < index_of.size());
+    auto parent_index = parent == NONE ? NONE : index_of[parent];
+    auto index = static_cast<uint32_t>(parents.size());
+    // Appending keeps parents before children. It is still depth first when the parent is the last
+    // node or one of its ancestors, as when a hierarchy is built top down; their subtrees grow by one.
+    if (sorted && parent_index != NONE) {
+        auto i = index - 1;
+        while (i != NONE && i != parent_index) {
+            i = parents[i];
+        }
+        sorted = i == parent_index;
+        for (; sorted && i != NONE; i = parents[i]) {
+            subtree_ends[i] = index + 1;
+        }
+    }
+
+    auto node = static_cast<Node>(index_of.size());
+    index_of.push_back(index);
+    node_of.push_back(node);
+    parents.push_back(parent_index);
+    subtree_ends.push_back(index + 1);
+    positions.push_back(position);
+    rotations.push_back(rotation);
+    scales.push_back(scale);
+    locals.emplace_back();
+    worlds.emplace_back();
+    local_dirty.push_back(0);
+    mark(index);
+    return node;
+}
+
+void SceneGraph::mark(uint32_t index) {
+    if (!local_dirty[index]) {
+        local_dirty[index] = 1;
+        dirty.push_back(index);
+    }
+}
+
+void SceneGraph::set_position(Node node, const vecf3& position) {
+    positions[index_of[node]] = position;
+    mark(index_of[node]);
+}
+
+void SceneGraph::set_rotation(Node node, const Eigen::Quaternionf& rotation) {
+    rotations[index_of[node]] = rotation;
+    mark(index_of[node]);
+}
+
+void SceneGraph::set_scale(Node node, const vecf3& scale) {
+    scales[index_of[node]] = scale;
+    mark(index_of[node]);
+}
+
+SceneGraph::Node SceneGraph::parent(Node node) const {
+    auto p = parents[index_of[node]];
+    return p == NONE ? NONE : node_of[p];
+}
+
+size_t SceneGraph::update() {
+    if (!sorted) {
+        sort();
+    }
+    updates = 0;
+    // in order, a change inside a subtree swept already is done with it
+    std::sort(dirty.begin(), dirty.end());
+    uint32_t swept = 0;
+    for (auto first : dirty) {
+        if (first < swept) {
+            continue;
+        }
+        swept = subtree_ends[first];
+        for (auto i = first; i < swept; ++i) {
+            if (local_dirty[i]) {
+                // T R S
+                locals[i] = Affine(rotations[i].toRotationMatrix() * scales[i].asDiagonal(), positions[i]);
+                local_dirty[i] = 0;
+            }
+            auto p = parents[i];
+            worlds[i] = p == NONE ? locals[i] : worlds[p] * locals[i];
+        }
+        updates += swept - first;
+    }
+    dirty.clear();
+    return updates;
+}
+
+void SceneGraph::sort() {
+    auto n = static_cast<uint32_t>(parents.size());
+    // children of each node as ranges of one array, in the order they were added
+    std::vector<uint32_t> child_begin(n + 1, 0);
+    for (auto p : parents) {
+        if (p != NONE) {
+            child_begin[p + 1]++;
+        }
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        child_begin[i + 1] += child_begin[i];
+    }
+    std::vector<uint32_t> children(child_begin[n]);
+    std::vector<uint32_t> fill(child_begin.begin(), child_begin.end() - 1);
+    for (uint32_t i = 0; i < n; ++i) {
+        if (parents[i] != NONE) {
+            children[fill[parents[i]]++] = i;
+        }
+    }
+
+    std::vector<uint32_t> order;
+    order.reserve(n);
+    std::vector<uint32_t> stack;
+    for (uint32_t root = 0; root < n; ++root) {
+        if (parents[root] != NONE) {
+            continue;
+        }
+        stack.push_back(root);
+        while (!stack.empty()) {
+            auto i = stack.back();
+            stack.pop_back();
+            order.push_back(i);
+            // reversed, so the first child is visited first
+            for (auto c = child_begin[i + 1]; c > child_begin[i]; --c) {
+                stack.push_back(children[c - 1]);
+            }
+        }
+    }
+
+    std::vector<uint32_t> new_index(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        new_index[order[i]] = i;
+    }
+    auto permute = [&](auto& values) {
+        std::remove_reference_t<decltype(values)> sorted_values;
+        sorted_values.reserve(n);
+        for (auto i : order) {
+            sorted_values.push_back(values[i]);
+        }
+        values.swap(sorted_values);
+    };
+    permute(parents);
+    for (auto& p : parents) {
+        p = p == NONE ? NONE : new_index[p];
+    }
+    permute(positions);
+    permute(rotations);
+    permute(scales);
+    permute(locals);
+    permute(worlds);
+    permute(local_dirty);
+    permute(node_of);
+    for (uint32_t i = 0; i < n; ++i) {
+        index_of[node_of[i]] = i;
+    }
+    for (auto& i : dirty) {
+        i = new_index[i];
+    }
+    // children come after their parents, so a reverse sweep sees every subtree complete
+    for (uint32_t i = 0; i < n; ++i) {
+        subtree_ends[i] = i + 1;
+    }
+    for (auto i = n; i-- > 0; ) {
+        if (parents[i] != NONE) {
+            subtree_ends[parents[i]] = std::max(subtree_ends[parents[i]], subtree_ends[i]);
+        }
+    }
+    sorted = true;
+}
+
+} // namespace Utils
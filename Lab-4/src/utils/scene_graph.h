@@ -0,0 +1,71 @@
+#ifndef UTILS_SCENE_GRAPH_H
+#define UTILS_SCENE_GRAPH_H
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "Eigen/Dense"
+#include "Eigen/Geometry"
+
+#include "utils/tools.h"
+#include "utils/affine.h"
+
+namespace Utils {
+
+// Nodes with a local translation, rotation and scale under an optional parent. update() recomputes
+// the cached world transforms of the nodes changed since the last update and of their descendants,
+// nothing else. The nodes are kept in flat arrays sorted depth first: a subtree is a contiguous
+// range that starts with its root, so each change is one forward sweep over its range. Adding nodes
+// out of that order sorts them again on the next update; node ids stay valid across the sorts.
+class SceneGraph {
+public:
+    using Node = uint32_t;
+    static constexpr Node NONE = UINT32_MAX;
+
+    Node add(Node parent = NONE, const vecf3& position = vecf3::Zero(),
+             const Eigen::Quaternionf& rotation = Eigen::Quaternionf::Identity(), const vecf3& scale = vecf3::Ones());
+
+    void set_position(Node node, const vecf3& position);
+    void set_rotation(Node node, const Eigen::Quaternionf& rotation);
+    void set_scale(Node node, const vecf3& scale);
+
+    const vecf3& position(Node node) const { return positions[index_of[node]]; }
+    const Eigen::Quaternionf& rotation(Node node) const { return rotations[index_of[node]]; }
+    const vecf3& scale(Node node) const { return scales[index_of[node]]; }
+    Node parent(Node node) const;
+    // as of the last update()
+    const Affine& world(Node node) const { return worlds[index_of[node]]; }
+
+    // returns the number of world transforms recomputed
+    size_t update();
+
+    size_t size() const { return parents.size(); }
+    size_t last_updates() const { return updates; }
+
+private:
+    void mark(uint32_t index);
+    void sort();
+
+    // in depth first order, parents holds array indices and subtree_ends one past the last descendant
+    std::vector<uint32_t> parents;
+    std::vector<uint32_t> subtree_ends;
+    std::vector<vecf3> positions;
+    std::vector<Eigen::Quaternionf> rotations;
+    std::vector<vecf3> scales;
+    std::vector<Affine> locals;
+    std::vector<Affine> worlds;
+    // the local transform changed, those nodes are listed in dirty
+    std::vector<uint8_t> local_dirty;
+    std::vector<uint32_t> dirty;
+    // node id to array index and back
+    std::vector<uint32_t> index_of;
+    std::vector<Node> node_of;
+    bool sorted = true;
+    size_t updates = 0;
+};
+
+}
+
+#endif // UTILS_SCENE_GRAPH_H
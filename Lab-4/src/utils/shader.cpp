@@ -163,6 +163,11 @@ void Shader::set_matf4(const GLchar* name, const matf4& mat) const {
     glUniformMatrix4fv(glGetUniformLocation(id, name), 1, GL_FALSE, mat.data());
 }
 
+void Shader::set_affine(const GLchar* name, const Affine& affine) const {
+    use_program();
+    glUniform4fv(glGetUniformLocation(id, name), 3, affine.data());
+}
+
 void Shader::set_tex(const GLchar *name, size_t v) {
     set_int(name, static_cast<GLint>(v));
 }
@@ -12,6 +12,7 @@
 #include "Eigen/Dense"
 #include "glad/glad.h"
 #include "utils/tools.h"
+#include "utils/affine.h"
 
 #include "utils/gl/texture.h"
 
@@ -51,6 +52,8 @@ public:
     void set_vecf4s(const GLchar* name, GLuint n, const GLfloat* data) const;
 
     void set_matf4(const GLchar* name, const matf4& mat) const;
+    // a vec4[3] uniform, the rows of the transform
+    void set_affine(const GLchar* name, const Affine& affine) const;
 
     void set_tex(const GLchar *name, size_t v);
 };
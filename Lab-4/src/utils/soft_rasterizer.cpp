@@ -0,0 +1,359 @@
+#include "soft_rasterizer.h"
+
+#include <cmath>
+#include <array>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+namespace Utils {
+
+static constexpr int32_t SUBPIXEL = 1 << SoftRasterizer::SUBPIXEL_BITS;
+// the x and y clip planes are pushed out this far, the fixed point coordinates still fit
+// and only triangles crossing it (very rare) are really clipped, the rest is cut by the tiles
+static constexpr float GUARD_BAND = 4.0f;
+static constexpr int CLIP_PLANES = 6;
+static constexpr size_t VERTEX_BATCH = 4096;
+
+vecf3 SoftTexture::sample(const vecf2& uv) const {
+    if (data.empty()) {
+        return vecf3::Ones();
+    }
+    auto x = static_cast<int>(std::floor(uv[0] * static_cast<float>(width))) % width;
+    auto y = static_cast<int>(std::floor(uv[1] * static_cast<float>(height))) % height;
+    x = x < 0 ? x + width : x;
+    y = y < 0 ? y + height : y;
+    const uint8_t *texel = data.data() + (static_cast<size_t>(y) * width + x) * channels;
+    if (channels < 3) {
+        return vecf3::Constant(texel[0] / 255.0f);
+    }
+    return vecf3(texel[0], texel[1], texel[2]) / 255.0f;
+}
+
+SoftRasterizer::SoftRasterizer(ThreadPool& pool, int width, int height) : pool(pool) {
+    resize(width, height);
+}
+
+void SoftRasterizer::resize(int width, int height) {
+    fb_width = std::max(width, 1);
+    fb_height = std::max(height, 1);
+    tiles_x = (fb_width + TILE_SIZE - 1) / TILE_SIZE;
+    tiles_y = (fb_height + TILE_SIZE - 1) / TILE_SIZE;
+    color.assign(static_cast<size_t>(fb_width) * fb_height * 3, 0);
+    depth.assign(static_cast<size_t>(fb_width) * fb_height, 1.0f);
+    chunks.clear();
+    chunk_num = 0;
+}
+
+void SoftRasterizer::set_camera(const matf4& view, const matf4& projection, const vecf3& position) {
+    view_projection = projection * view;
+    camera_pos = position;
+}
+
+void SoftRasterizer::clear(const vecf3& clear_color) {
+    uint8_t rgb[3];
+    for (int i = 0; i < 3; ++i) {
+        rgb[i] = static_cast<uint8_t>(std::clamp(clear_color[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+    for (size_t i = 0; i < color.size(); i += 3) {
+        color[i] = rgb[0];
+        color[i + 1] = rgb[1];
+        color[i + 2] = rgb[2];
+    }
+    std::fill(depth.begin(), depth.end(), 1.0f);
+    chunk_num = 0;
+    materials.clear();
+    triangles_binned = 0;
+}
+
+void SoftRasterizer::draw(const MeshData& mesh, const matf4& model, const SoftMaterial& material) {
+    if (mesh.empty()) {
+        return;
+    }
+    std::vector<vecf3> generated;
+    const auto& normals = mesh.normals.size() == mesh.positions.size()
+                          ? mesh.normals
+                          : (generated = generate_normals(mesh.positions, mesh.indices));
+    bool has_uv = mesh.texcoords.size() == mesh.positions.size();
+    matf3 normal_matrix = model.topLeftCorner<3, 3>().inverse().transpose();
+    matf4 mvp = view_projection * model;
+
+    // vertex stage
+    vertices.resize(mesh.vertex_count());
+    size_t vertex_batches = (vertices.size() + VERTEX_BATCH - 1) / VERTEX_BATCH;
+    pool.run(vertex_batches, [&](size_t batch, size_t) {
+        auto end = std::min(vertices.size(), (batch + 1) * VERTEX_BATCH);
+        for (size_t i = batch * VERTEX_BATCH; i < end; ++i) {
+            vecf4 pos(mesh.positions[i][0], mesh.positions[i][1], mesh.positions[i][2], 1.0f);
+            vecf4 world = model * pos;
+            auto& v = vertices[i];
+            v.clip = mvp * pos;
+            v.world = world.head<3>() / world[3];
+            v.normal = normal_matrix * normals[i];
+            v.uv = has_uv ? mesh.texcoords[i] : vecf2::Zero();
+        }
+    });
+
+    // clipping, setup and binning, one chunk of faces per task
+    materials.push_back(material);
+    const SoftMaterial *mat = &materials.back();
+    size_t face_chunks = (mesh.face_count() + CHUNK_FACES - 1) / CHUNK_FACES;
+    size_t first_chunk = chunk_num;
+    chunk_num += face_chunks;
+    if (chunks.size() < chunk_num) {
+        chunks.resize(chunk_num);
+    }
+    auto tile_num = static_cast<size_t>(tiles_x * tiles_y);
+    pool.run(face_chunks, [&](size_t task, size_t) {
+        auto& chunk = chunks[first_chunk + task];
+        chunk.triangles.clear();
+        chunk.bins.resize(tile_num);
+        for (auto& bin : chunk.bins) {
+            bin.clear();
+        }
+        auto end = std::min(mesh.face_count(), (task + 1) * CHUNK_FACES);
+        for (size_t f = task * CHUNK_FACES; f < end; ++f) {
+            const auto& face = mesh.indices[f];
+            setup_face(vertices[face[0]], vertices[face[1]], vertices[face[2]], mat, chunk);
+        }
+    });
+    for (size_t i = first_chunk; i < chunk_num; ++i) {
+        triangles_binned += chunks[i].triangles.size();
+    }
+}
+
+static float plane_distance(const vecf4& clip, int plane) {
+    switch (plane) {
+        case 0: return clip[3] + clip[2];               // near
+        case 1: return clip[3] - clip[2];               // far
+        case 2: return GUARD_BAND * clip[3] + clip[0];  // left
+        case 3: return GUARD_BAND * clip[3] - clip[0];  // right
+        case 4: return GUARD_BAND * clip[3] + clip[1];  // bottom
+        default: return GUARD_BAND * clip[3] - clip[1]; // top
+    }
+}
+
+void SoftRasterizer::setup_face(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c,
+                                const SoftMaterial *material, Chunk& chunk) const {
+    uint32_t outside_a = 0, outside_b = 0, outside_c = 0;
+    for (int p = 0; p < CLIP_PLANES; ++p) {
+        outside_a |= (plane_distance(a.clip, p) < 0.0f) << p;
+        outside_b |= (plane_distance(b.clip, p) < 0.0f) << p;
+        outside_c |= (plane_distance(c.clip, p) < 0.0f) << p;
+    }
+    if (outside_a & outside_b & outside_c) {
+        return;
+    }
+    if ((outside_a | outside_b | outside_c) == 0) {
+        emit(a, b, c, material, chunk);
+        return;
+    }
+
+    // Sutherland-Hodgman against the planes the triangle crosses, then a fan
+    std::array<ClipVertex, 3 + CLIP_PLANES> poly_a, poly_b;
+    auto *in = &poly_a, *out = &poly_b;
+    size_t in_num = 3;
+    poly_a[0] = a;
+    poly_a[1] = b;
+    poly_a[2] = c;
+    uint32_t crossed = outside_a | outside_b | outside_c;
+    for (int p = 0; p < CLIP_PLANES && in_num >= 3; ++p) {
+        if (!(crossed & (1u << p))) {
+            continue;
+        }
+        size_t out_num = 0;
+        for (size_t i = 0; i < in_num; ++i) {
+            const auto& cur = (*in)[i];
+            const auto& nxt = (*in)[(i + 1) % in_num];
+            float d_cur = plane_distance(cur.clip, p);
+            float d_nxt = plane_distance(nxt.clip, p);
+            if (d_cur >= 0.0f) {
+                (*out)[out_num++] = cur;
+            }
+            if ((d_cur >= 0.0f) != (d_nxt >= 0.0f)) {
+                float t = d_cur / (d_cur - d_nxt);
+                auto& v = (*out)[out_num++];
+                v.clip = cur.clip + t * (nxt.clip - cur.clip);
+                v.world = cur.world + t * (nxt.world - cur.world);
+                v.normal = cur.normal + t * (nxt.normal - cur.normal);
+                v.uv = cur.uv + t * (nxt.uv - cur.uv);
+            }
+        }
+        std::swap(in, out);
+        in_num = out_num;
+    }
+    for (size_t i = 2; i < in_num; ++i) {
+        emit((*in)[0], (*in)[i - 1], (*in)[i], material, chunk);
+    }
+}
+
+void SoftRasterizer::emit(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c,
+                          const SoftMaterial *material, Chunk& chunk) const {
+    const ClipVertex *v[3] = {&a, &b, &c};
+    Triangle tri;
+    for (int i = 0; i < 3; ++i) {
+        const auto& clip = v[i]->clip;
+        float inv_w = 1.0f / clip[3];
+        // y goes down in the image
+        float sx = (clip[0] * inv_w * 0.5f + 0.5f) * static_cast<float>(fb_width);
+        float sy = (0.5f - clip[1] * inv_w * 0.5f) * static_cast<float>(fb_height);
+        tri.x[i] = static_cast<int32_t>(std::lround(sx * SUBPIXEL));
+        tri.y[i] = static_cast<int32_t>(std::lround(sy * SUBPIXEL));
+        tri.z[i] = clip[2] * inv_w * 0.5f + 0.5f;
+        tri.inv_w[i] = inv_w;
+        tri.world[i] = v[i]->world * inv_w;
+        tri.normal[i] = v[i]->normal * inv_w;
+        tri.uv[i] = v[i]->uv * inv_w;
+    }
+
+    // counter-clockwise (GL front faces) is negative once y is flipped
+    auto area = static_cast<int64_t>(tri.x[1] - tri.x[0]) * (tri.y[2] - tri.y[0])
+              - static_cast<int64_t>(tri.y[1] - tri.y[0]) * (tri.x[2] - tri.x[0]);
+    if (area == 0 || (cull_back_faces && area > 0)) {
+        return;
+    }
+    if (area < 0) {
+        std::swap(tri.x[1], tri.x[2]);
+        std::swap(tri.y[1], tri.y[2]);
+        std::swap(tri.z[1], tri.z[2]);
+        std::swap(tri.inv_w[1], tri.inv_w[2]);
+        std::swap(tri.world[1], tri.world[2]);
+        std::swap(tri.normal[1], tri.normal[2]);
+        std::swap(tri.uv[1], tri.uv[2]);
+        area = -area;
+    }
+    tri.inv_area = 1.0f / static_cast<float>(area);
+
+    tri.min_x = std::max(std::min({tri.x[0], tri.x[1], tri.x[2]}) >> SUBPIXEL_BITS, 0);
+    tri.min_y = std::max(std::min({tri.y[0], tri.y[1], tri.y[2]}) >> SUBPIXEL_BITS, 0);
+    tri.max_x = std::min(std::max({tri.x[0], tri.x[1], tri.x[2]}) >> SUBPIXEL_BITS, fb_width - 1);
+    tri.max_y = std::min(std::max({tri.y[0], tri.y[1], tri.y[2]}) >> SUBPIXEL_BITS, fb_height - 1);
+    if (tri.min_x > tri.max_x || tri.min_y > tri.max_y) {
+        return;
+    }
+    tri.material = material;
+
+    auto idx = static_cast<uint32_t>(chunk.triangles.size());
+    chunk.triangles.push_back(tri);
+    for (int ty = tri.min_y / TILE_SIZE; ty <= tri.max_y / TILE_SIZE; ++ty) {
+        for (int tx = tri.min_x / TILE_SIZE; tx <= tri.max_x / TILE_SIZE; ++tx) {
+            chunk.bins[ty * tiles_x + tx].push_back(idx);
+        }
+    }
+}
+
+void SoftRasterizer::flush() {
+    pool.run(static_cast<size_t>(tiles_x * tiles_y), [this](size_t tile, size_t) {
+        raster_tile(tile);
+    });
+    chunk_num = 0;
+}
+
+void SoftRasterizer::raster_tile(size_t tile) {
+    int x0 = static_cast<int>(tile % tiles_x) * TILE_SIZE;
+    int y0 = static_cast<int>(tile / tiles_x) * TILE_SIZE;
+    int x1 = std::min(x0 + TILE_SIZE, fb_width);
+    int y1 = std::min(y0 + TILE_SIZE, fb_height);
+    // submission order, so equal depths resolve the same way for any thread count
+    for (size_t c = 0; c < chunk_num; ++c) {
+        const auto& chunk = chunks[c];
+        for (auto idx : chunk.bins[tile]) {
+            raster_triangle(chunk.triangles[idx], x0, y0, x1, y1);
+        }
+    }
+}
+
+void SoftRasterizer::raster_triangle(const Triangle& tri, int tile_x0, int tile_y0, int tile_x1, int tile_y1) {
+    int min_x = std::max(tri.min_x, tile_x0);
+    int min_y = std::max(tri.min_y, tile_y0);
+    int max_x = std::min(tri.max_x, tile_x1 - 1);
+    int max_y = std::min(tri.max_y, tile_y1 - 1);
+    if (min_x > max_x || min_y > max_y) {
+        return;
+    }
+
+    // edge k is opposite to vertex k, e(p) = dx * (p.y - a.y) - dy * (p.x - a.x) is positive inside.
+    // Pixels exactly on an edge belong to it only if it is a top or a left edge, the others are
+    // biased by one so that the test is a plain sign check.
+    int64_t row[3], step_x[3], step_y[3];
+    int64_t px = static_cast<int64_t>(min_x) * SUBPIXEL + SUBPIXEL / 2;
+    int64_t py = static_cast<int64_t>(min_y) * SUBPIXEL + SUBPIXEL / 2;
+    for (int k = 0; k < 3; ++k) {
+        int a = (k + 1) % 3;
+        int b = (k + 2) % 3;
+        int64_t dx = tri.x[b] - tri.x[a];
+        int64_t dy = tri.y[b] - tri.y[a];
+        bool top_left = dy < 0 || (dy == 0 && dx > 0);
+        row[k] = dx * (py - tri.y[a]) - dy * (px - tri.x[a]) - (top_left ? 0 : 1);
+        step_x[k] = -dy * SUBPIXEL;
+        step_y[k] = dx * SUBPIXEL;
+    }
+
+    for (int y = min_y; y <= max_y; ++y) {
+        int64_t e0 = row[0], e1 = row[1], e2 = row[2];
+        auto pixel = static_cast<size_t>(y) * fb_width + min_x;
+        for (int x = min_x; x <= max_x; ++x, ++pixel, e0 += step_x[0], e1 += step_x[1], e2 += step_x[2]) {
+            if ((e0 | e1 | e2) < 0) {
+                continue;
+            }
+            // the bias is off by at most one subpixel area, well below float precision here
+            float l0 = static_cast<float>(e0) * tri.inv_area;
+            float l1 = static_cast<float>(e1) * tri.inv_area;
+            float l2 = 1.0f - l0 - l1;
+            float z = l0 * tri.z[0] + l1 * tri.z[1] + l2 * tri.z[2];
+            if (!(z < depth[pixel])) {
+                continue;
+            }
+            depth[pixel] = z;
+
+            float w = 1.0f / (l0 * tri.inv_w[0] + l1 * tri.inv_w[1] + l2 * tri.inv_w[2]);
+            vecf3 world = (l0 * tri.world[0] + l1 * tri.world[1] + l2 * tri.world[2]) * w;
+            vecf3 normal = (l0 * tri.normal[0] + l1 * tri.normal[1] + l2 * tri.normal[2]) * w;
+            vecf2 uv = (l0 * tri.uv[0] + l1 * tri.uv[1] + l2 * tri.uv[2]) * w;
+            vecf3 rgb = shade(*tri.material, world, normal, uv);
+            for (int i = 0; i < 3; ++i) {
+                color[pixel * 3 + i] = static_cast<uint8_t>(std::clamp(rgb[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+            }
+        }
+        for (int k = 0; k < 3; ++k) {
+            row[k] += step_y[k];
+        }
+    }
+}
+
+vecf3 SoftRasterizer::shade(const SoftMaterial& material, const vecf3& world, const vecf3& normal, const vecf2& uv) const {
+    vecf3 albedo = material.albedo != nullptr ? material.albedo->sample(uv) : material.color;
+
+    if (lights.empty()) {
+        return vecf3::Zero();
+    }
+
+    // Blinn-Phong with the point lights falling off with the squared distance
+    vecf3 n = normal.normalized();
+    vecf3 v = (camera_pos - world).normalized();
+    vecf3 lit = vecf3::Zero();
+    for (const auto& light : lights) {
+        vecf3 to_light = light.position - world;
+        float dist2 = std::max(to_light.squaredNorm(), 1e-6f);
+        vecf3 l = to_light / std::sqrt(dist2);
+        vecf3 h = (l + v).normalized();
+        float diffuse = std::max(n.dot(l), 0.0f);
+        float spec = diffuse > 0.0f ? light.specular * std::pow(std::max(n.dot(h), 0.0f), 32.0f) : 0.0f;
+        vecf3 radiance = light.radiance / dist2;
+        lit += (albedo * diffuse + vecf3::Constant(spec)).cwiseProduct(radiance);
+    }
+    return albedo * lights[0].ambient + lit;
+}
+
+bool SoftRasterizer::save_ppm(const std::string& path) const {
+    std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "[E] Failed to open file: " << path << std::endl;
+        return false;
+    }
+    file << "P6\n" << fb_width << " " << fb_height << "\n255\n";
+    file.write(reinterpret_cast<const char *>(color.data()), static_cast<std::streamsize>(color.size()));
+    return static_cast<bool>(file);
+}
+
+}
@@ -0,0 +1,131 @@
+#ifndef UTILS_SOFT_RASTERIZER_H
+#define UTILS_SOFT_RASTERIZER_H
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <cstdint>
+
+#include "Eigen/Dense"
+
+#include "utils/tools.h"
+#include "utils/mesh_data.h"
+#include "utils/thread_pool.h"
+
+namespace Utils {
+
+// 8 bit texture for the software path, rows from bottom to top like the GL textures
+// (load it with stbi_set_flip_vertically_on_load(true)). Nearest sampling, repeat wrapping.
+struct SoftTexture {
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    std::vector<uint8_t> data;
+
+    vecf3 sample(const vecf2& uv) const;
+};
+
+struct SoftMaterial {
+    const SoftTexture *albedo = nullptr; // color is used without a texture
+    vecf3 color = vecf3::Ones();
+};
+
+struct SoftLight {
+    vecf3 position = vecf3::Zero();
+    vecf3 radiance = vecf3::Ones();
+    float ambient = 0.2f;
+    float specular = 0.8f;
+};
+
+// CPU triangle pipeline for hosts without a GPU. draw() transforms the vertices, clips the
+// triangles in clip space and bins them into screen tiles; flush() then rasterizes the tiles
+// in parallel, each tile being owned by one worker so no pixel is shared between threads.
+// Coverage uses fixed point edge functions with the top-left fill rule (the same pixels as GL),
+// depth is tested with GL_LESS and attributes are interpolated perspective correctly.
+// Triangles are binned in fixed size chunks of faces, so the image doesn't depend on the thread count.
+class SoftRasterizer {
+public:
+    static constexpr int TILE_SIZE = 64;
+    static constexpr int SUBPIXEL_BITS = 4;
+    static constexpr size_t CHUNK_FACES = 2048;
+
+    SoftRasterizer(ThreadPool& pool, int width, int height);
+
+    void resize(int width, int height);
+    int width() const noexcept { return fb_width; }
+    int height() const noexcept { return fb_height; }
+
+    void set_camera(const matf4& view, const matf4& projection, const vecf3& position);
+    void set_light(const SoftLight& light) { lights.assign(1, light); }
+    // the lights add up, the ambient term is the first one's
+    void set_lights(const std::vector<SoftLight>& lights) { this->lights = lights; }
+    bool cull_back_faces = true;
+
+    void clear(const vecf3& color);
+    // Missing normals are generated. The mesh may be released once this returns, the material is copied.
+    void draw(const MeshData& mesh, const matf4& model, const SoftMaterial& material);
+    void flush();
+
+    // triangles binned since the last clear, after clipping and culling
+    size_t triangle_count() const noexcept { return triangles_binned; }
+
+    // RGB8, rows from top to bottom
+    const std::vector<uint8_t>& color_buffer() const noexcept { return color; }
+    bool save_ppm(const std::string& path) const;
+
+private:
+    struct ClipVertex {
+        vecf4 clip;
+        vecf3 world;
+        vecf3 normal;
+        vecf2 uv;
+    };
+
+    struct Triangle {
+        int32_t x[3], y[3];     // screen position in fixed point
+        float z[3];             // window depth in [0, 1]
+        float inv_w[3];
+        vecf3 world[3];         // the attributes are divided by w
+        vecf3 normal[3];
+        vecf2 uv[3];
+        float inv_area;
+        int min_x, min_y, max_x, max_y;
+        const SoftMaterial *material;
+    };
+
+    struct Chunk {
+        std::vector<Triangle> triangles;
+        std::vector<std::vector<uint32_t>> bins; // triangle indices per tile
+    };
+
+    void setup_face(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c, const SoftMaterial *material, Chunk& chunk) const;
+    void emit(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c, const SoftMaterial *material, Chunk& chunk) const;
+    void raster_tile(size_t tile);
+    void raster_triangle(const Triangle& tri, int tile_x0, int tile_y0, int tile_x1, int tile_y1);
+    vecf3 shade(const SoftMaterial& material, const vecf3& world, const vecf3& normal, const vecf2& uv) const;
+
+    ThreadPool& pool;
+
+    int fb_width = 0;
+    int fb_height = 0;
+    int tiles_x = 0;
+    int tiles_y = 0;
+    std::vector<uint8_t> color;
+    std::vector<float> depth;
+
+    matf4 view_projection = matf4::Identity();
+    vecf3 camera_pos = vecf3::Zero();
+    std::vector<SoftLight> lights = std::vector<SoftLight>(1);
+
+    std::vector<ClipVertex> vertices;
+    std::vector<Chunk> chunks; // kept between frames to reuse their memory
+    size_t chunk_num = 0;
+    std::deque<SoftMaterial> materials;
+    size_t triangles_binned = 0;
+};
+
+}
+
+#endif // UTILS_SOFT_RASTERIZER_H
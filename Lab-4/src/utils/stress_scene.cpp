@@ -0,0 +1,121 @@
+#include "stress_scene.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include "utils/procedural.h"
+
+namespace Utils {
+
+static constexpr size_t CLUSTER_SIZE = 500;
+
+StressScene::StressScene(const Options& options) : options(options) {
+    Procedural::Random random(options.seed);
+    float extent = options.extent;
+
+    auto mesh_count = std::max<size_t>(options.meshes, 1);
+    for (size_t m = 0; m < mesh_count; ++m) {
+        meshes.push_back(m % 2 == 0 ? Procedural::sphere(options.triangles)
+                                    : Procedural::terrain(options.triangles, options.seed + static_cast<uint32_t>(m)));
+        colors.emplace_back(random.uniform(0.3f, 1.0f), random.uniform(0.3f, 1.0f), random.uniform(0.3f, 1.0f));
+        instances.add_model(meshes.back().positions);
+    }
+
+    auto n = options.instances;
+    std::vector<vecf3> centers;
+    for (size_t c = 0; c < std::max<size_t>(n / CLUSTER_SIZE, 1); ++c) {
+        centers.emplace_back(random.uniform(-extent, extent), random.uniform(0.0f, 0.2f * extent), random.uniform(-extent, extent));
+    }
+    auto side = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(n))));
+    float spacing = 2.0f * extent / static_cast<float>(std::max<size_t>(side, 1));
+    // about a normal distribution
+    auto spread = [&] { return random.uniform(-1.0f, 1.0f) + random.uniform(-1.0f, 1.0f) + random.uniform(-1.0f, 1.0f); };
+
+    for (size_t i = 0; i < n; ++i) {
+        vecf3 position;
+        switch (options.distribution) {
+        case Distribution::UNIFORM:
+            position = vecf3(random.uniform(-extent, extent), random.uniform(0.0f, 0.2f * extent), random.uniform(-extent, extent));
+            break;
+        case Distribution::CLUSTERED:
+            position = centers[random.below(static_cast<uint32_t>(centers.size()))] + 0.05f * extent * vecf3(spread(), spread(), spread());
+            break;
+        case Distribution::GRID:
+            position = vecf3(-extent + (static_cast<float>(i % side) + 0.5f) * spacing, 0.0f,
+                             -extent + (static_cast<float>(i / side) + 0.5f) * spacing);
+            break;
+        }
+        vecf3 axis = random.unit_vector();
+        float spin = random.uniform(0.0f, 6.2831853f);
+        home_x.push_back(position[0]);
+        home_z.push_back(position[2]);
+        orbits.push_back(options.motion == Motion::ORBIT ? random.uniform(0.5f, 3.0f) : 0.0f);
+        phases.push_back(random.uniform(0.0f, 6.2831853f));
+        axis_x.push_back(axis[0]);
+        axis_y.push_back(axis[1]);
+        axis_z.push_back(axis[2]);
+        spins.push_back(spin);
+        spin_speeds.push_back(random.uniform(-1.0f, 1.0f));
+        auto model = random.below(static_cast<uint32_t>(mesh_count));
+        instances.add(model, position, Eigen::Quaternionf(Eigen::AngleAxisf(spin, axis)), random.uniform(0.5f, 1.5f));
+    }
+
+    // the same total power for any count, about as bright as the cow scene's light a quarter of the extent away
+    for (size_t l = 0; l < options.lights; ++l) {
+        vecf3 color(random.uniform(0.6f, 1.0f), random.uniform(0.6f, 1.0f), random.uniform(0.6f, 1.0f));
+        lights.push_back({vecf3(random.uniform(-extent, extent), random.uniform(0.25f, 0.5f) * extent, random.uniform(-extent, extent)),
+                          color * (extent * extent / (8.0f * static_cast<float>(options.lights)))});
+    }
+}
+
+void StressScene::animate(ThreadPool& pool, float time) {
+    if (options.motion == Motion::STATIC) {
+        return;
+    }
+    bool orbiting = options.motion == Motion::ORBIT;
+    instances.run(pool, [&](size_t begin, size_t end) {
+        auto x = instances.x(), z = instances.z();
+        auto qx = instances.qx(), qy = instances.qy(), qz = instances.qz(), qw = instances.qw();
+        for (size_t i = begin; i < end; ++i) {
+            float half = 0.5f * (spins[i] + spin_speeds[i] * time);
+            float s = std::sin(half);
+            qx[i] = axis_x[i] * s;
+            qy[i] = axis_y[i] * s;
+            qz[i] = axis_z[i] * s;
+            qw[i] = std::cos(half);
+            if (orbiting) {
+                float angle = phases[i] + 0.2f * time;
+                x[i] = home_x[i] + orbits[i] * std::cos(angle);
+                z[i] = home_z[i] + orbits[i] * std::sin(angle);
+            }
+        }
+    });
+}
+
+bool StressScene::parse(const std::string& name, Distribution& distribution) {
+    if (name == "uniform") {
+        distribution = Distribution::UNIFORM;
+    } else if (name == "clustered") {
+        distribution = Distribution::CLUSTERED;
+    } else if (name == "grid") {
+        distribution = Distribution::GRID;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool StressScene::parse(const std::string& name, Motion& motion) {
+    if (name == "static") {
+        motion = Motion::STATIC;
+    } else if (name == "spin") {
+        motion = Motion::SPIN;
+    } else if (name == "orbit") {
+        motion = Motion::ORBIT;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,76 @@
+#ifndef UTILS_STRESS_SCENE_H
+#define UTILS_STRESS_SCENE_H
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "Eigen/Dense"
+
+#include "utils/tools.h"
+#include "utils/mesh_data.h"
+#include "utils/instance_table.h"
+#include "utils/thread_pool.h"
+
+namespace Utils {
+
+// A generated scene for scaling benchmarks: instances of synthetic meshes spread over a square,
+// moving or not, under a number of point lights. Everything comes from the seed and animate()
+// only depends on the time, so a run with the same options renders the same frames.
+class StressScene {
+public:
+    enum class Distribution {
+        UNIFORM,    // anywhere in the square
+        CLUSTERED,  // in clumps of about 500 instances
+        GRID,       // one per cell of a square grid
+    };
+
+    enum class Motion {
+        STATIC,
+        SPIN,       // about an axis of their own
+        ORBIT,      // spinning and circling around where they were placed
+    };
+
+    struct Options {
+        size_t instances = 10000;
+        size_t meshes = 4;
+        size_t triangles = 2000;    // per mesh
+        Distribution distribution = Distribution::UNIFORM;
+        Motion motion = Motion::ORBIT;
+        size_t lights = 1;
+        float extent = 50.0f;       // half the side of the square, centered at the origin in xz
+        uint32_t seed = 1;
+    };
+
+    struct Light {
+        vecf3 position;
+        vecf3 radiance;
+    };
+
+    explicit StressScene(const Options& options);
+
+    // writes the rotations and positions of time seconds, InstanceTable::update() comes after
+    void animate(ThreadPool& pool, float time);
+
+    // the lower case names of the enums
+    static bool parse(const std::string& name, Distribution& distribution);
+    static bool parse(const std::string& name, Motion& motion);
+
+    Options options;
+    // even ones are spheres, odd ones terrains; each instance's model is an index of meshes
+    std::vector<MeshData> meshes;
+    std::vector<vecf3> colors;
+    InstanceTable instances;
+    std::vector<Light> lights;
+
+private:
+    // the motion components of the instances
+    std::vector<float> home_x, home_z, orbits, phases;
+    std::vector<float> axis_x, axis_y, axis_z, spins, spin_speeds;
+};
+
+}
+
+#endif // UTILS_STRESS_SCENE_H
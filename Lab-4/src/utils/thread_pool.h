@@ -0,0 +1,53 @@
+#ifndef UTILS_THREAD_POOL_H
+#define UTILS_THREAD_POOL_H
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+
+namespace Utils {
+
+// A fixed set of workers for data parallel loops. run() hands out task indices through
+// an atomic counter, the calling thread works too and returns when every task is done.
+// Jobs are not queued, run() is meant to be called from one thread at a time.
+class ThreadPool {
+public:
+    using Task = std::function<void(size_t task, size_t worker)>;
+
+    // 0 means one thread per hardware thread, the caller counts as one of them
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const noexcept { return workers.size() + 1; }
+
+    void run(size_t task_count, const Task& task);
+
+private:
+    void work(size_t worker);
+    void drain(size_t worker);
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const Task *job = nullptr;
+    size_t job_size = 0;
+    uint64_t generation = 0;
+    size_t busy = 0;
+    bool stopping = false;
+    std::atomic<size_t> next{0};
+};
+
+}
+
+#endif // UTILS_THREAD_POOL_H
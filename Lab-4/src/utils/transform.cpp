@@ -1,5 +1,13 @@
 #include "transform.h"
 
+#include <cmath>
+#include <algorithm>
+#include <type_traits>
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
 namespace Utils::Transform {
 
 matf4 perspective(float fov_y, float aspect, float z_near, float z_far) noexcept {
@@ -108,4 +116,251 @@ matf4 generate_model_matrix(const vecf3& pos, const vecf3& scale, const matf4& r
 //    return m;
 //}
 
+namespace {
+
+// One register of instances for the batched transforms. The math is written once as templates over
+// float and Lanes, with the operators below; MSVC has no operators on the intrinsic types.
+#if defined(__AVX2__)
+constexpr size_t LANES = 8;
+using Quadrants = __m256i;
+struct Lanes {
+    __m256 v;
+    Lanes(__m256 v) : v(v) {}
+    Lanes(float f) : v(_mm256_set1_ps(f)) {}
+};
+inline Lanes operator+(Lanes a, Lanes b) { return _mm256_add_ps(a.v, b.v); }
+inline Lanes operator-(Lanes a, Lanes b) { return _mm256_sub_ps(a.v, b.v); }
+inline Lanes operator*(Lanes a, Lanes b) { return _mm256_mul_ps(a.v, b.v); }
+inline Lanes operator/(Lanes a, Lanes b) { return _mm256_div_ps(a.v, b.v); }
+inline Lanes load(const float *p) { return _mm256_loadu_ps(p); }
+inline void store(float *p, Lanes a) { _mm256_store_ps(p, a.v); }
+
+// x = q pi / 2 + r, with q rounded to nearest
+inline void split_quadrant(Lanes x, Lanes& r, __m256i& q) {
+    q = _mm256_cvtps_epi32(_mm256_mul_ps(x.v, _mm256_set1_ps(0.63661977236f)));
+    Lanes qf = _mm256_cvtepi32_ps(q);
+    // pi / 2 in three parts, the first two products are exact
+    r = x - qf * 1.5703125f - qf * 4.837512969970703125e-4f - qf * 7.54978995489188216e-8f;
+}
+inline __m256i add_quadrant(__m256i q, int n) { return _mm256_add_epi32(q, _mm256_set1_epi32(n)); }
+// sign bit set where bit 1 of q is
+inline Lanes flip_sign(Lanes a, __m256i q) {
+    auto sign = _mm256_slli_epi32(_mm256_and_si256(q, _mm256_set1_epi32(2)), 30);
+    return _mm256_xor_ps(a.v, _mm256_castsi256_ps(sign));
+}
+// a where q is odd, b where it is even
+inline Lanes select_odd(__m256i q, Lanes a, Lanes b) {
+    auto one = _mm256_set1_epi32(1);
+    auto odd = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(q, one), one));
+    return _mm256_blendv_ps(b.v, a.v, odd);
+}
+#elif defined(__SSE2__) || defined(_M_X64)
+constexpr size_t LANES = 4;
+using Quadrants = __m128i;
+struct Lanes {
+    __m128 v;
+    Lanes(__m128 v) : v(v) {}
+    Lanes(float f) : v(_mm_set1_ps(f)) {}
+};
+inline Lanes operator+(Lanes a, Lanes b) { return _mm_add_ps(a.v, b.v); }
+inline Lanes operator-(Lanes a, Lanes b) { return _mm_sub_ps(a.v, b.v); }
+inline Lanes operator*(Lanes a, Lanes b) { return _mm_mul_ps(a.v, b.v); }
+inline Lanes operator/(Lanes a, Lanes b) { return _mm_div_ps(a.v, b.v); }
+inline Lanes load(const float *p) { return _mm_loadu_ps(p); }
+inline void store(float *p, Lanes a) { _mm_store_ps(p, a.v); }
+
+inline void split_quadrant(Lanes x, Lanes& r, __m128i& q) {
+    q = _mm_cvtps_epi32(_mm_mul_ps(x.v, _mm_set1_ps(0.63661977236f)));
+    Lanes qf = _mm_cvtepi32_ps(q);
+    r = x - qf * 1.5703125f - qf * 4.837512969970703125e-4f - qf * 7.54978995489188216e-8f;
+}
+inline __m128i add_quadrant(__m128i q, int n) { return _mm_add_epi32(q, _mm_set1_epi32(n)); }
+inline Lanes flip_sign(Lanes a, __m128i q) {
+    auto sign = _mm_slli_epi32(_mm_and_si128(q, _mm_set1_epi32(2)), 30);
+    return _mm_xor_ps(a.v, _mm_castsi128_ps(sign));
+}
+inline Lanes select_odd(__m128i q, Lanes a, Lanes b) {
+    auto one = _mm_set1_epi32(1);
+    auto odd = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, one), one));
+    return _mm_or_ps(_mm_and_ps(odd, a.v), _mm_andnot_ps(odd, b.v));
+}
+#else
+constexpr size_t LANES = 0;
+#endif
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+// Both at once, as the minimax polynomials of Cephes on [-pi / 4, pi / 4] after the quadrant is
+// taken out; within 2 ulp of std::sin and std::cos for the angles of animations.
+inline void sincos(Lanes x, Lanes& s, Lanes& c) {
+    Lanes r = 0.0f;
+    Quadrants q;
+    split_quadrant(x, r, q);
+    Lanes z = r * r;
+    Lanes sin_r = r + r * z * (-1.6666654611e-1f + z * (8.3321608736e-3f + z * -1.9515295891e-4f));
+    Lanes cos_r = 1.0f - z * 0.5f + z * z * (4.166664568298827e-2f + z * (-1.388731625493765e-3f + z * 2.443315711809948e-5f));
+    // odd quadrants swap them, and each is negative in two of the four
+    s = flip_sign(select_odd(q, cos_r, sin_r), q);
+    c = flip_sign(select_odd(q, sin_r, cos_r), add_quadrant(q, 1));
+}
+#endif
+
+inline float load_one(const float *p) { return *p; }
+inline void sincos(float x, float& s, float& c) {
+    s = std::sin(x);
+    c = std::cos(x);
+}
+
+template<typename T>
+struct Rotation {
+    T m[3][3];
+};
+
+// the formula of rotate_with
+template<typename T>
+Rotation<T> axis_angle_rotation(T x, T y, T z, T angle) {
+    T s = 0.0f, c = 0.0f;
+    sincos(angle, s, c);
+    T t = 1.0f - c;
+    T xs = x * s, ys = y * s, zs = z * s;
+    T xt = x * t, yt = y * t, zt = z * t;
+    return {{
+        {c + x * xt, x * yt - zs, x * zt + ys},
+        {y * xt + zs, c + y * yt, y * zt - xs},
+        {z * xt - ys, z * yt + xs, c + z * zt},
+    }};
+}
+
+template<typename T>
+Rotation<T> quat_rotation(T x, T y, T z, T w) {
+    T x2 = x + x, y2 = y + y, z2 = z + z;
+    T xx = x * x2, xy = x * y2, xz = x * z2;
+    T yy = y * y2, yz = y * z2, zz = z * z2;
+    T wx = w * x2, wy = w * y2, wz = w * z2;
+    return {{
+        {1.0f - (yy + zz), xy - wz, xz + wy},
+        {xy + wz, 1.0f - (xx + zz), yz - wx},
+        {xz - wy, yz + wx, 1.0f - (xx + yy)},
+    }};
+}
+
+// M = T S R, so row i of R is scaled by scale i; the inverse transpose of S R is S^-1 R
+inline void write_matrices(const Rotation<float>& r, const float scale[3], const float pos[3], Affine *model, Affine *normal) {
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            model->rows(i, j) = r.m[i][j] * scale[i];
+        }
+        model->rows(i, 3) = pos[i];
+    }
+    if (normal != nullptr) {
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                normal->rows(i, j) = r.m[i][j] / scale[i];
+            }
+            normal->rows(i, 3) = 0.0f;
+        }
+    }
+}
+
+template<typename ROTATION>
+void model_matrices(size_t n, const Vec3Array& pos, const Vec3Array& scale, Affine *models, Affine *normals,
+                    ROTATION&& rotation) {
+    size_t i = 0;
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+    // the products are computed a register at a time, then spread into the rows of the transforms
+    alignas(32) float rows[9][LANES];
+    alignas(32) float inverse_rows[9][LANES];
+    for (; i + LANES <= n; i += LANES) {
+        Rotation<Lanes> r = rotation(i, load);
+        Lanes s[3] = {load(scale.x + i), load(scale.y + i), load(scale.z + i)};
+        for (int a = 0; a < 3; ++a) {
+            for (int b = 0; b < 3; ++b) {
+                store(rows[a * 3 + b], r.m[a][b] * s[a]);
+                if (normals != nullptr) {
+                    store(inverse_rows[a * 3 + b], r.m[a][b] / s[a]);
+                }
+            }
+        }
+        for (size_t l = 0; l < LANES; ++l) {
+            float *d = models[i + l].data();
+            d[0] = rows[0][l]; d[1] = rows[1][l]; d[2] = rows[2][l]; d[3] = pos.x[i + l];
+            d[4] = rows[3][l]; d[5] = rows[4][l]; d[6] = rows[5][l]; d[7] = pos.y[i + l];
+            d[8] = rows[6][l]; d[9] = rows[7][l]; d[10] = rows[8][l]; d[11] = pos.z[i + l];
+            if (normals != nullptr) {
+                float *nd = normals[i + l].data();
+                for (int a = 0; a < 3; ++a) {
+                    nd[a * 4] = inverse_rows[a * 3][l];
+                    nd[a * 4 + 1] = inverse_rows[a * 3 + 1][l];
+                    nd[a * 4 + 2] = inverse_rows[a * 3 + 2][l];
+                    nd[a * 4 + 3] = 0.0f;
+                }
+            }
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        Rotation<float> r = rotation(i, load_one);
+        float s[3] = {scale.x[i], scale.y[i], scale.z[i]};
+        float p[3] = {pos.x[i], pos.y[i], pos.z[i]};
+        write_matrices(r, s, p, models + i, normals != nullptr ? normals + i : nullptr);
+    }
+}
+
+template<typename T, typename LOAD>
+void transform(const Affine& m, size_t first, const Vec3Array& in, float *x, float *y, float *z, float w, LOAD&& load) {
+    T px = load(in.x + first), py = load(in.y + first), pz = load(in.z + first);
+    const auto& r = m.rows;
+    T rx = px * r(0, 0) + py * r(0, 1) + pz * r(0, 2) + r(0, 3) * w;
+    T ry = px * r(1, 0) + py * r(1, 1) + pz * r(1, 2) + r(1, 3) * w;
+    T rz = px * r(2, 0) + py * r(2, 1) + pz * r(2, 2) + r(2, 3) * w;
+    if constexpr (std::is_same_v<T, float>) {
+        x[first] = rx;
+        y[first] = ry;
+        z[first] = rz;
+    } else {
+        alignas(32) float out[3][LANES > 0 ? LANES : 1];
+        store(out[0], rx);
+        store(out[1], ry);
+        store(out[2], rz);
+        std::copy(out[0], out[0] + LANES, x + first);
+        std::copy(out[1], out[1] + LANES, y + first);
+        std::copy(out[2], out[2] + LANES, z + first);
+    }
+}
+
+void transform_all(const Affine& m, size_t n, const Vec3Array& in, float *x, float *y, float *z, float w) {
+    size_t i = 0;
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+    for (; i + LANES <= n; i += LANES) {
+        transform<Lanes>(m, i, in, x, y, z, w, [](const float *p) { return load(p); });
+    }
+#endif
+    for (; i < n; ++i) {
+        transform<float>(m, i, in, x, y, z, w, load_one);
+    }
+}
+
+} // namespace
+
+void generate_model_matrices(size_t n, const Vec3Array& pos, const Vec3Array& scale, const AxisAngleArray& rotation,
+                             Affine *models, Affine *normals) noexcept {
+    model_matrices(n, pos, scale, models, normals, [&](size_t i, auto&& load) {
+        return axis_angle_rotation(load(rotation.x + i), load(rotation.y + i), load(rotation.z + i), load(rotation.angle + i));
+    });
+}
+
+void generate_model_matrices(size_t n, const Vec3Array& pos, const Vec3Array& scale, const QuatArray& rotation,
+                             Affine *models, Affine *normals) noexcept {
+    model_matrices(n, pos, scale, models, normals, [&](size_t i, auto&& load) {
+        return quat_rotation(load(rotation.x + i), load(rotation.y + i), load(rotation.z + i), load(rotation.w + i));
+    });
+}
+
+void transform_points(const Affine& m, size_t n, const Vec3Array& in, float *x, float *y, float *z) noexcept {
+    transform_all(m, n, in, x, y, z, 1.0f);
+}
+
+void transform_vectors(const Affine& m, size_t n, const Vec3Array& in, float *x, float *y, float *z) noexcept {
+    transform_all(m, n, in, x, y, z, 0.0f);
+}
+
 } // namespace Utils::Transform
\ No newline at end of file
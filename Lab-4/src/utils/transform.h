@@ -6,6 +6,7 @@
 #include "Eigen/Dense"
 
 #include "utils/tools.h"
+#include "utils/affine.h"
 
 namespace Utils::Transform {
     
@@ -21,5 +22,35 @@ matf4 generate_model_matrix(const vecf3& pos, const vecf3& scale, const matf4& r
 
 //matf4 generate_model_matrix(const vecf3& pos, const vecf4& quat) noexcept;
 
+// Batched transforms over n instances in structure of arrays layout, one array per component.
+// Eight instances are computed at once when compiled with USE_AVX2, four with SSE2, and the
+// scalar code does the remainder and other targets.
+struct Vec3Array {
+    const float *x, *y, *z;
+};
+
+// unit axes, angles in radians
+struct AxisAngleArray {
+    const float *x, *y, *z, *angle;
+};
+
+// unit quaternions, w is the real part
+struct QuatArray {
+    const float *x, *y, *z, *w;
+};
+
+// The transforms of generate_model_matrix(pos, scale, rotate_with(angle, axis)), with the rotation from
+// a vectorized sincos. normals, when given, gets the normal matrix of each.
+void generate_model_matrices(size_t n, const Vec3Array& pos, const Vec3Array& scale, const AxisAngleArray& rotation,
+                             Affine *models, Affine *normals = nullptr) noexcept;
+
+void generate_model_matrices(size_t n, const Vec3Array& pos, const Vec3Array& scale, const QuatArray& rotation,
+                             Affine *models, Affine *normals = nullptr) noexcept;
+
+// m times n points or directions, the output arrays may be the input ones
+void transform_points(const Affine& m, size_t n, const Vec3Array& in, float *x, float *y, float *z) noexcept;
+
+void transform_vectors(const Affine& m, size_t n, const Vec3Array& in, float *x, float *y, float *z) noexcept;
+
 }
 #endif // UTILS_TRANSFORM_H
\ No newline at end of file